@@ -50,6 +50,8 @@ __FBSDID("$FreeBSD$");
 
 struct private_data {
 	int		 compression_level;
+	int		 threads;
+	int		 long_distance;
 #if HAVE_ZSTD_H && HAVE_LIBZSTD
 	ZSTD_CStream	*cstream;
 	int64_t		 total_in;
@@ -68,6 +70,7 @@ struct private_data {
 
 #define MINVER_NEGCLEVEL 10304
 #define MINVER_MINCLEVEL 10306
+#define MINVER_ADVANCED_API 10400
 
 static int archive_compressor_zstd_options(struct archive_write_filter *,
 		    const char *, const char *);
@@ -204,6 +207,21 @@ archive_compressor_zstd_options(struct archive_write_filter *f, const char *key,
 		}
 		data->compression_level = level;
 		return (ARCHIVE_OK);
+	} else if (strcmp(key, "threads") == 0) {
+		int threads;
+		if (string_is_numeric(value) != ARCHIVE_OK) {
+			return (ARCHIVE_WARN);
+		}
+		threads = atoi(value);
+		if (threads < 0) {
+			return (ARCHIVE_WARN);
+		}
+		data->threads = threads;
+		return (ARCHIVE_OK);
+	} else if (strcmp(key, "long") == 0) {
+		/* Long distance matching, "long" enables and "!long" disables */
+		data->long_distance = (value != NULL);
+		return (ARCHIVE_OK);
 	}
 
 	/* Note: The "warn" return is just to inform the options
@@ -252,6 +270,21 @@ archive_compressor_zstd_open(struct archive_write_filter *f)
 		return (ARCHIVE_FATAL);
 	}
 
+#if ZSTD_VERSION_NUMBER >= MINVER_ADVANCED_API
+	/* Workers are only available if zstd was built multithreaded,
+	 * fall back to single threaded compression otherwise. */
+	if (data->threads > 0)
+		ZSTD_CCtx_setParameter(data->cstream, ZSTD_c_nbWorkers,
+		    data->threads);
+	if (data->long_distance &&
+	    ZSTD_isError(ZSTD_CCtx_setParameter(data->cstream,
+	    ZSTD_c_enableLongDistanceMatching, 1))) {
+		archive_set_error(f->archive, ARCHIVE_ERRNO_MISC,
+		    "Internal error enabling zstd long distance matching");
+		return (ARCHIVE_FATAL);
+	}
+#endif
+
 	return (ARCHIVE_OK);
 }
 
@@ -804,8 +804,11 @@ int QInstallerTools::createBinary(BinaryCreatorArgs args, QString &argumentError
             // 2.2; copy the packages data and setup the packages vector with the files we copied,
             //    must happen before copying meta data because files will be compressed if
             //    needed and meta data generation relies on this
-            copyComponentData(args.packagesDirectories, tmpRepoDir, &preparedPackages,
-                args.archiveSuffix, args.compression);
+            RepositoryOptions options;
+            options.archiveSuffix = args.archiveSuffix;
+            options.compression = args.compression;
+            options.jobs = args.jobs;
+            copyComponentData(args.packagesDirectories, tmpRepoDir, &preparedPackages, options);
             // 2.3; add to common vector
             packages.append(preparedPackages);
         }
@@ -0,0 +1,241 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "buildcache.h"
+
+#include "errors.h"
+#include "fileio.h"
+#include "fileutils.h"
+#include "utils.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+using namespace QInstaller;
+using namespace QInstallerTools;
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstallerTools::BuildCache
+    \internal
+    \brief The BuildCache class keeps the files created for a component across repogen runs.
+
+    Entries are stored in a directory per key, named after the key. A key is a hash of the
+    input of a build step and the settings used for it, calculated with treeKey() or
+    contentKey(). If the input did not change, restore() copies the files created by an
+    earlier run instead of creating them again.
+
+    Storing an entry is atomic, several jobs and processes can share one cache directory.
+*/
+
+/*!
+    \class QInstallerTools::BuildCache::Entry
+    \internal
+    \brief The Entry struct holds the files of a cache entry and the SHA-1 checksum
+    of the component content.
+*/
+
+static const QLatin1String scIndexFile("index");
+
+/*
+    Returns the paths of all entries below \a path, relative to it and sorted, so the
+    order does not depend on the file system.
+*/
+static QStringList sortedEntries(const QString &path)
+{
+    QStringList entries;
+    const QDir dir(path);
+    QDirIterator it(path, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(dir.relativeFilePath(it.next()));
+    entries.sort();
+    return entries;
+}
+
+/*!
+    Constructs a cache stored in \a directory. The cache is disabled if \a directory is empty.
+*/
+BuildCache::BuildCache(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+/*!
+    Returns \c true if a cache directory was set.
+*/
+bool BuildCache::isEnabled() const
+{
+    return !m_directory.isEmpty();
+}
+
+/*!
+    Returns the directory the cache is stored in.
+*/
+QString BuildCache::directory() const
+{
+    return m_directory;
+}
+
+/*!
+    Returns a key for the file trees at \a paths and the build \a settings. Only the names,
+    sizes and modification times of the files are hashed, so calculating the key does not
+    read the data.
+*/
+QByteArray BuildCache::treeKey(const QStringList &paths, const QByteArray &settings)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(settings);
+    foreach (const QString &path, paths) {
+        hash.addData("\0", 1);
+        if (!QFileInfo::exists(path))
+            continue;
+        foreach (const QString &entry, sortedEntries(path)) {
+            const QFileInfo info(path + QLatin1Char('/') + entry);
+            hash.addData(entry.toUtf8());
+            hash.addData(QByteArray::number(info.isDir() ? -1 : info.size()));
+            hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+            if (info.isSymLink())
+                hash.addData(info.symLinkTarget().toUtf8());
+            hash.addData("\n", 1);
+        }
+    }
+    return hash.result().toHex();
+}
+
+/*!
+    Returns a key for the file tree at \a path and the build \a settings. The content of
+    the files is hashed, which suits small trees like the meta data of a component.
+    Throws QInstaller::Error if a file cannot be read.
+*/
+QByteArray BuildCache::contentKey(const QString &path, const QByteArray &settings)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(settings);
+    foreach (const QString &entry, sortedEntries(path)) {
+        const QString filePath = path + QLatin1Char('/') + entry;
+        hash.addData(entry.toUtf8());
+        hash.addData("\n", 1);
+        if (QFileInfo(filePath).isDir())
+            continue;
+        QFile file(filePath);
+        openForRead(&file);
+        hash.addData(calculateHash(&file, QCryptographicHash::Sha1));
+    }
+    return hash.result().toHex();
+}
+
+/*!
+    Copies the files stored for \a key to \a targetDir and sets \a entry, with the files
+    pointing to the copies. Returns \c false if the cache has no entry for \a key or
+    the entry cannot be restored.
+*/
+bool BuildCache::restore(const QByteArray &key, const QString &targetDir, Entry *entry) const
+{
+    if (!isEnabled())
+        return false;
+
+    const QString entryDir = m_directory + QLatin1Char('/') + QString::fromLatin1(key);
+    QFile index(entryDir + QLatin1Char('/') + scIndexFile);
+    if (!index.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    Entry result;
+    try {
+        QTextStream stream(&index);
+        stream.setCodec("UTF-8");
+        while (!stream.atEnd()) {
+            const QString line = stream.readLine();
+            if (line.startsWith(QLatin1String("contentSha1="))) {
+                result.contentSha1 = line.mid(12);
+            } else if (line.startsWith(QLatin1String("file="))) {
+                const QString name = line.mid(5);
+                const QString target = targetDir + QLatin1Char('/') + name;
+                // replaces the files of an earlier run in the same repository
+                copyFile(entryDir + QLatin1Char('/') + name, target, nullptr, OverwriteFile);
+                result.files.append(target);
+            }
+        }
+    } catch (const Error &e) {
+        qDebug() << "Cannot restore cache entry" << key << ":" << e.message();
+        foreach (const QString &file, result.files)
+            QFile::remove(file);
+        return false;
+    }
+    *entry = result;
+    return true;
+}
+
+/*!
+    Stores the files and content checksum of \a entry for \a key. An existing entry for
+    \a key is kept. Failures are logged only, as the files can still be created again.
+*/
+void BuildCache::store(const QByteArray &key, const Entry &entry) const
+{
+    if (!isEnabled())
+        return;
+
+    const QString entryDir = m_directory + QLatin1Char('/') + QString::fromLatin1(key);
+    if (QFileInfo::exists(entryDir))
+        return;
+
+    try {
+        mkpath(m_directory);
+        QTemporaryDir tmp(entryDir + QLatin1String(".XXXXXX"));
+        if (!tmp.isValid()) {
+            throw Error(QString::fromLatin1("Cannot create directory \"%1\".")
+                .arg(QDir::toNativeSeparators(tmp.path())));
+        }
+
+        QFile index(tmp.path() + QLatin1Char('/') + scIndexFile);
+        openForWrite(&index);
+        QTextStream stream(&index);
+        stream.setCodec("UTF-8");
+        stream << "contentSha1=" << entry.contentSha1 << '\n';
+        foreach (const QString &file, entry.files) {
+            const QString name = QFileInfo(file).fileName();
+            copyFile(file, tmp.path() + QLatin1Char('/') + name);
+            stream << "file=" << name << '\n';
+        }
+        stream.flush();
+        index.close();
+
+        // another job might have stored the same entry in the meantime, keep that one
+        if (QDir().rename(tmp.path(), entryDir))
+            tmp.setAutoRemove(false);
+    } catch (const Error &e) {
+        qDebug() << "Cannot store cache entry" << key << ":" << e.message();
+    }
+}
@@ -0,0 +1,66 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef BUILDCACHE_H
+#define BUILDCACHE_H
+
+#include "ifwtools_global.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace QInstallerTools {
+
+class IFWTOOLS_EXPORT BuildCache
+{
+public:
+    struct Entry
+    {
+        QStringList files;
+        QString contentSha1;
+    };
+
+    explicit BuildCache(const QString &directory = QString());
+
+    bool isEnabled() const;
+    QString directory() const;
+
+    static QByteArray treeKey(const QStringList &paths, const QByteArray &settings);
+    static QByteArray contentKey(const QString &path, const QByteArray &settings);
+
+    bool restore(const QByteArray &key, const QString &targetDir, Entry *entry) const;
+    void store(const QByteArray &key, const Entry &entry) const;
+
+private:
+    QString m_directory;
+};
+
+} // namespace QInstallerTools
+
+#endif // BUILDCACHE_H
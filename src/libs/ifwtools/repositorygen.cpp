@@ -28,7 +28,10 @@
 
 #include "repositorygen.h"
 
+#include "binarydelta.h"
+#include "buildcache.h"
 #include "constants.h"
+#include "contentchunks.h"
 #include "fileio.h"
 #include "fileutils.h"
 #include "errors.h"
@@ -43,6 +46,13 @@
 
 #include <QtCore/QDirIterator>
 #include <QtCore/QRegExp>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+#include <QtCore/QXmlStreamReader>
+
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
 #include <QtXml/QDomDocument>
 #include <QTemporaryDir>
@@ -88,18 +98,100 @@ void QInstallerTools::copyWithException(const QString &source, const QString &ta
     if (!targetFileInfo.dir().exists())
         QInstaller::mkpath(targetFileInfo.absolutePath());
 
-    QFile sourceFile(source);
-    if (!sourceFile.copy(target)) {
+    try {
+        if (targetFileInfo.exists())
+            throw QInstaller::Error(QLatin1String("Target already exist."));
+        QInstaller::copyFile(source, target);
+    } catch (const QInstaller::Error &e) {
         qDebug() << "failed!\n";
         throw QInstaller::Error(QString::fromLatin1("Cannot copy the %1 file from \"%2\" to \"%3\": "
             "%4").arg(kind, QDir::toNativeSeparators(source), QDir::toNativeSeparators(target),
-            /* in case of an existing target the error String does not show the file */
-            (targetFileInfo.exists() ? QLatin1String("Target already exist.") : sourceFile.errorString())));
+            e.message()));
     }
 
     qDebug() << "done.";
 }
 
+/*
+    Returns the unified meta data archives listed in the Updates.xml element \a root: the
+    MetadataName archive followed by the further chunks created with repogen
+    --metadata-chunk-size and the patches appended by repogen --append-metadata, in order.
+    Each archive is mapped to the components a later archive supersedes, whose meta data
+    must not be taken from it.
+*/
+static QList<QPair<QString, QStringList> > unifiedMetadataArchives(const QDomElement &root)
+{
+    QList<QPair<QString, QStringList> > archives;
+    const QDomElement metadataName = root.firstChildElement(QLatin1String("MetadataName"));
+    if (metadataName.isNull())
+        return archives;
+
+    archives.append(qMakePair(metadataName.text(), QStringList()));
+    for (QDomElement archive = root.firstChildElement(); !archive.isNull();
+            archive = archive.nextSiblingElement()) {
+        if (archive.tagName() != QLatin1String("MetadataChunk")
+                && archive.tagName() != QLatin1String("MetadataPatch")) {
+            continue;
+        }
+        const QStringList components = archive.firstChildElement(QLatin1String("Components")).text()
+            .split(QLatin1Char(','), QString::SkipEmptyParts);
+        for (int i = 0; i < archives.count(); ++i)
+            archives[i].second.append(components);
+        archives.append(qMakePair(archive.firstChildElement(scName).text(), QStringList()));
+    }
+    return archives;
+}
+
+/*
+    Extracts the meta data archive \a path to \a targetDir, except for the directories of
+    the \a skippedComponents.
+*/
+static void extractMetadataArchive(const QString &path, const QString &targetDir,
+    const QStringList &skippedComponents = QStringList())
+{
+    QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(path));
+    if (!archive) {
+        throw QInstaller::Error(QString::fromLatin1("Could not create handler "
+            "object for archive \"%1\": \"%2\".").arg(path, QLatin1String(Q_FUNC_INFO)));
+    }
+    if (!archive->open(QIODevice::ReadOnly)) {
+        throw Error(QString::fromLatin1("Could not extract archive \"%1\": %2").arg(
+            QDir::toNativeSeparators(path), archive->errorString()));
+    }
+
+    QStringList entries;
+    if (!skippedComponents.isEmpty()) {
+        const QSet<QString> skipped = skippedComponents.toSet();
+        QSet<QString> components;
+        foreach (const ArchiveEntry &entry, archive->list())
+            components.insert(QDir::fromNativeSeparators(entry.path).section(QLatin1Char('/'), 0, 0));
+        entries = components.subtract(skipped).values();
+        if (entries.isEmpty())
+            return;
+    }
+    if (!(entries.isEmpty() ? archive->extract(targetDir) : archive->extract(targetDir, entries))) {
+        throw Error(QString::fromLatin1("Could not extract archive \"%1\": %2").arg(
+            QDir::toNativeSeparators(path), archive->errorString()));
+    }
+}
+
+/*
+    Extracts the unified meta data archives listed in \a root, the Updates.xml element of the
+    repository in \a repositoryDir, to \a targetDir. Returns the paths of the archives.
+*/
+static QStringList extractUnifiedMetadata(const QDomElement &root, const QString &repositoryDir,
+    const QString &targetDir)
+{
+    QStringList paths;
+    typedef QPair<QString, QStringList> Archive;
+    foreach (const Archive &archive, unifiedMetadataArchives(root)) {
+        const QString path = QFileInfo(repositoryDir, archive.first).absoluteFilePath();
+        extractMetadataArchive(path, targetDir, archive.second);
+        paths.append(path);
+    }
+    return paths;
+}
+
 static QStringList copyFilesFromNode(const QString &parentNode, const QString &childNode, const QString &attr,
     const QString &kind, const QDomNode &package, const PackageInfo &info, const QString &targetDir)
 {
@@ -130,7 +222,7 @@ static QStringList copyFilesFromNode(const QString &parentNode, const QString &c
 
 void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &metaDataDir,
     const PackageInfoVector &packages, const QString &appName, const QString &appVersion,
-    const QStringList &uniteMetadatas)
+    const QStringList &uniteMetadatas, QCryptographicHash::Algorithm checksumAlgorithm)
 {
     const QString targetDir = makePathAbsolute(_targetDir);
     if (!QFile::exists(targetDir))
@@ -141,6 +233,19 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
     QFile existingUpdatesXml(QFileInfo(metaDataDir, QLatin1String("Updates.xml")).absoluteFilePath());
     if (existingUpdatesXml.open(QIODevice::ReadOnly) && doc.setContent(&existingUpdatesXml)) {
         root = doc.documentElement();
+        // hashes of different algorithms cannot be mixed inside one repository
+        QCryptographicHash::Algorithm existingAlgorithm = QCryptographicHash::Sha1;
+        const QDomElement checksumType = root.firstChildElement(scChecksumType);
+        if (!checksumType.isNull()
+                && !QInstaller::checksumAlgorithmFromName(checksumType.text(), &existingAlgorithm)) {
+            throw QInstaller::Error(QString::fromLatin1("Unsupported checksum type \"%1\" in \"%2\".")
+                .arg(checksumType.text(), QDir::toNativeSeparators(existingUpdatesXml.fileName())));
+        }
+        if (existingAlgorithm != checksumAlgorithm) {
+            throw QInstaller::Error(QString::fromLatin1("Cannot update repository \"%1\" using %2 "
+                "checksums, it was created with %3 checksums.").arg(QDir::toNativeSeparators(metaDataDir),
+                QInstaller::checksumName(checksumAlgorithm), QInstaller::checksumName(existingAlgorithm)));
+        }
         // remove entry for this component from existing Updates.xml, if found
         foreach (const PackageInfo &info, packages) {
             const QDomNodeList packageNodes = root.childNodes();
@@ -162,6 +267,10 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
             .createTextNode(appVersion));
         root.appendChild(doc.createElement(QLatin1String("Checksum"))).appendChild(doc
             .createTextNode(QLatin1String("true")));
+        if (checksumAlgorithm != QCryptographicHash::Sha1) {
+            root.appendChild(doc.createElement(scChecksumType)).appendChild(doc
+                .createTextNode(QInstaller::checksumName(checksumAlgorithm)));
+        }
     }
 
     foreach (const PackageInfo &info, packages) {
@@ -335,7 +444,8 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
             if (!foundDownloadableArchives && !info.copiedFiles.isEmpty()) {
                 QStringList realContentFiles;
                 foreach (const QString &filePath, info.copiedFiles) {
-                    if (!filePath.endsWith(QLatin1String(".sha1"), Qt::CaseInsensitive)) {
+                    if (!filePath.endsWith(QLatin1String(".sha1"), Qt::CaseInsensitive)
+                            && !filePath.endsWith(QLatin1String(".sha256"), Qt::CaseInsensitive)) {
                         const QString fileName = QFileInfo(filePath).fileName();
                         // remove unnecessary version string from filename and add it to the list
                         realContentFiles.append(fileName.mid(info.version.count()));
@@ -346,6 +456,17 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
                                                                                                          .createTextNode(realContentFiles.join(QChar::fromLatin1(','))));
             }
 
+            if (!info.chunkManifests.isEmpty()) {
+                update.appendChild(doc.createElement(scChunkManifests)).appendChild(doc
+                    .createTextNode(info.chunkManifests.join(QLatin1Char(','))));
+            }
+            if (!info.deltaPatches.isEmpty()) {
+                update.appendChild(doc.createElement(scDeltaPatches)).appendChild(doc
+                    .createTextNode(info.deltaPatches.join(QLatin1Char(','))));
+                update.appendChild(doc.createElement(scDeltaPatchFrom)).appendChild(doc
+                    .createTextNode(info.deltaPatchFrom));
+            }
+
             // copy user interfaces
             const QStringList uiFiles = copyFilesFromNode(QLatin1String("UserInterfaces"),
                                                           QLatin1String("UserInterface"), QString(), QLatin1String("user interface"), package, info,
@@ -406,22 +527,43 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
                 throw QInstaller::Error(QString::fromLatin1("Cannot restore \"PackageUpdate\" description for node %1").arg(info.name));
             }
 
-            root.appendChild(update.documentElement());
+            QDomElement updateElement = update.documentElement();
+            if (!info.chunkManifests.isEmpty() && updateElement.firstChildElement(scChunkManifests).isNull()) {
+                updateElement.appendChild(update.createElement(scChunkManifests)).appendChild(update
+                    .createTextNode(info.chunkManifests.join(QLatin1Char(','))));
+            }
+            // patches are created against the replaced version, drop the ones against older versions
+            updateElement.removeChild(updateElement.firstChildElement(scDeltaPatches));
+            updateElement.removeChild(updateElement.firstChildElement(scDeltaPatchFrom));
+            if (!info.deltaPatches.isEmpty()) {
+                updateElement.appendChild(update.createElement(scDeltaPatches)).appendChild(update
+                    .createTextNode(info.deltaPatches.join(QLatin1Char(','))));
+                updateElement.appendChild(update.createElement(scDeltaPatchFrom)).appendChild(update
+                    .createTextNode(info.deltaPatchFrom));
+            }
+            root.appendChild(updateElement);
         }
     }
 
     // Packages can be in repositories using different meta formats,
-    // always extract unified meta if given as argument.
+    // always extract unified meta if given as argument. Patches of the
+    // unified meta are extracted together with the archive they patch.
+    QStringList extractedMetadatas;
     foreach (const QString uniteMetadata, uniteMetadatas) {
         const QString metaFilePath = QFileInfo(metaDataDir, uniteMetadata).absoluteFilePath();
-        QScopedPointer<AbstractArchive> metaFile(ArchiveFactory::instance().create(metaFilePath));
-        if (!metaFile) {
-            throw QInstaller::Error(QString::fromLatin1("Could not create handler "
-                "object for archive \"%1\": \"%2\".").arg(metaFilePath, QLatin1String(Q_FUNC_INFO)));
+        if (extractedMetadatas.contains(metaFilePath))
+            continue;
+
+        const QString repositoryDir = QFileInfo(metaFilePath).absolutePath();
+        QFile repositoryUpdatesXml(repositoryDir + QLatin1String("/Updates.xml"));
+        QDomDocument repositoryDoc;
+        if (repositoryUpdatesXml.open(QIODevice::ReadOnly) && repositoryDoc.setContent(&repositoryUpdatesXml)) {
+            extractedMetadatas.append(extractUnifiedMetadata(repositoryDoc.documentElement(),
+                repositoryDir, targetDir));
         }
-        if (!(metaFile->open(QIODevice::ReadOnly) && metaFile->extract(targetDir))) {
-            throw Error(QString::fromLatin1("Could not extract archive \"%1\": %2").arg(
-                QDir::toNativeSeparators(metaFilePath), metaFile->errorString()));
+        if (!extractedMetadatas.contains(metaFilePath)) {
+            extractMetadataArchive(metaFilePath, targetDir);
+            extractedMetadatas.append(metaFilePath);
         }
     }
 
@@ -432,6 +574,68 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
     QInstaller::blockingWrite(&targetUpdatesXml, doc.toByteArray());
 }
 
+/*
+    The elements of a meta/package.xml file needed to list the package.
+*/
+struct PackageDescription
+{
+    PackageDescription() : exists(false), errorLine(0), errorColumn(0) {}
+
+    bool exists;
+    QString error;
+    qint64 errorLine;
+    qint64 errorColumn;
+    QString name;
+    QString version;
+    QString releaseDate;
+    QString dependencies;
+};
+
+/*
+    Reads the package description of the package in \a directory with a stream reader,
+    keeping only the elements createListOfPackages() needs. Called in parallel for all
+    packages, so errors are returned instead of thrown.
+*/
+static PackageDescription readPackageDescription(const QFileInfo &directory)
+{
+    PackageDescription description;
+    QFile file(QString::fromLatin1("%1/meta/package.xml").arg(directory.filePath()));
+    description.exists = file.exists();
+    if (!description.exists)
+        return description;
+
+    file.open(QIODevice::ReadOnly);
+    QXmlStreamReader reader(&file);
+    reader.setNamespaceProcessing(false);
+    if (reader.readNextStartElement() && reader.name() == QLatin1String("Package")) {
+        while (reader.readNextStartElement()) {
+            QString *value = nullptr;
+            if (reader.name() == QLatin1String("Name"))
+                value = &description.name;
+            else if (reader.name() == QLatin1String("Version"))
+                value = &description.version;
+            else if (reader.name() == QLatin1String("ReleaseDate"))
+                value = &description.releaseDate;
+            else if (reader.name() == QLatin1String("Dependencies"))
+                value = &description.dependencies;
+
+            if (value && value->isNull())
+                *value = reader.readElementText(QXmlStreamReader::IncludeChildElements);
+            else
+                reader.skipCurrentElement();
+        }
+    }
+    // read the rest of the file, so that malformed descriptions are still rejected
+    while (!reader.atEnd())
+        reader.readNext();
+    if (reader.hasError()) {
+        description.error = reader.errorString();
+        description.errorLine = reader.lineNumber();
+        description.errorColumn = reader.columnNumber();
+    }
+    return description;
+}
+
 PackageInfoVector QInstallerTools::createListOfPackages(const QStringList &packagesDirectories,
     QStringList *packagesToFilter, FilterType filterType, QStringList packagesUpdatedWithSha)
 {
@@ -443,6 +647,7 @@ PackageInfoVector QInstallerTools::createListOfPackages(const QStringList &packa
     QFileInfoList entries;
     foreach (const QString &packagesDirectory, packagesDirectories)
         entries.append(QDir(packagesDirectory).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot));
+    QFileInfoList packageDirectories;
     for (QFileInfoList::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
         if (filterType == Exclude) {
             // Check for current file in exclude list, if found, skip it and remove it from exclude list
@@ -464,40 +669,43 @@ PackageInfoVector QInstallerTools::createListOfPackages(const QStringList &packa
                 "even if you do not specify a version.",
                 qUtf8Printable(it->fileName()));
         }
+        packageDirectories.append(*it);
+    }
 
-        QFile file(QString::fromLatin1("%1/meta/package.xml").arg(it->filePath()));
-        QFileInfo fileInfo(file);
-        if (!fileInfo.exists()) {
+    // Parse the package descriptions in parallel, but check them in the order of the
+    // directories, so that messages and errors do not depend on the thread scheduling.
+    const QVector<PackageDescription> descriptions = QtConcurrent::blockingMapped<
+        QVector<PackageDescription> >(packageDirectories, readPackageDescription);
+
+    for (int i = 0; i < packageDirectories.count(); ++i) {
+        const QFileInfo &directory = packageDirectories.at(i);
+        const PackageDescription &description = descriptions.at(i);
+        const QFileInfo fileInfo(QString::fromLatin1("%1/meta/package.xml").arg(directory.filePath()));
+        if (!description.exists) {
             if (ignoreInvalidPackages)
                 continue;
             throw QInstaller::Error(QString::fromLatin1("Component \"%1\" does not contain a package "
-                "description (meta/package.xml is missing).").arg(QDir::toNativeSeparators(it->fileName())));
+                "description (meta/package.xml is missing).").arg(QDir::toNativeSeparators(directory.fileName())));
         }
 
-        file.open(QIODevice::ReadOnly);
-
-        QDomDocument doc;
-        QString error;
-        int errorLine = 0;
-        int errorColumn = 0;
-        if (!doc.setContent(&file, &error, &errorLine, &errorColumn)) {
+        if (!description.error.isEmpty()) {
             if (ignoreInvalidPackages)
                 continue;
             throw QInstaller::Error(QString::fromLatin1("Component package description in \"%1\" is invalid. "
                 "Error at line: %2, column: %3 -> %4").arg(QDir::toNativeSeparators(fileInfo.absoluteFilePath()),
-                                                           QString::number(errorLine),
-                                                           QString::number(errorColumn), error));
+                                                           QString::number(description.errorLine),
+                                                           QString::number(description.errorColumn),
+                                                           description.error));
         }
 
-        const QDomElement packageElement = doc.firstChildElement(QLatin1String("Package"));
-        const QString name = packageElement.firstChildElement(QLatin1String("Name")).text();
-        if (!name.isEmpty() && name != it->fileName()) {
+        const QString name = description.name;
+        if (!name.isEmpty() && name != directory.fileName()) {
             qWarning().nospace() << "The <Name> tag in the file " << fileInfo.absoluteFilePath()
                        << " is ignored - the installer uses the path element right before the 'meta'"
-                       << " (" << it->fileName() << ")";
+                       << " (" << directory.fileName() << ")";
         }
 
-        QString releaseDate = packageElement.firstChildElement(QLatin1String("ReleaseDate")).text();
+        QString releaseDate = description.releaseDate;
         if (releaseDate.isEmpty()) {
             qWarning("Release date for \"%s\" is empty! Using the current date instead.",
                 qPrintable(fileInfo.absoluteFilePath()));
@@ -513,8 +721,8 @@ PackageInfoVector QInstallerTools::createListOfPackages(const QStringList &packa
         }
 
         PackageInfo info;
-        info.name = it->fileName();
-        info.version = packageElement.firstChildElement(QLatin1String("Version")).text();
+        info.name = directory.fileName();
+        info.version = description.version;
         // Version cannot start with comparison characters, be an empty string
         // or have whitespaces at the beginning or at the end
         if (!QRegExp(QLatin1String("(?![<=>\\s]+)(.+)")).exactMatch(info.version) ||
@@ -524,9 +732,9 @@ PackageInfoVector QInstallerTools::createListOfPackages(const QStringList &packa
             throw QInstaller::Error(QString::fromLatin1("Component version for \"%1\" is invalid! <Version>%2</Version>")
                 .arg(QDir::toNativeSeparators(fileInfo.absoluteFilePath()), info.version));
         }
-        info.dependencies = packageElement.firstChildElement(QLatin1String("Dependencies")).text()
-            .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
-        info.directory = it->filePath();
+        info.dependencies = description.dependencies.split(QInstaller::commaRegExp(),
+            QString::SkipEmptyParts);
+        info.directory = directory.filePath();
         if (packagesUpdatedWithSha.contains(info.name)) {
             info.createContentSha1Node = true;
             packagesUpdatedWithSha.removeOne(info.name);
@@ -563,6 +771,9 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
     bool ignoreInvalidRepositories = qApp->arguments().contains(QString::fromLatin1("--ignore-invalid-repositories"));
 
     PackageInfoVector dict;
+    // index of each package name in dict, and the packages replaced by a newer version
+    QHash<QString, int> packageIndexes;
+    QVector<bool> replacedPackages;
     QFileInfoList entries;
     foreach (const QString &repositoryDirectory, repositoryDirectories)
         entries.append(QFileInfo(repositoryDirectory));
@@ -602,11 +813,12 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
         }
 
         bool hasUnifiedMetaFile = false;
-        const QDomElement unifiedSha1 = root.firstChildElement(scSHA1);
+        const bool hasUnifiedChecksum = !root.firstChildElement(scSHA1).isNull()
+            || !root.firstChildElement(scSHA256).isNull();
         const QDomElement unifiedMetaName = root.firstChildElement(QLatin1String("MetadataName"));
 
         // Unified metadata takes priority over component metadata
-        if (!unifiedSha1.isNull() && !unifiedMetaName.isNull())
+        if (hasUnifiedChecksum && !unifiedMetaName.isNull())
             hasUnifiedMetaFile = true;
 
         const QDomNodeList children = root.childNodes();
@@ -638,8 +850,8 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
 
                 info.directory = QString::fromLatin1("%1/%2").arg(it->filePath(), info.name);
                 if (!hasUnifiedMetaFile) {
-                    const QDomElement sha1 = el.firstChildElement(QInstaller::scSHA1);
-                    if (!sha1.isNull()) {
+                    if (!el.firstChildElement(QInstaller::scSHA1).isNull()
+                            || !el.firstChildElement(QInstaller::scSHA256).isNull()) {
                         // 1. First, try with normal repository structure
                         QString metaFile = QString::fromLatin1("%1/%3%2").arg(info.directory,
                             QString::fromLatin1("meta.7z"), info.version);
@@ -670,8 +882,10 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
                         foreach (const QString &name, names) {
                             info.copiedFiles.append(QString::fromLatin1("%1/%3%2").arg(info.directory,
                                 name, info.version));
-                            info.copiedFiles.append(QString::fromLatin1("%1/%3%2.sha1").arg(info.directory,
-                                name, info.version));
+                            const QString archive = QString::fromLatin1("%1/%3%2").arg(info.directory,
+                                name, info.version);
+                            info.copiedFiles.append(QFileInfo::exists(archive + QLatin1String(".sha256"))
+                                ? archive + QLatin1String(".sha256") : archive + QLatin1String(".sha1"));
                         }
                     }
                 }
@@ -685,25 +899,23 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
                 bool pushToDict = true;
                 bool replacement = false;
                 // Check whether this package already exists in vector:
-                for (int i = 0; i < dict.size(); ++i) {
-                    const QInstallerTools::PackageInfo oldInfo = dict.at(i);
-                    if (oldInfo.name != info.name)
-                        continue;
-
-                    if (KDUpdater::compareVersion(info.version, oldInfo.version) > 0) {
+                const QHash<QString, int>::const_iterator existing = packageIndexes.constFind(info.name);
+                if (existing != packageIndexes.constEnd()) {
+                    if (KDUpdater::compareVersion(info.version, dict.at(existing.value()).version) > 0) {
                         // A package with newer version, it will replace the existing one.
-                        dict.remove(i);
+                        replacedPackages[existing.value()] = true;
                         replacement = true;
                     } else {
                         // A package with older or same version, do not add it again.
                         pushToDict = false;
                     }
-                    break;
                 }
 
                 if (pushToDict) {
                     replacement ? qDebug() << "- it provides a new version of the package" << info.name << " - " << info.version << "- replaced"
                                 : qDebug() << "- it provides the package" << info.name << " - " << info.version;
+                    packageIndexes.insert(info.name, dict.count());
+                    replacedPackages.append(false);
                     dict.push_back(info);
                 } else {
                     qDebug() << "- it provides an old version of the package" << info.name << " - " << info.version << "- ignored";
@@ -712,6 +924,13 @@ PackageInfoVector QInstallerTools::createListOfRepositoryPackages(const QStringL
         }
     }
 
+    // drop the replaced packages in one pass, keeping the order of the others
+    int count = 0;
+    for (int i = 0; i < dict.count(); ++i) {
+        if (!replacedPackages.at(i))
+            dict[count++] = dict.at(i);
+    }
+    dict.resize(count);
     return dict;
 }
 
@@ -723,43 +942,68 @@ QHash<QString, QString> QInstallerTools::buildPathToVersionMapping(const Package
     return map;
 }
 
-static void writeSHA1ToNodeWithName(QDomDocument &doc, QDomNodeList &list, const QByteArray &sha1sum,
-    const QString &nodename = QString())
+/*
+    Returns the \a algorithm checksum of the archive at \a path from the \a checksums
+    calculated while creating it, or reads the archive if it was not created here.
+    Throws QInstaller::Error if the archive cannot be read.
+*/
+static QByteArray archiveChecksum(const QString &path, QCryptographicHash::Algorithm algorithm,
+    const ArchiveChecksums &checksums)
+{
+    const QByteArray checksum = checksums.value(algorithm);
+    if (!checksum.isEmpty())
+        return checksum;
+
+    QFile archive(path);
+    QInstaller::openForRead(&archive);
+    return QInstaller::calculateHash(&archive, algorithm);
+}
+
+static void writeChecksumToNodeWithName(QDomDocument &doc, QDomNodeList &list, const QByteArray &checksum,
+    QCryptographicHash::Algorithm algorithm, const QString &nodename = QString())
 {
+    const QString tagName = QInstaller::checksumName(algorithm);
+    const QString staleTagName = algorithm == QCryptographicHash::Sha1 ? scSHA256 : scSHA1;
+    const QString sumName = tagName.toLower() + QLatin1String("sum");
     if (nodename.isEmpty())
-        qDebug() << "Writing sha1sum node.";
+        qDebug() << qPrintable(QString::fromLatin1("Writing %1 node.").arg(sumName));
     else
-        qDebug() << "Searching sha1sum node for" << nodename;
-    QString sha1Value = QString::fromLatin1(sha1sum.toHex().constData());
+        qDebug() << qPrintable(QString::fromLatin1("Searching %1 node for").arg(sumName)) << nodename;
+    QString checksumValue = QString::fromLatin1(checksum.toHex().constData());
     for (int i = 0; i < list.size(); ++i) {
         QDomNode curNode = list.at(i);
         QDomNode nameTag = curNode.firstChildElement(scName);
         if ((!nameTag.isNull() && nameTag.toElement().text() == nodename) || nodename.isEmpty()) {
-            QDomNode sha1Node = curNode.firstChildElement(scSHA1);
-            QDomNode newSha1Node = doc.createElement(scSHA1);
-            newSha1Node.appendChild(doc.createTextNode(sha1Value));
-
-            if (!sha1Node.isNull() && sha1Node.hasChildNodes()) {
-                QDomNode sha1NodeChild = sha1Node.firstChild();
-                QString sha1OldValue = sha1NodeChild.nodeValue();
-                if (sha1Value == sha1OldValue) {
-                    qDebug() << "- keeping the existing sha1sum" << sha1OldValue;
+            QDomNode staleNode = curNode.firstChildElement(staleTagName);
+            if (!staleNode.isNull())
+                curNode.removeChild(staleNode);
+
+            QDomNode checksumNode = curNode.firstChildElement(tagName);
+            QDomNode newChecksumNode = doc.createElement(tagName);
+            newChecksumNode.appendChild(doc.createTextNode(checksumValue));
+
+            if (!checksumNode.isNull() && checksumNode.hasChildNodes()) {
+                QDomNode checksumNodeChild = checksumNode.firstChild();
+                QString checksumOldValue = checksumNodeChild.nodeValue();
+                if (checksumValue == checksumOldValue) {
+                    qDebug() << "- keeping the existing" << qPrintable(sumName) << checksumOldValue;
                     continue;
                 } else {
-                    qDebug() << "- clearing the old sha1sum" << sha1OldValue;
-                    sha1Node.removeChild(sha1NodeChild);
+                    qDebug() << "- clearing the old" << qPrintable(sumName) << checksumOldValue;
+                    checksumNode.removeChild(checksumNodeChild);
                 }
             }
-            if (sha1Node.isNull())
-                curNode.appendChild(newSha1Node);
+            if (checksumNode.isNull())
+                curNode.appendChild(newChecksumNode);
             else
-                curNode.replaceChild(newSha1Node, sha1Node);
-            qDebug() << "- writing the sha1sum" << sha1Value;
+                curNode.replaceChild(newChecksumNode, checksumNode);
+            qDebug() << "- writing the" << qPrintable(sumName) << checksumValue;
         }
     }
 }
 
-void QInstallerTools::createArchive(const QString &filename, const QStringList &data, Compression compression)
+void QInstallerTools::createArchive(const QString &filename, const QStringList &data, Compression compression,
+    int compressionThreads, qint64 solidBlockSize, ArchiveChecksums *checksums)
 {
     QScopedPointer<AbstractArchive> targetArchive(ArchiveFactory::instance().create(filename));
     if (!targetArchive) {
@@ -767,14 +1011,30 @@ void QInstallerTools::createArchive(const QString &filename, const QStringList &
             "object for archive \"%1\": \"%2\".").arg(filename, QLatin1String(Q_FUNC_INFO)));
     }
     targetArchive->setCompressionLevel(compression);
+    targetArchive->setCompressionThreads(compressionThreads);
+    targetArchive->setSolidBlockSize(solidBlockSize);
+    if (checksums)
+        targetArchive->setCreatedChecksumAlgorithms(checksums->keys());
     if (!(targetArchive->open(QIODevice::WriteOnly) && targetArchive->create(data))) {
         throw Error(QString::fromLatin1("Could not create archive \"%1\": %2").arg(
             QDir::toNativeSeparators(filename), targetArchive->errorString()));
     }
+    targetArchive->close();
+    if (!checksums)
+        return;
+
+    for (auto it = checksums->begin(); it != checksums->end(); ++it) {
+        it.value() = targetArchive->createdChecksum(it.key());
+        if (it.value().isEmpty()) { // not calculated by the archive format
+            QFile archive(filename);
+            QInstaller::openForRead(&archive);
+            it.value() = QInstaller::calculateHash(&archive, it.key());
+        }
+    }
 }
 
 void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QString &existingUnite7zUrl,
-    const QHash<QString, QString> &versionMapping, bool createSplitMetadata, bool createUnifiedMetadata)
+    const QHash<QString, QString> &versionMapping, const RepositoryOptions &options)
 {
     QDomDocument doc;
     // use existing Updates.xml, if any
@@ -788,12 +1048,11 @@ void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QStr
     const QStringList entryList = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
 
     QStringList absPaths;
-    if (createUnifiedMetadata) {
-        absPaths = unifyMetadata(repoDir, existingUnite7zUrl, doc);
-    }
+    if (options.createUnifiedMetadata)
+        absPaths = unifyMetadata(repoDir, existingUnite7zUrl, doc, options);
 
-    if (createSplitMetadata) {
-        splitMetadata(entryList, repoDir, doc, versionMapping);
+    if (options.createComponentMetadata) {
+        splitMetadata(entryList, repoDir, doc, versionMapping, options);
     } else {
         // remove the files that got compressed
         foreach (const QString path, absPaths)
@@ -805,8 +1064,96 @@ void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QStr
     existingUpdatesXml.close();
 }
 
-QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString &existingRepoDir, QDomDocument doc)
+/*
+    Creates the \a archive containing the meta data of the \a components, found at
+    \a absPaths, and returns the \a tagName element listing it in \a doc.
+*/
+static QDomElement createMetadataArchive(QDomDocument doc, const QString &tagName,
+    const QString &archive, const QStringList &components, const QStringList &absPaths,
+    QCryptographicHash::Algorithm checksumAlgorithm)
+{
+    ArchiveChecksums checksums;
+    checksums.insert(checksumAlgorithm, QByteArray());
+    createArchive(archive, absPaths, Compression::Normal, 0, 0, &checksums);
+
+    QDomElement element = doc.createElement(tagName);
+    element.appendChild(doc.createElement(scName))
+        .appendChild(doc.createTextNode(QFileInfo(archive).fileName()));
+    element.appendChild(doc.createElement(QLatin1String("Components")))
+        .appendChild(doc.createTextNode(components.join(QLatin1Char(','))));
+    element.appendChild(doc.createElement(QInstaller::checksumName(checksumAlgorithm)))
+        .appendChild(doc.createTextNode(QString::fromLatin1(checksums.value(checksumAlgorithm).toHex())));
+    return element;
+}
+
+/*
+    Stores the meta data of the \a components, found at \a absPaths, in a new patch archive
+    for the unified meta data archive \a existingArchive instead of recreating it, and lists
+    the patch as MetadataPatch element in \a doc. The unified archive, its chunks and the
+    earlier patches that still provide meta data are copied to \a repoDir unchanged, so clients and caches
+    can keep their copies. Returns \c false without creating a patch if the patches would
+    contain more than half of the components of the repository.
+*/
+static bool appendMetadataPatch(const QString &repoDir, const QString &existingArchive,
+    QDomDocument doc, const QStringList &components, const QStringList &absPaths,
+    QCryptographicHash::Algorithm checksumAlgorithm)
+{
+    QDomElement root = doc.documentElement();
+    const int packageCount = root.elementsByTagName(QLatin1String("PackageUpdate")).count();
+
+    QStringList patchedComponents = components;
+    QList<QDomElement> patches;
+    QList<QDomElement> supersededPatches;
+    for (QDomElement patch = root.firstChildElement(QLatin1String("MetadataPatch")); !patch.isNull();
+            patch = patch.nextSiblingElement(QLatin1String("MetadataPatch"))) {
+        bool superseded = true;
+        foreach (const QString &component, patch.firstChildElement(QLatin1String("Components")).text()
+                .split(QLatin1Char(','), QString::SkipEmptyParts)) {
+            if (components.contains(component))
+                continue;
+            superseded = false;
+            if (!patchedComponents.contains(component))
+                patchedComponents.append(component);
+        }
+        if (superseded)
+            supersededPatches.append(patch);
+        else
+            patches.append(patch);
+    }
+    if (patchedComponents.count() * 2 > packageCount) {
+        qDebug() << "Meta data patches would contain" << patchedComponents.count() << "of"
+            << packageCount << "components, recreating the unified meta data.";
+        return false;
+    }
+    foreach (const QDomElement &patch, supersededPatches)
+        root.removeChild(patch);
+
+    const QString existingDir = QFileInfo(existingArchive).absolutePath();
+    QStringList archives;
+    typedef QPair<QString, QStringList> Archive;
+    foreach (const Archive &archive, unifiedMetadataArchives(root))
+        archives.append(archive.first);
+    foreach (const QString &archive, archives) {
+        qDebug() << "Keeping the unified meta data archive" << archive;
+        QInstaller::copyFile(existingDir + QLatin1Char('/') + archive, repoDir + QLatin1Char('/') + archive);
+    }
+
+    const QString prefix = QDateTime::currentDateTime().toString(QLatin1String("yyyy-MM-dd-hhmm"));
+    QString patchName;
+    for (int i = patches.count() + 1; patchName.isEmpty() || archives.contains(patchName); ++i)
+        patchName = QString::fromLatin1("%1_patch%2_meta.7z").arg(prefix).arg(i);
+
+    qDebug() << "Appending the meta data of" << components << "as" << patchName;
+    root.appendChild(createMetadataArchive(doc, QLatin1String("MetadataPatch"),
+        repoDir + QLatin1Char('/') + patchName, components, absPaths, checksumAlgorithm));
+    return true;
+}
+
+QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString &existingRepoDir, QDomDocument doc,
+    const RepositoryOptions &options)
 {
+    const QCryptographicHash::Algorithm checksumAlgorithm = options.checksumAlgorithm;
+    const qint64 chunkSize = options.metadataChunkSize;
     QStringList absPaths;
     QDir dir(repoDir);
     const QStringList entryList = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
@@ -818,18 +1165,35 @@ QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString
         dir.cdUp();
     }
 
+    if (options.appendUnifiedMetadata && !existingRepoDir.isEmpty() && !entryList.isEmpty()
+            && appendMetadataPatch(repoDir, existingRepoDir, doc, entryList, absPaths, checksumAlgorithm)) {
+        return absPaths;
+    }
+
+    // the recreated unified meta data replaces all chunks and patches
+    QDomElement root = doc.documentElement();
+    QDomElement archive = root.firstChildElement();
+    while (!archive.isNull()) {
+        const QDomElement next = archive.nextSiblingElement();
+        if (archive.tagName() == QLatin1String("MetadataChunk")
+                || archive.tagName() == QLatin1String("MetadataPatch")) {
+            root.removeChild(archive);
+        }
+        archive = next;
+    }
+
     QTemporaryDir existingRepoTempDir;
     QString existingRepoTemp = existingRepoTempDir.path();
     if (!existingRepoDir.isEmpty()) {
         existingRepoTempDir.setAutoRemove(false);
-        QScopedPointer<AbstractArchive> archiveFile(ArchiveFactory::instance().create(existingRepoDir));
-        if (!archiveFile) {
-            throw QInstaller::Error(QString::fromLatin1("Could not create handler "
-                "object for archive \"%1\": \"%2\".").arg(existingRepoDir, QLatin1String(Q_FUNC_INFO)));
-        }
-        if (!(archiveFile->open(QIODevice::ReadOnly) && archiveFile->extract(existingRepoTemp))) {
-            throw Error(QString::fromLatin1("Could not extract archive \"%1\": %2").arg(
-                QDir::toNativeSeparators(existingRepoDir), archiveFile->errorString()));
+        QDomDocument existingDoc;
+        QFile existingUpdatesXml(QFileInfo(existingRepoDir).absolutePath() + QLatin1String("/Updates.xml"));
+        if (existingUpdatesXml.open(QIODevice::ReadOnly) && existingDoc.setContent(&existingUpdatesXml)
+                && !unifiedMetadataArchives(existingDoc.documentElement()).isEmpty()) {
+            extractUnifiedMetadata(existingDoc.documentElement(), QFileInfo(existingRepoDir).absolutePath(),
+                existingRepoTemp);
+        } else {
+            extractMetadataArchive(existingRepoDir, existingRepoTemp);
         }
         QDir dir2(existingRepoTemp);
         QStringList existingRepoEntries = dir2.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
@@ -845,17 +1209,56 @@ QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString
         }
     }
 
-    // Compress all metadata from repository to one single 7z
-    const QString metadataFilename = QDateTime::currentDateTime().
-            toString(QLatin1String("yyyy-MM-dd-hhmm")) + QLatin1String("_meta.7z");
+    // Split the metadata into chunks of about chunkSize bytes, sorted by component name so
+    // that related components end up in the same chunk. Without a chunk size all metadata
+    // from repository is compressed to one single 7z.
+    QMap<QString, QString> sortedPaths;
+    foreach (const QString &absPath, absPaths)
+        sortedPaths.insert(QFileInfo(absPath).fileName(), absPath);
+    QList<QStringList> chunks;
+    QList<QStringList> chunkComponents;
+    qint64 currentChunkSize = 0;
+    for (auto it = sortedPaths.constBegin(); it != sortedPaths.constEnd(); ++it) {
+        qint64 size = 0;
+        if (chunkSize > 0) {
+            QDirIterator files(it.value(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+            while (files.hasNext()) {
+                files.next();
+                size += files.fileInfo().size();
+            }
+        }
+        if (chunks.isEmpty() || (chunkSize > 0 && currentChunkSize > 0
+                && currentChunkSize + size > chunkSize)) {
+            chunks.append(QStringList());
+            chunkComponents.append(QStringList());
+            currentChunkSize = 0;
+        }
+        chunks.last().append(it.value());
+        chunkComponents.last().append(it.key());
+        currentChunkSize += size;
+    }
+    if (chunks.isEmpty())
+        chunks.append(QStringList());
+
+    const QString prefix = QDateTime::currentDateTime().toString(QLatin1String("yyyy-MM-dd-hhmm"));
+    for (int i = 1; i < chunks.count(); ++i) {
+        const QString chunkName = QString::fromLatin1("%1_chunk%2_meta.7z").arg(prefix).arg(i);
+        qDebug() << "Creating meta data chunk" << chunkName << "for" << chunkComponents.at(i).count()
+            << "components";
+        root.appendChild(createMetadataArchive(doc, QLatin1String("MetadataChunk"),
+            repoDir + QLatin1Char('/') + chunkName, chunkComponents.at(i), chunks.at(i),
+            checksumAlgorithm));
+    }
+
+    const QString metadataFilename = prefix + QLatin1String("_meta.7z");
     const QString tmpTarget = repoDir + QDir::separator() + metadataFilename;
-    createArchive(tmpTarget, absPaths);
+    ArchiveChecksums checksums;
+    checksums.insert(checksumAlgorithm, QByteArray());
+    createArchive(tmpTarget, chunks.first(), Compression::Normal, 0, 0, &checksums);
 
-    QFile tmp(tmpTarget);
-    tmp.open(QFile::ReadOnly);
-    const QByteArray sha1Sum = QInstaller::calculateHash(&tmp, QCryptographicHash::Sha1);
+    const QByteArray checksum = checksums.value(checksumAlgorithm);
     QDomNodeList elements =  doc.elementsByTagName(QLatin1String("Updates"));
-    writeSHA1ToNodeWithName(doc, elements, sha1Sum, QString());
+    writeChecksumToNodeWithName(doc, elements, checksum, checksumAlgorithm, QString());
 
     qDebug() << "Updating the metadata node with name " << metadataFilename;
     if (elements.count() > 0) {
@@ -875,8 +1278,11 @@ QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString
 }
 
 void QInstallerTools::splitMetadata(const QStringList &entryList, const QString &repoDir,
-                                    QDomDocument doc, const QHash<QString, QString> &versionMapping)
+                                    QDomDocument doc, const QHash<QString, QString> &versionMapping,
+                                    const RepositoryOptions &options)
 {
+    const QCryptographicHash::Algorithm checksumAlgorithm = options.checksumAlgorithm;
+    const BuildCache cache(options.cacheDirectory);
     QStringList absPaths;
     QDomNodeList elements =  doc.elementsByTagName(QLatin1String("PackageUpdate"));
     QDir dir(repoDir);
@@ -890,14 +1296,25 @@ void QInstallerTools::splitMetadata(const QStringList &entryList, const QString
         const QString fn = QLatin1String(versionPrefix.toLatin1() + "meta.7z");
         const QString tmpTarget = repoDir + QLatin1String("/") + fn;
 
-        createArchive(tmpTarget, QStringList() << absPath);
+        QByteArray key;
+        BuildCache::Entry entry;
+        ArchiveChecksums checksums;
+        if (cache.isEnabled())
+            key = BuildCache::contentKey(absPath, QString::fromLatin1("meta\n%1\n%2").arg(path, fn).toUtf8());
+        if (cache.isEnabled() && cache.restore(key, repoDir, &entry)) {
+            qDebug() << "Reusing cached meta data archive for" << path;
+        } else {
+            checksums.insert(checksumAlgorithm, QByteArray());
+            createArchive(tmpTarget, QStringList() << absPath, Compression::Normal, 0, 0, &checksums);
+            entry.files = QStringList(tmpTarget);
+            cache.store(key, entry);
+        }
 
         // remove the files that got compressed
         QInstaller::removeFiles(absPath, true);
+        const QByteArray checksum = archiveChecksum(tmpTarget, checksumAlgorithm, checksums);
+        writeChecksumToNodeWithName(doc, elements, checksum, checksumAlgorithm, path);
         QFile tmp(tmpTarget);
-        tmp.open(QFile::ReadOnly);
-        const QByteArray sha1Sum = QInstaller::calculateHash(&tmp, QCryptographicHash::Sha1);
-        writeSHA1ToNodeWithName(doc, elements, sha1Sum, path);
         const QString finalTarget = absPath + QLatin1String("/") + fn;
         if (!tmp.rename(finalTarget)) {
             throw QInstaller::Error(QString::fromLatin1("Cannot move file \"%1\" to \"%2\".").arg(
@@ -907,101 +1324,438 @@ void QInstallerTools::splitMetadata(const QStringList &entryList, const QString
     }
 }
 
-void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
-    PackageInfoVector *const infos, const QString &archiveSuffix, Compression compression)
+/*
+    Copies or compresses the data of the component \a info from \a packageDirs to its
+    directory in \a repoDir with the archive settings of \a options, and hashes the created
+    archives. Only touches \a info, so several components can be packaged at the same time.
+    If the data did not change since it was stored in \a cache, the files of the earlier
+    run are reused.
+*/
+static void copyDataOfComponent(const QStringList &packageDirs, const QString &repoDir,
+    PackageInfo *info, const RepositoryOptions &options, const BuildCache &cache)
 {
-    for (int i = 0; i < infos->count(); ++i) {
-        const PackageInfo info = infos->at(i);
-        const QString name = info.name;
-        qDebug() << "Copying component data for" << name;
-
-        const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
-        if (!QDir().mkpath(namedRepoDir)) {
-            throw QInstaller::Error(QString::fromLatin1("Cannot create repository directory for component \"%1\".")
-                .arg(name));
+    const QString &archiveSuffix = options.archiveSuffix;
+    const Compression compression = options.compression;
+    const int compressionThreads = options.compressionThreads;
+    const qint64 solidBlockSize = options.solidBlockSize;
+    const QCryptographicHash::Algorithm checksumAlgorithm = options.checksumAlgorithm;
+
+    const QString name = info->name;
+    qDebug() << "Copying component data for" << name;
+
+    const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
+    if (!QDir().mkpath(namedRepoDir)) {
+        throw QInstaller::Error(QString::fromLatin1("Cannot create repository directory for component \"%1\".")
+            .arg(name));
+    }
+
+    if (info->copiedFiles.isEmpty()) {
+        QByteArray key;
+        if (cache.isEnabled()) {
+            QStringList dataDirs;
+            foreach (const QString &packageDir, packageDirs)
+                dataDirs.append(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
+            // everything that ends up in the file names or content of the created files
+            const QByteArray settings = QString::fromLatin1("data\n%1\n%2\n%3\n%4\n%5\n%6\n%7")
+                .arg(name, info->version, archiveSuffix).arg(int(compression)).arg(solidBlockSize)
+                .arg(QInstaller::checksumName(checksumAlgorithm))
+                .arg(int(info->createContentSha1Node)).toUtf8();
+            key = BuildCache::treeKey(dataDirs, settings);
+
+            BuildCache::Entry entry;
+            if (cache.restore(key, namedRepoDir, &entry)) {
+                qDebug() << "Reusing cached component data for" << name;
+                info->copiedFiles = entry.files;
+                if (info->createContentSha1Node)
+                    info->contentSha1 = entry.contentSha1;
+                return;
+            }
         }
 
-        if (info.copiedFiles.isEmpty()) {
-            QStringList compressedFiles;
-            QStringList filesToCompress;
-            foreach (const QString &packageDir, packageDirs) {
-                const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
-                foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
-                    QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
-                    if (fileInfo.isFile() && !fileInfo.isSymLink()) {
-                        const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
-                        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance()
-                            .create(absoluteEntryFilePath));
-                        if (archive && archive->open(QIODevice::ReadOnly) && archive->isSupported()) {
-                            QFile tmp(absoluteEntryFilePath);
-                            QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info.version);
-                            qDebug() << "Copying archive from" << tmp.fileName() << "to" << target;
-                            if (!tmp.copy(target)) {
-                                throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
-                                    .arg(QDir::toNativeSeparators(tmp.fileName()), QDir::toNativeSeparators(target), tmp.errorString()));
-                            }
-                            compressedFiles.append(target);
-                        } else {
-                            filesToCompress.append(absoluteEntryFilePath);
-                        }
-                    } else if (fileInfo.isDir()) {
-                        qDebug() << "Compressing data directory" << entry;
-                        QString target = QString::fromLatin1("%1/%3%2.%4").arg(namedRepoDir, entry, info.version, archiveSuffix);
-                        createArchive(target, QStringList() << dataDir.absoluteFilePath(entry), compression);
+        // the checksums of archives created here are calculated while writing them
+        ArchiveChecksums checksumsToCreate;
+        checksumsToCreate.insert(checksumAlgorithm, QByteArray());
+        if (info->createContentSha1Node)
+            checksumsToCreate.insert(QCryptographicHash::Sha1, QByteArray());
+        QHash<QString, ArchiveChecksums> createdChecksums;
+
+        QStringList compressedFiles;
+        QStringList filesToCompress;
+        foreach (const QString &packageDir, packageDirs) {
+            const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
+            foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
+                QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
+                if (fileInfo.isFile() && !fileInfo.isSymLink()) {
+                    const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
+                    QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance()
+                        .create(absoluteEntryFilePath));
+                    if (archive && archive->open(QIODevice::ReadOnly) && archive->isSupported()) {
+                        QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info->version);
+                        qDebug() << "Copying archive from" << absoluteEntryFilePath << "to" << target;
+                        QInstaller::copyFile(absoluteEntryFilePath, target);
                         compressedFiles.append(target);
-                    } else if (fileInfo.isSymLink()) {
-                        filesToCompress.append(dataDir.absoluteFilePath(entry));
+                    } else {
+                        filesToCompress.append(absoluteEntryFilePath);
                     }
+                } else if (fileInfo.isDir()) {
+                    qDebug() << "Compressing data directory" << entry;
+                    QString target = QString::fromLatin1("%1/%3%2.%4").arg(namedRepoDir, entry, info->version, archiveSuffix);
+                    ArchiveChecksums checksums = checksumsToCreate;
+                    createArchive(target, QStringList() << dataDir.absoluteFilePath(entry), compression,
+                        compressionThreads, solidBlockSize, &checksums);
+                    createdChecksums.insert(target, checksums);
+                    compressedFiles.append(target);
+                } else if (fileInfo.isSymLink()) {
+                    filesToCompress.append(dataDir.absoluteFilePath(entry));
                 }
             }
+        }
 
-            if (!filesToCompress.isEmpty()) {
-                qDebug() << "Compressing files found in data directory:" << filesToCompress;
-                QString target = QString::fromLatin1("%1/%2content.%3").arg(namedRepoDir, info.version, archiveSuffix);
-                createArchive(target, filesToCompress, compression);
-                compressedFiles.append(target);
-            }
+        if (!filesToCompress.isEmpty()) {
+            qDebug() << "Compressing files found in data directory:" << filesToCompress;
+            QString target = QString::fromLatin1("%1/%2content.%3").arg(namedRepoDir, info->version, archiveSuffix);
+            ArchiveChecksums checksums = checksumsToCreate;
+            createArchive(target, filesToCompress, compression, compressionThreads, solidBlockSize,
+                &checksums);
+            createdChecksums.insert(target, checksums);
+            compressedFiles.append(target);
+        }
 
-            foreach (const QString &target, compressedFiles) {
-                (*infos)[i].copiedFiles.append(target);
+        foreach (const QString &target, compressedFiles) {
+            info->copiedFiles.append(target);
+
+            QFile archiveHashFile(target + QLatin1Char('.')
+                + QInstaller::checksumName(checksumAlgorithm).toLower());
+
+            qDebug() << "Hash is stored in" << archiveHashFile.fileName();
+            qDebug() << "Creating hash of archive" << target;
+
+            try {
+                const ArchiveChecksums checksums = createdChecksums.value(target);
+                const QByteArray hashOfArchiveData = archiveChecksum(target, checksumAlgorithm,
+                    checksums).toHex();
+
+                QInstaller::openForWrite(&archiveHashFile);
+                archiveHashFile.write(hashOfArchiveData);
+                qDebug() << "Generated" << qPrintable(QInstaller::checksumName(checksumAlgorithm)
+                    .toLower()) << "hash:" << hashOfArchiveData;
+                info->copiedFiles.append(archiveHashFile.fileName());
+                if (info->createContentSha1Node) {
+                    // the content hash is always SHA-1, installers compare it verbatim
+                    info->contentSha1 = QLatin1String(checksumAlgorithm == QCryptographicHash::Sha1
+                        ? hashOfArchiveData
+                        : archiveChecksum(target, QCryptographicHash::Sha1, checksums).toHex());
+                }
+                archiveHashFile.close();
+            } catch (const QInstaller::Error &/*e*/) {
+                archiveHashFile.close();
+                throw;
+            }
+        }
 
-                QFile archiveFile(target);
-                QFile archiveHashFile(archiveFile.fileName() + QLatin1String(".sha1"));
+        BuildCache::Entry entry;
+        entry.files = info->copiedFiles;
+        entry.contentSha1 = info->contentSha1;
+        cache.store(key, entry);
+    } else {
+        foreach (const QString &file, info->copiedFiles) {
+            QFileInfo fromInfo(file);
+            QString target = QString::fromLatin1("%1/%2").arg(namedRepoDir, fromInfo.fileName());
+            qDebug() << "Copying file from" << file << "to" << target;
+            QInstaller::copyFile(file, target);
+        }
+    }
+}
 
-                qDebug() << "Hash is stored in" << archiveHashFile.fileName();
-                qDebug() << "Creating hash of archive" << archiveFile.fileName();
+void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
+    PackageInfoVector *const infos, const RepositoryOptions &options)
+{
+    const BuildCache cache(options.cacheDirectory);
+    int jobs = options.jobs;
+    if (jobs <= 0)
+        jobs = QThread::idealThreadCount();
+    jobs = qMin(jobs, infos->count());
+    if (jobs < 2) {
+        for (int i = 0; i < infos->count(); ++i)
+            copyDataOfComponent(packageDirs, repoDir, &(*infos)[i], options, cache);
+        return;
+    }
 
+    // share the cores between the jobs, unless the number of threads was given explicitly
+    RepositoryOptions jobOptions = options;
+    if (jobOptions.compressionThreads <= 0)
+        jobOptions.compressionThreads = qMax(1, QThread::idealThreadCount() / jobs);
+
+    // detach once up front, the jobs write to their own elements only
+    PackageInfo *const packages = infos->data();
+    const int count = infos->count();
+    QVector<QString> errors(count);
+    QAtomicInt nextPackage;
+    QAtomicInt failed;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+    for (int job = 0; job < jobs; ++job) {
+        QtConcurrent::run(&pool, [&]() {
+            for (int i = nextPackage.fetchAndAddOrdered(1); i < count && !failed.loadAcquire();
+                    i = nextPackage.fetchAndAddOrdered(1)) {
                 try {
-                    QInstaller::openForRead(&archiveFile);
-                    const QByteArray hashOfArchiveData = QInstaller::calculateHash(&archiveFile,
-                        QCryptographicHash::Sha1).toHex();
-                    archiveFile.close();
-
-                    QInstaller::openForWrite(&archiveHashFile);
-                    archiveHashFile.write(hashOfArchiveData);
-                    qDebug() << "Generated sha1 hash:" << hashOfArchiveData;
-                    (*infos)[i].copiedFiles.append(archiveHashFile.fileName());
-                    if ((*infos)[i].createContentSha1Node)
-                        (*infos)[i].contentSha1 = QLatin1String(hashOfArchiveData);
-                    archiveHashFile.close();
-                } catch (const QInstaller::Error &/*e*/) {
-                    archiveFile.close();
-                    archiveHashFile.close();
-                    throw;
+                    copyDataOfComponent(packageDirs, repoDir, &packages[i], jobOptions, cache);
+                } catch (const QInstaller::Error &e) {
+                    errors[i] = e.message();
+                    failed.storeRelease(1);
                 }
             }
-        } else {
-            foreach (const QString &file, (*infos)[i].copiedFiles) {
-                QFileInfo fromInfo(file);
-                QFile from(file);
-                QString target = QString::fromLatin1("%1/%2").arg(namedRepoDir, fromInfo.fileName());
-                qDebug() << "Copying file from" << from.fileName() << "to" << target;
-                if (!from.copy(target)) {
-                    throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
-                        .arg(QDir::toNativeSeparators(from.fileName()), QDir::toNativeSeparators(target), from.errorString()));
+        });
+    }
+    pool.waitForDone();
+
+    // report the error of the first failed component, independent of the job order
+    foreach (const QString &error, errors) {
+        if (!error.isEmpty())
+            throw QInstaller::Error(error);
+    }
+}
+
+/*
+    Extracts \a archive to \a targetDir and returns the sorted paths of its entries in
+    \a paths, so that the same content results in the same output. Returns \c false if
+    \a archive is not an archive or contains entries the maintenance tool cannot rebuild,
+    like symbolic links.
+*/
+static bool extractRebuildableArchive(const QString &archive, const QString &targetDir,
+    QStringList *paths)
+{
+    QScopedPointer<AbstractArchive> archiveFile(ArchiveFactory::instance().create(archive));
+    if (!archiveFile || !archiveFile->open(QIODevice::ReadOnly) || !archiveFile->isSupported())
+        return false;
+
+    if (!archiveFile->extract(targetDir)) {
+        throw QInstaller::Error(QString::fromLatin1("Could not extract archive \"%1\": %2").arg(
+            QDir::toNativeSeparators(archive), archiveFile->errorString()));
+    }
+    archiveFile->close();
+
+    paths->clear();
+    QDirIterator it(targetDir, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+        | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QFileInfo fileInfo(it.next());
+        if (fileInfo.isSymLink() || !(fileInfo.isDir() || fileInfo.isFile())) {
+            qDebug() << "Cannot rebuild" << archive << "from its content, unsupported entry"
+                << QDir(targetDir).relativeFilePath(fileInfo.filePath());
+            return false;
+        }
+        paths->append(fileInfo.filePath());
+    }
+    paths->sort();
+    return true;
+}
+
+/*
+    Creates the chunk manifest of \a archive next to it and stores the chunks of its content
+    that are not there yet in \a repoDir. Returns \c false without creating a manifest if
+    \a archive cannot be rebuilt from chunks.
+*/
+static bool createChunkManifest(const QString &repoDir, const QString &archive)
+{
+    QTemporaryDir content;
+    QStringList paths;
+    if (!extractRebuildableArchive(archive, content.path(), &paths))
+        return false;
+
+    const QDir contentDir(content.path());
+    ChunkManifest manifest;
+    foreach (const QString &path, paths) {
+        const QFileInfo fileInfo(path);
+        ChunkManifest::Entry entry;
+        entry.path = contentDir.relativeFilePath(path);
+        entry.isDirectory = fileInfo.isDir();
+        entry.permissions = fileInfo.permissions();
+        if (!entry.isDirectory) {
+            QFile file(path);
+            QInstaller::openForRead(&file);
+            entry.size = file.size();
+            entry.chunks = ContentChunker::chunk(&file, &entry.hash);
+            foreach (const ContentChunk &chunk, entry.chunks) {
+                const QString chunkFile = repoDir + QLatin1Char('/') + ContentChunker::chunkPath(chunk.hash);
+                if (QFileInfo::exists(chunkFile))
+                    continue;
+
+                file.seek(chunk.offset);
+                const QByteArray data = file.read(chunk.size);
+                QInstaller::mkpath(QFileInfo(chunkFile).absolutePath());
+                QSaveFile chunkOut(chunkFile);
+                if (!chunkOut.open(QIODevice::WriteOnly) || chunkOut.write(qCompress(data)) < 0
+                        || !chunkOut.commit()) {
+                    throw QInstaller::Error(QString::fromLatin1("Cannot write chunk \"%1\": %2").arg(
+                        QDir::toNativeSeparators(chunkFile), chunkOut.errorString()));
                 }
             }
         }
+        manifest.addEntry(entry);
+    }
+
+    QFile manifestFile(archive + QLatin1String(".chunks"));
+    QInstaller::openForWrite(&manifestFile);
+    manifest.write(&manifestFile);
+    return true;
+}
+
+void QInstallerTools::createChunkManifests(const QString &repoDir, PackageInfoVector *const infos)
+{
+    for (int i = 0; i < infos->count(); ++i) {
+        PackageInfo &info = (*infos)[i];
+        info.chunkManifests.clear();
+        foreach (const QString &file, info.copiedFiles) {
+            if (file.endsWith(QLatin1String(".sha1"), Qt::CaseInsensitive)
+                    || file.endsWith(QLatin1String(".sha256"), Qt::CaseInsensitive)) {
+                continue;
+            }
+            const QString fileName = QFileInfo(file).fileName();
+            const QString archive = QString::fromLatin1("%1/%2/%3").arg(repoDir, info.name, fileName);
+            qDebug() << "Creating chunk manifest for" << archive;
+            if (createChunkManifest(repoDir, archive))
+                info.chunkManifests.append(fileName.mid(info.version.count()));
+        }
+    }
+}
+
+/*
+    Returns the versions of the packages in the Updates.xml of \a repositoryDir, by name.
+*/
+static QHash<QString, QString> repositoryPackageVersions(const QString &repositoryDir)
+{
+    QHash<QString, QString> versions;
+    QDomDocument doc;
+    QFile file(repositoryDir + QLatin1String("/Updates.xml"));
+    if (file.open(QFile::ReadOnly) && doc.setContent(&file)) {
+        const QDomElement root = doc.documentElement();
+        if (root.tagName() != QLatin1String("Updates")) {
+            throw QInstaller::Error(QCoreApplication::translate("QInstaller",
+                "Invalid content in \"%1\".").arg(QDir::toNativeSeparators(file.fileName())));
+        }
+        file.close(); // close the file, we read the content already
+
+        const QDomNodeList children = root.childNodes();
+        for (int i = 0; i < children.count(); ++i) {
+            const QDomElement el = children.at(i).toElement();
+            if ((!el.isNull()) && (el.tagName() == QLatin1String("PackageUpdate"))) {
+                versions.insert(el.firstChildElement(scName).text(),
+                    el.firstChildElement(scVersion).text());
+            }
+        }
+    }
+    return versions;
+}
+
+/*
+    Creates the delta patch from \a previousArchive to \a archive next to \a archive. Returns
+    \c false without creating a patch if either archive cannot be rebuilt from its content,
+    contains a file larger than BinaryDelta::MaximumFileSize, or the patch would not be smaller
+    than \a archive.
+*/
+static bool createDeltaPatch(const QString &previousArchive, const QString &archive)
+{
+    QTemporaryDir previousContent;
+    QTemporaryDir content;
+    QStringList previousPaths;
+    QStringList paths;
+    if (!extractRebuildableArchive(previousArchive, previousContent.path(), &previousPaths)
+            || !extractRebuildableArchive(archive, content.path(), &paths)) {
+        return false;
+    }
+
+    // files are patched in memory, archives with large files are always downloaded completely
+    foreach (const QString &path, previousPaths + paths) {
+        const QFileInfo fileInfo(path);
+        if (fileInfo.isFile() && fileInfo.size() > BinaryDelta::MaximumFileSize) {
+            qDebug() << "Skipping delta patch for" << archive << "-" << fileInfo.fileName()
+                << "is too large";
+            return false;
+        }
+    }
+
+    const QDir previousDir(previousContent.path());
+    const QDir contentDir(content.path());
+    DeltaPatch patch;
+    foreach (const QString &path, paths) {
+        const QFileInfo fileInfo(path);
+        DeltaPatch::Entry entry;
+        entry.path = contentDir.relativeFilePath(path);
+        entry.isDirectory = fileInfo.isDir();
+        entry.permissions = fileInfo.permissions();
+        if (!entry.isDirectory) {
+            QFile file(path);
+            QInstaller::openForRead(&file);
+            const QByteArray data = file.readAll();
+            entry.hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+
+            // files are matched by their path, added files are stored completely
+            const QFileInfo previousFileInfo(previousDir.filePath(entry.path));
+            if (previousFileInfo.isFile()) {
+                QFile previousFile(previousFileInfo.filePath());
+                QInstaller::openForRead(&previousFile);
+                const QByteArray previousData = previousFile.readAll();
+                entry.sourceHash = QCryptographicHash::hash(previousData, QCryptographicHash::Sha1).toHex();
+                entry.data = qCompress(BinaryDelta::create(previousData, data));
+            } else {
+                entry.data = qCompress(data);
+            }
+        }
+        patch.addEntry(entry);
+    }
+
+    QSaveFile patchFile(archive + QLatin1String(".patch"));
+    if (!patchFile.open(QIODevice::WriteOnly)) {
+        throw QInstaller::Error(QString::fromLatin1("Cannot write delta patch \"%1\": %2").arg(
+            QDir::toNativeSeparators(patchFile.fileName()), patchFile.errorString()));
+    }
+    patch.write(&patchFile);
+    if (patchFile.size() >= QFileInfo(archive).size()) {
+        qDebug() << "Skipping delta patch for" << archive << "- not smaller than the archive";
+        patchFile.cancelWriting();
+        return false;
+    }
+    if (!patchFile.commit()) {
+        throw QInstaller::Error(QString::fromLatin1("Cannot write delta patch \"%1\": %2").arg(
+            QDir::toNativeSeparators(patchFile.fileName()), patchFile.errorString()));
+    }
+    return true;
+}
+
+void QInstallerTools::createDeltaPatches(const QString &repoDir, const QString &previousPackagesDir,
+    PackageInfoVector *const infos)
+{
+    // the Updates.xml of the repository still describes the replaced versions
+    const QHash<QString, QString> previousVersions = repositoryPackageVersions(repoDir);
+    for (int i = 0; i < infos->count(); ++i) {
+        PackageInfo &info = (*infos)[i];
+        info.deltaPatches.clear();
+        info.deltaPatchFrom.clear();
+        const QString previousVersion = previousVersions.value(info.name);
+        if (previousVersion.isEmpty() || previousVersion == info.version)
+            continue;
+
+        foreach (const QString &file, info.copiedFiles) {
+            if (file.endsWith(QLatin1String(".sha1"), Qt::CaseInsensitive)
+                    || file.endsWith(QLatin1String(".sha256"), Qt::CaseInsensitive)) {
+                continue;
+            }
+            const QString fileName = QFileInfo(file).fileName();
+            const QString archiveName = fileName.mid(info.version.count());
+            const QString previousArchive = QString::fromLatin1("%1/%2/%3%4").arg(previousPackagesDir,
+                info.name, previousVersion, archiveName);
+            if (!QFileInfo::exists(previousArchive))
+                continue;
+
+            const QString archive = QString::fromLatin1("%1/%2/%3").arg(repoDir, info.name, fileName);
+            qDebug() << "Creating delta patch for" << archive << "from version" << previousVersion;
+            if (createDeltaPatch(previousArchive, archive))
+                info.deltaPatches.append(archiveName);
+        }
+        if (!info.deltaPatches.isEmpty())
+            info.deltaPatchFrom = previousVersion;
     }
 }
 
@@ -1069,7 +1823,8 @@ QString QInstallerTools::existingUniteMeta7z(const QString &repositoryDir)
     return uniteMeta7z;
 }
 
-PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha)
+PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha,
+    const QString &previousPackagesDir)
 {
     PackageInfoVector packages;
     PackageInfoVector precompressedPackages = QInstallerTools::createListOfRepositoryPackages(info.repositoryPackages,
@@ -1084,15 +1839,20 @@ PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringL
     }
     foreach (const QInstallerTools::PackageInfo &package, packages) {
         const QFileInfo fi(info.repositoryDir, package.name);
-        if (fi.exists())
+        if (fi.exists()) {
+            // keep the replaced version to create delta patches against
+            if (!previousPackagesDir.isEmpty()) {
+                QInstaller::moveDirectoryContents(fi.absoluteFilePath(),
+                    previousPackagesDir + QLatin1Char('/') + package.name);
+            }
             removeDirectory(fi.absoluteFilePath());
+        }
     }
     return packages;
 }
 
 void QInstallerTools::createRepository(RepositoryInfo info, PackageInfoVector *packages,
-        const QString &tmpMetaDir, bool createComponentMetadata, bool createUnifiedMetadata,
-        const QString &archiveSuffix, Compression compression)
+        const QString &tmpMetaDir, const RepositoryOptions &options)
 {
     QHash<QString, QString> pathToVersionMapping = QInstallerTools::buildPathToVersionMapping(*packages);
 
@@ -1108,15 +1868,18 @@ void QInstallerTools::createRepository(RepositoryInfo info, PackageInfoVector *p
             unite7zFiles.append(it.fileInfo().absoluteFilePath());
         }
     }
-    QInstallerTools::copyComponentData(directories, info.repositoryDir, packages, archiveSuffix, compression);
+    QInstallerTools::copyComponentData(directories, info.repositoryDir, packages, options);
+    if (options.createChunkManifests)
+        QInstallerTools::createChunkManifests(info.repositoryDir, packages);
+    if (!options.previousPackagesDir.isEmpty())
+        QInstallerTools::createDeltaPatches(info.repositoryDir, options.previousPackagesDir, packages);
     QInstallerTools::copyMetaData(tmpMetaDir, info.repositoryDir, *packages, QLatin1String("{AnyApplication}"),
-        QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)), unite7zFiles);
+        QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)), unite7zFiles, options.checksumAlgorithm);
 
     QString existing7z = QInstallerTools::existingUniteMeta7z(info.repositoryDir);
     if (!existing7z.isEmpty())
         existing7z = info.repositoryDir + QDir::separator() + existing7z;
-    QInstallerTools::compressMetaDirectories(tmpMetaDir, existing7z, pathToVersionMapping,
-                                             createComponentMetadata, createUnifiedMetadata);
+    QInstallerTools::compressMetaDirectories(tmpMetaDir, existing7z, pathToVersionMapping, options);
 
     QDirIterator it(info.repositoryDir, QStringList(QLatin1String("Updates*.xml"))
                     << QLatin1String("*_meta.7z"), QDir::Files | QDir::CaseSensitive);
@@ -33,7 +33,9 @@
 
 #include <abstractarchive.h>
 
+#include <QCryptographicHash>
 #include <QHash>
+#include <QMap>
 #include <QString>
 #include <QStringList>
 #include <QVector>
@@ -51,10 +53,14 @@ struct IFWTOOLS_EXPORT PackageInfo
     QString metaFile;
     QString metaNode;
     QString contentSha1;
+    QStringList chunkManifests;
+    QStringList deltaPatches;
+    QString deltaPatchFrom;
     bool createContentSha1Node;
 };
 typedef QVector<PackageInfo> PackageInfoVector;
 typedef QInstaller::AbstractArchive::CompressionLevel Compression;
+typedef QMap<QCryptographicHash::Algorithm, QByteArray> ArchiveChecksums;
 
 enum IFWTOOLS_EXPORT FilterType {
     Include,
@@ -68,6 +74,23 @@ struct IFWTOOLS_EXPORT RepositoryInfo
     QString repositoryDir;
 };
 
+struct IFWTOOLS_EXPORT RepositoryOptions
+{
+    bool createComponentMetadata = true;
+    bool createUnifiedMetadata = true;
+    QString archiveSuffix = QLatin1String("7z");
+    Compression compression = Compression::Normal;
+    int compressionThreads = 0;
+    qint64 solidBlockSize = 0;
+    QCryptographicHash::Algorithm checksumAlgorithm = QCryptographicHash::Sha1;
+    int jobs = 1;
+    QString cacheDirectory;
+    bool appendUnifiedMetadata = false;
+    qint64 metadataChunkSize = 0;
+    bool createChunkManifests = false;
+    QString previousPackagesDir;
+};
+
 void IFWTOOLS_EXPORT printRepositoryGenOptions();
 QString IFWTOOLS_EXPORT makePathAbsolute(const QString &path);
 void IFWTOOLS_EXPORT copyWithException(const QString &source, const QString &target, const QString &kind = QString());
@@ -80,28 +103,36 @@ PackageInfoVector IFWTOOLS_EXPORT createListOfRepositoryPackages(const QStringLi
 
 QHash<QString, QString> IFWTOOLS_EXPORT buildPathToVersionMapping(const PackageInfoVector &info);
 
-void IFWTOOLS_EXPORT createArchive(const QString &filename, const QStringList &data, Compression compression = Compression::Normal);
+void IFWTOOLS_EXPORT createArchive(const QString &filename, const QStringList &data, Compression compression = Compression::Normal,
+    int compressionThreads = 0, qint64 solidBlockSize = 0, ArchiveChecksums *checksums = nullptr);
 
 void IFWTOOLS_EXPORT compressMetaDirectories(const QString &repoDir, const QString &existingUnite7zUrl,
-    const QHash<QString, QString> &versionMapping, bool createSplitMetadata, bool createUnifiedMetadata);
+    const QHash<QString, QString> &versionMapping, const RepositoryOptions &options = RepositoryOptions());
 
-QStringList unifyMetadata(const QString &repoDir, const QString &existingRepoDir, QDomDocument doc);
+QStringList unifyMetadata(const QString &repoDir, const QString &existingRepoDir, QDomDocument doc,
+                          const RepositoryOptions &options = RepositoryOptions());
 void splitMetadata(const QStringList &entryList, const QString &repoDir, QDomDocument doc,
-                   const QHash<QString, QString> &versionMapping);
+                   const QHash<QString, QString> &versionMapping,
+                   const RepositoryOptions &options = RepositoryOptions());
 
 void IFWTOOLS_EXPORT copyMetaData(const QString &outDir, const QString &dataDir, const PackageInfoVector &packages,
-    const QString &appName, const QString& appVersion, const QStringList &uniteMetadatas);
+    const QString &appName, const QString& appVersion, const QStringList &uniteMetadatas,
+    QCryptographicHash::Algorithm checksumAlgorithm = QCryptographicHash::Sha1);
 void IFWTOOLS_EXPORT copyComponentData(const QStringList &packageDir, const QString &repoDir,
-                                       PackageInfoVector *const infos, const QString &archiveSuffix,
-                                       Compression compression = Compression::Normal);
+                                       PackageInfoVector *const infos,
+                                       const RepositoryOptions &options = RepositoryOptions());
+
+void IFWTOOLS_EXPORT createChunkManifests(const QString &repoDir, PackageInfoVector *const infos);
+void IFWTOOLS_EXPORT createDeltaPatches(const QString &repoDir, const QString &previousPackagesDir,
+                                        PackageInfoVector *const infos);
 
 void IFWTOOLS_EXPORT filterNewComponents(const QString &repositoryDir, QInstallerTools::PackageInfoVector &packages);
 
 QString IFWTOOLS_EXPORT existingUniteMeta7z(const QString &repositoryDir);
-PackageInfoVector IFWTOOLS_EXPORT collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha);
+PackageInfoVector IFWTOOLS_EXPORT collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha,
+                                          const QString &previousPackagesDir = QString());
 void IFWTOOLS_EXPORT createRepository(RepositoryInfo info, PackageInfoVector *packages, const QString &tmpMetaDir,
-                                      bool createComponentMetadata, bool createUnifiedMetadata, const QString &archiveSuffix,
-                                      Compression compression = Compression::Normal);
+                                      const RepositoryOptions &options = RepositoryOptions());
 } // namespace QInstallerTools
 
 #endif // REPOSITORYGEN_H
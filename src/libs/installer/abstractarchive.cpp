@@ -60,15 +60,31 @@ namespace QInstaller {
 /*!
     \fn QInstaller::AbstractArchive::currentEntryChanged(const QString &filename)
 
-    Current entry changed to \a filename. Subclasses should emit this signal whenever
-    the entry to process is changed.
+    Current entry changed to \a filename. The signal is emitted for the last entry
+    of every batch reported with entriesExtracted(), so it is throttled like that
+    signal and does not cover every single entry.
+*/
+
+/*!
+    \fn QInstaller::AbstractArchive::entriesExtracted(const QStringList &filenames)
+
+    The entries \a filenames were extracted. Subclasses should report the extracted
+    entries in batches, for example with ExtractNotifier, instead of emitting a signal
+    for every single entry.
 */
 
 /*!
     \fn QInstaller::AbstractArchive::completedChanged(quint64 completed, quint64 total)
 
     The ratio of \a completed entries from \a total changed. Subclasses should emit
-    this whenever the progress changes.
+    this whenever the progress changes, but not more often than ExtractNotifier does.
+*/
+
+/*!
+    \fn QInstaller::AbstractArchive::fileBackedUp(const QString &filename, const QString &backupFilename)
+
+    The existing file \a filename was renamed to \a backupFilename before being overwritten
+    by an extracted entry. Emitted only if backups were enabled with setBackupExistingFiles().
 */
 
 /*!
@@ -98,12 +114,21 @@ namespace QInstaller {
 */
 
 /*!
-    \fn QInstaller::AbstractArchive::extract(const QString &dirPath, const quint64 totalFiles)
+    Extracts only the archive \a entries to \a dirPath. An entry is the path of a file inside
+    the archive, as returned by list(), or of a directory, in which case everything inside it is
+    extracted. If \a entries is empty, the whole archive is extracted. Returns \c true on
+    success; \c false otherwise, also if one of the \a entries is not part of the archive.
 
-    Extracts the contents of an archive to \a dirPath with precalculated
-    count of \a totalFiles. Returns \c true on success; \c false otherwise.
-    A subclass should implement this method.
+    Formats that index their entries, like non-solid 7z archives, decode only the data of the
+    selected entries. The default implementation supports extracting the whole archive only.
 */
+bool AbstractArchive::extract(const QString &dirPath, const QStringList &entries)
+{
+    if (entries.isEmpty())
+        return extract(dirPath);
+    setErrorString(tr("Extracting single entries is not supported for this archive format."));
+    return false;
+}
 
 /*!
     \fn QInstaller::AbstractArchive::isSupported()
@@ -131,6 +156,102 @@ namespace QInstaller {
     Sets the \a filename for the archive. A subclass should implement this method.
 */
 
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ExtractNotifier
+    \internal
+    \brief The ExtractNotifier class batches the notifications of an extraction.
+
+    Emitting a queued signal for every entry of an archive with hundreds of thousands
+    of small files costs more than writing the files. The notifier collects the entries
+    and the progress, and emits them at most every 100 milliseconds or for every 1000
+    entries, whichever comes first. The extraction must call flush() when done.
+*/
+
+/*!
+    \fn QInstaller::ExtractNotifier::entriesExtracted(const QStringList &filenames)
+
+    Emitted with the batch of extracted \a filenames.
+*/
+
+/*!
+    \fn QInstaller::ExtractNotifier::completedChanged(quint64 completed, quint64 total)
+
+    Emitted with the latest \a completed and \a total values of the extraction.
+*/
+
+static const int scNotifyInterval = 100; // milliseconds
+static const int scNotifyBatchSize = 1000;
+
+/*!
+    Constructs a new notifier with \a parent as parent.
+*/
+ExtractNotifier::ExtractNotifier(QObject *parent)
+    : QObject(parent)
+    , m_completed(0)
+    , m_total(0)
+    , m_completedPending(false)
+{
+    m_timer.start();
+}
+
+/*!
+    Discards pending notifications and restarts the interval, to be called before
+    a new extraction starts.
+*/
+void ExtractNotifier::reset()
+{
+    m_entries.clear();
+    m_completedPending = false;
+    m_timer.restart();
+}
+
+/*!
+    Adds the extracted \a filename to the current batch.
+*/
+void ExtractNotifier::addEntry(const QString &filename)
+{
+    m_entries.append(filename);
+    flushIfDue();
+}
+
+/*!
+    Sets the progress of the extraction to \a completed of \a total.
+*/
+void ExtractNotifier::setCompleted(quint64 completed, quint64 total)
+{
+    m_completed = completed;
+    m_total = total;
+    m_completedPending = true;
+    flushIfDue();
+}
+
+/*!
+    Emits the pending entries and progress immediately.
+*/
+void ExtractNotifier::flush()
+{
+    if (!m_entries.isEmpty()) {
+        const QStringList entries = m_entries;
+        m_entries.clear();
+        emit entriesExtracted(entries);
+    }
+    if (m_completedPending) {
+        m_completedPending = false;
+        emit completedChanged(m_completed, m_total);
+    }
+    m_timer.restart();
+}
+
+/*!
+    \internal
+*/
+void ExtractNotifier::flushIfDue()
+{
+    if (m_entries.count() >= scNotifyBatchSize || m_timer.elapsed() >= scNotifyInterval)
+        flush();
+}
+
 /*!
     Constructs a new archive object with \a parent as parent. Cannot be
     called directly but instead from subclass constructors.
@@ -138,7 +259,14 @@ namespace QInstaller {
 AbstractArchive::AbstractArchive(QObject *parent)
     : QObject(parent)
     , m_compressionLevel(CompressionLevel::Normal)
+    , m_compressionThreads(0)
+    , m_solidBlockSize(0)
+    , m_backupExistingFiles(false)
 {
+    connect(this, &AbstractArchive::entriesExtracted, this, [this](const QStringList &filenames) {
+        if (!filenames.isEmpty())
+            emit currentEntryChanged(filenames.last());
+    }, Qt::DirectConnection);
 }
 
 /*!
@@ -164,6 +292,75 @@ void AbstractArchive::setCompressionLevel(const CompressionLevel level)
     m_compressionLevel = level;
 }
 
+/*!
+    Sets the number of \a threads used to compress new archives. The default value \c 0
+    lets the compressor use all available processor cores. Formats that cannot compress
+    in parallel ignore this setting.
+*/
+void AbstractArchive::setCompressionThreads(const int threads)
+{
+    m_compressionThreads = threads;
+}
+
+/*!
+    Sets the maximum \a size in bytes of a solid block in new archives. Smaller blocks
+    compress slightly worse, but can be decompressed in parallel. The default value \c 0
+    leaves the block size to the compressor, a negative value disables solid compression.
+    Formats without solid blocks ignore this setting.
+*/
+void AbstractArchive::setSolidBlockSize(const qint64 size)
+{
+    m_solidBlockSize = size;
+}
+
+/*!
+    If \a backup is \c true, existing files are renamed to a backup name instead of being
+    overwritten when extracting. Every backup is reported with the fileBackedUp() signal
+    while the archive is extracted, so no separate listing pass is needed to prepare
+    the target directory.
+*/
+void AbstractArchive::setBackupExistingFiles(const bool backup)
+{
+    m_backupExistingFiles = backup;
+}
+
+/*!
+    Sets the hex encoded SHA-1 or SHA-256 \a checksum the archive file must match. The
+    checksum is calculated from the data read while extracting, and extract() fails if it
+    does not match. The entries extracted so far have been reported already and can be
+    removed by the caller. An empty \a checksum disables the verification.
+*/
+void AbstractArchive::setExpectedChecksum(const QByteArray &checksum)
+{
+    m_expectedChecksum = checksum;
+}
+
+/*!
+    Sets the checksum \a algorithms calculated while create() writes the archive, so
+    the checksums of a new archive are known without reading it again.
+
+    \sa createdChecksum()
+*/
+void AbstractArchive::setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms)
+{
+    m_createdChecksumAlgorithms = algorithms;
+    m_createdChecksumHashes.clear();
+}
+
+/*!
+    Returns the checksum calculated with \a algorithm of the archive written by the last
+    call to create(). Returns an empty byte array if the \a algorithm was not set with
+    setCreatedChecksumAlgorithms(), or the format does not support calculating it while
+    writing. The caller needs to read the archive file in that case.
+*/
+QByteArray AbstractArchive::createdChecksum(QCryptographicHash::Algorithm algorithm) const
+{
+    const int index = m_createdChecksumAlgorithms.indexOf(algorithm);
+    if (index < 0 || index >= m_createdChecksumHashes.count())
+        return QByteArray();
+    return m_createdChecksumHashes.at(index)->result();
+}
+
 /*!
     Sets a human-readable description of the current \a error.
 */
@@ -180,6 +377,58 @@ AbstractArchive::CompressionLevel AbstractArchive::compressionLevel() const
     return m_compressionLevel;
 }
 
+/*!
+    Returns the number of threads used for compression, \c 0 meaning all available
+    processor cores.
+*/
+int AbstractArchive::compressionThreads() const
+{
+    return m_compressionThreads;
+}
+
+/*!
+    Returns the maximum size of a solid block in bytes, \c 0 meaning the compressor
+    default and a negative value non-solid compression.
+*/
+qint64 AbstractArchive::solidBlockSize() const
+{
+    return m_solidBlockSize;
+}
+
+/*!
+    Returns \c true if existing files are backed up before being overwritten on extraction.
+*/
+bool AbstractArchive::backupExistingFiles() const
+{
+    return m_backupExistingFiles;
+}
+
+/*!
+    Returns the checksum the archive file must match on extraction, or an empty
+    byte array if it is not verified.
+*/
+QByteArray AbstractArchive::expectedChecksum() const
+{
+    return m_expectedChecksum;
+}
+
+/*!
+    Returns new hashes for the algorithms set with setCreatedChecksumAlgorithms(). A
+    subclass passes all data it writes in create() to them, createdChecksum() returns
+    their results afterwards. The hashes are owned by the archive.
+*/
+QList<QCryptographicHash *> AbstractArchive::createdChecksumHashes()
+{
+    m_createdChecksumHashes.clear();
+    QList<QCryptographicHash *> hashes;
+    foreach (const QCryptographicHash::Algorithm algorithm, m_createdChecksumAlgorithms) {
+        m_createdChecksumHashes.append(QSharedPointer<QCryptographicHash>(
+            new QCryptographicHash(algorithm)));
+        hashes.append(m_createdChecksumHashes.last().data());
+    }
+    return hashes;
+}
+
 /*!
     Reads an \a entry from the specified \a istream. Returns a reference to \a istream.
 */
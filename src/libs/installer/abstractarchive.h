@@ -31,10 +31,14 @@
 
 #include "installer_global.h"
 
+#include <QCryptographicHash>
 #include <QFile>
 #include <QDateTime>
 #include <QDataStream>
+#include <QElapsedTimer>
 #include <QPoint>
+#include <QSharedPointer>
+#include <QStringList>
 
 #ifdef Q_OS_WIN
 typedef int mode_t;
@@ -62,6 +66,34 @@ struct INSTALLER_EXPORT ArchiveEntry
     QFile::Permissions permissions_enum;
 };
 
+class INSTALLER_EXPORT ExtractNotifier : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ExtractNotifier)
+
+public:
+    explicit ExtractNotifier(QObject *parent = nullptr);
+
+    void reset();
+    void addEntry(const QString &filename);
+    void setCompleted(quint64 completed, quint64 total);
+    void flush();
+
+Q_SIGNALS:
+    void entriesExtracted(const QStringList &filenames);
+    void completedChanged(quint64 completed, quint64 total);
+
+private:
+    void flushIfDue();
+
+private:
+    QStringList m_entries;
+    quint64 m_completed;
+    quint64 m_total;
+    bool m_completedPending;
+    QElapsedTimer m_timer;
+};
+
 class INSTALLER_EXPORT AbstractArchive : public QObject
 {
     Q_OBJECT
@@ -88,16 +120,24 @@ public:
     virtual QString errorString() const;
 
     virtual bool extract(const QString &dirPath) = 0;
-    virtual bool extract(const QString &dirPath, const quint64 totalFiles) = 0;
+    virtual bool extract(const QString &dirPath, const QStringList &entries);
     virtual bool create(const QStringList &data) = 0;
     virtual QVector<ArchiveEntry> list() = 0;
     virtual bool isSupported() = 0;
 
     virtual void setCompressionLevel(const CompressionLevel level);
+    virtual void setCompressionThreads(const int threads);
+    virtual void setSolidBlockSize(const qint64 size);
+    virtual void setBackupExistingFiles(const bool backup);
+    virtual void setExpectedChecksum(const QByteArray &checksum);
+    virtual void setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms);
+    virtual QByteArray createdChecksum(QCryptographicHash::Algorithm algorithm) const;
 
 Q_SIGNALS:
     void currentEntryChanged(const QString &filename);
+    void entriesExtracted(const QStringList &filenames);
     void completedChanged(const quint64 completed, const quint64 total);
+    void fileBackedUp(const QString &filename, const QString &backupFilename);
 
 public Q_SLOTS:
     virtual void cancel() = 0;
@@ -105,10 +145,21 @@ public Q_SLOTS:
 protected:
     void setErrorString(const QString &error);
     CompressionLevel compressionLevel() const;
+    int compressionThreads() const;
+    qint64 solidBlockSize() const;
+    bool backupExistingFiles() const;
+    QByteArray expectedChecksum() const;
+    QList<QCryptographicHash *> createdChecksumHashes();
 
 private:
     QString m_error;
     CompressionLevel m_compressionLevel;
+    int m_compressionThreads;
+    qint64 m_solidBlockSize;
+    bool m_backupExistingFiles;
+    QByteArray m_expectedChecksum;
+    QList<QCryptographicHash::Algorithm> m_createdChecksumAlgorithms;
+    QList<QSharedPointer<QCryptographicHash>> m_createdChecksumHashes;
 };
 
 INSTALLER_EXPORT QDataStream &operator>>(QDataStream &istream, ArchiveEntry &entry);
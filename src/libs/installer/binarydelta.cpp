@@ -0,0 +1,324 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "binarydelta.h"
+
+#include "fileutils.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QIODevice>
+
+#include <cstring>
+#include <limits>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::BinaryDelta
+    \internal
+    \brief The BinaryDelta class creates and applies binary deltas between two versions of a file.
+
+    A delta is a sequence of instructions that either copy a range of the source or insert
+    new bytes. Matches are found by indexing the source in blocks of BlockSize bytes and
+    searching the target for them with a rolling hash, so also moved content is found. Matches
+    are extended beyond the block boundaries in both directions.
+
+    Deltas consist mostly of copy instructions and the inserted bytes, so they compress well
+    and are stored compressed in DeltaPatch entries.
+
+    Both versions of a file and the delta are held in memory, so files larger than
+    MaximumFileSize are not patched. Archives containing such files are always downloaded
+    completely.
+*/
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::DeltaPatch
+    \internal
+    \brief The DeltaPatch class describes the changes of an archive from its previous version.
+
+    Patches are created by repogen --delta-patches next to each updated component archive.
+    Each entry holds either a delta against the file installed from the previous version of
+    the archive, or the complete content of a file that was added.
+*/
+
+const int BinaryDelta::BlockSize;
+const qint64 BinaryDelta::MaximumFileSize;
+
+static const char scDeltaMagic[] = "IFWDELTA";
+static const char scPatchMagic[] = "IFWPATCH";
+
+enum DeltaOperation {
+    Copy = 1,
+    Insert = 2
+};
+
+static const quint32 scHashBase = 0x01000193;
+
+static quint32 blockHash(const uchar *data)
+{
+    quint32 hash = 0;
+    for (int i = 0; i < BinaryDelta::BlockSize; ++i)
+        hash = hash * scHashBase + data[i];
+    return hash;
+}
+
+/*
+    Returns the factor of the byte leaving the rolling hash window.
+*/
+static quint32 leavingFactor()
+{
+    static const quint32 factor = [] {
+        quint32 value = 1;
+        for (int i = 1; i < BinaryDelta::BlockSize; ++i)
+            value *= scHashBase;
+        return value;
+    }();
+    return factor;
+}
+
+static int tableSlot(quint32 hash, int bits)
+{
+    return int((hash * 0x9e3779b1u) >> (32 - bits));
+}
+
+static void writeCopy(QDataStream &out, int offset, int length)
+{
+    out << quint8(Copy) << qint64(offset) << qint64(length);
+}
+
+static void writeInsert(QDataStream &out, const QByteArray &data)
+{
+    out << quint8(Insert) << data;
+}
+
+/*!
+    Returns the delta that turns \a source into \a target.
+*/
+QByteArray BinaryDelta::create(const QByteArray &source, const QByteArray &target)
+{
+    QByteArray delta;
+    QDataStream out(&delta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(scDeltaMagic) << qint64(target.size());
+
+    if (source == target) {
+        if (!target.isEmpty())
+            writeCopy(out, 0, target.size());
+        return delta;
+    }
+
+    const uchar *const src = reinterpret_cast<const uchar *>(source.constData());
+    const uchar *const tgt = reinterpret_cast<const uchar *>(target.constData());
+    const int sourceSize = source.size();
+    const int targetSize = target.size();
+
+    // index the source blocks, earlier blocks win on collisions
+    int bits = 10;
+    while ((qint64(1) << bits) < 2 * qint64(sourceSize / BlockSize) && bits < 30)
+        ++bits;
+    QVector<int> table(1 << bits, -1);
+    for (int offset = sourceSize - sourceSize % BlockSize - BlockSize; offset >= 0; offset -= BlockSize)
+        table[tableSlot(blockHash(src + offset), bits)] = offset;
+
+    const quint32 factor = leavingFactor();
+    int insertStart = 0;
+    int position = 0;
+    quint32 hash = 0;
+    bool hashValid = false;
+    while (position + BlockSize <= targetSize) {
+        if (!hashValid) {
+            hash = blockHash(tgt + position);
+            hashValid = true;
+        }
+
+        int match = table.at(tableSlot(hash, bits));
+        if (match >= 0 && memcmp(src + match, tgt + position, BlockSize) == 0) {
+            int start = position;
+            while (start > insertStart && match > 0 && src[match - 1] == tgt[start - 1]) {
+                --start;
+                --match;
+            }
+            int length = position - start + BlockSize;
+            while (match + length < sourceSize && start + length < targetSize
+                    && src[match + length] == tgt[start + length]) {
+                ++length;
+            }
+
+            if (start > insertStart)
+                writeInsert(out, target.mid(insertStart, start - insertStart));
+            writeCopy(out, match, length);
+            position = start + length;
+            insertStart = position;
+            hashValid = false;
+            continue;
+        }
+
+        if (position + BlockSize < targetSize)
+            hash = (hash - tgt[position] * factor) * scHashBase + tgt[position + BlockSize];
+        ++position;
+    }
+    if (insertStart < targetSize)
+        writeInsert(out, target.mid(insertStart));
+    return delta;
+}
+
+/*!
+    Applies \a delta to \a source and stores the result in \a target. Returns \c false if
+    \a delta is invalid or was not created for a source of the size of \a source.
+*/
+bool BinaryDelta::apply(const QByteArray &source, const QByteArray &delta, QByteArray *target)
+{
+    QDataStream in(delta);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray magic;
+    qint64 targetSize = -1;
+    in >> magic >> targetSize;
+    if (in.status() != QDataStream::Ok || magic != scDeltaMagic || targetSize < 0
+            || targetSize > std::numeric_limits<int>::max()) {
+        return false;
+    }
+
+    QByteArray result;
+    result.reserve(int(targetSize));
+    while (!in.atEnd()) {
+        quint8 operation = 0;
+        in >> operation;
+        if (operation == Copy) {
+            qint64 offset = -1;
+            qint64 length = -1;
+            in >> offset >> length;
+            if (in.status() != QDataStream::Ok || offset < 0 || length < 0
+                    || offset > source.size() || length > source.size() - offset) {
+                return false;
+            }
+            result.append(source.constData() + offset, int(length));
+        } else if (operation == Insert) {
+            QByteArray data;
+            in >> data;
+            if (in.status() != QDataStream::Ok)
+                return false;
+            result.append(data);
+        } else {
+            return false;
+        }
+        if (result.size() > targetSize)
+            return false;
+    }
+    if (result.size() != targetSize)
+        return false;
+
+    *target = result;
+    return true;
+}
+
+/*!
+    Returns the files and directories of the patched archive.
+*/
+QVector<DeltaPatch::Entry> DeltaPatch::entries() const
+{
+    return m_entries;
+}
+
+/*!
+    Adds the file or directory \a entry to the patch.
+*/
+void DeltaPatch::addEntry(const Entry &entry)
+{
+    m_entries.append(entry);
+}
+
+/*!
+    Reads the patch from \a device. Returns \c false and sets the error string if the
+    patch is invalid. Entries must have relative paths that do not leave the directory the
+    archive is patched in.
+*/
+bool DeltaPatch::read(QIODevice *device)
+{
+    m_entries.clear();
+    m_errorString.clear();
+
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray magic;
+    in >> magic;
+    if (magic != scPatchMagic) {
+        m_errorString = QCoreApplication::translate("DeltaPatch", "Unexpected file format.");
+        return false;
+    }
+
+    while (!in.atEnd()) {
+        Entry entry;
+        qint32 permissions = 0;
+        in >> entry.path >> entry.isDirectory >> permissions >> entry.hash >> entry.sourceHash
+            >> entry.data;
+        if (in.status() != QDataStream::Ok) {
+            m_errorString = QCoreApplication::translate("DeltaPatch", "Unexpected end of patch.");
+        } else if (entry.path.isEmpty()) {
+            m_errorString = QCoreApplication::translate("DeltaPatch", "Entry without path.");
+        } else if (!isContainedRelativePath(entry.path)) {
+            m_errorString = QCoreApplication::translate("DeltaPatch", "Invalid path \"%1\".")
+                .arg(entry.path);
+        }
+        if (!m_errorString.isEmpty()) {
+            m_entries.clear();
+            return false;
+        }
+        entry.permissions = QFile::Permissions(permissions);
+        m_entries.append(entry);
+    }
+    return true;
+}
+
+/*!
+    Writes the patch to \a device.
+*/
+void DeltaPatch::write(QIODevice *device) const
+{
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(scPatchMagic);
+    foreach (const Entry &entry, m_entries) {
+        out << entry.path << entry.isDirectory << qint32(entry.permissions) << entry.hash
+            << entry.sourceHash << entry.data;
+    }
+}
+
+/*!
+    Returns a human-readable description of the last error that occurred.
+*/
+QString DeltaPatch::errorString() const
+{
+    return m_errorString;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,83 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef BINARYDELTA_H
+#define BINARYDELTA_H
+
+#include "installer_global.h"
+
+#include <QFile>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT BinaryDelta
+{
+public:
+    static QByteArray create(const QByteArray &source, const QByteArray &target);
+    static bool apply(const QByteArray &source, const QByteArray &delta, QByteArray *target);
+
+    static const int BlockSize = 32;
+    static const qint64 MaximumFileSize = 1024 * 1024 * 1024;
+};
+
+class INSTALLER_EXPORT DeltaPatch
+{
+public:
+    struct Entry
+    {
+        Entry() : isDirectory(false), permissions(0) {}
+
+        QString path;
+        bool isDirectory;
+        QFile::Permissions permissions;
+        QByteArray hash;
+        QByteArray sourceHash;
+        QByteArray data;
+    };
+
+    QVector<Entry> entries() const;
+    void addEntry(const Entry &entry);
+
+    bool read(QIODevice *device);
+    void write(QIODevice *device) const;
+
+    QString errorString() const;
+
+private:
+    QVector<Entry> m_entries;
+    QString m_errorString;
+};
+
+} // namespace QInstaller
+
+#endif // BINARYDELTA_H
@@ -35,6 +35,13 @@
 #include <QFlags>
 #include <QUuid>
 
+#include <errno.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace QInstaller {
 
 /*!
@@ -72,6 +79,11 @@ namespace QInstaller {
 
     The resource name can be set at any time using setName() or during construction. The segment
     supplied during construction represents the offset and size of the resource inside the file.
+
+    When opened, the resource maps its segment into memory if the file engine supports it, so
+    reads are plain memory copies and mappedData() gives direct access to the data. If the
+    segment cannot be mapped, for example because it exceeds the available address space, the
+    resource falls back to reading from the file.
 */
 
 /*!
@@ -83,7 +95,21 @@ namespace QInstaller {
 /*!
     \fn void QInstaller::Resource::setSegment(const Range<qint64> &segment)
 
-    Sets the range to the \a segment of the file that this resource represents.
+    Sets the range to the \a segment of the file that this resource represents. The segment must
+    not be changed while the resource is open.
+*/
+
+/*!
+    \fn bool QInstaller::Resource::isMapped() const
+
+    Returns \c true if the resource is open and its segment is mapped into memory.
+*/
+
+/*!
+    \fn const uchar *QInstaller::Resource::mappedData() const
+
+    Returns a pointer to the first byte of the resource segment if the segment is mapped into
+    memory, otherwise returns \c nullptr. The pointer remains valid until the resource is closed.
 */
 
 /*!
@@ -93,6 +119,7 @@ Resource::Resource(const QString &path)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_map(nullptr)
 {
 }
 
@@ -103,6 +130,7 @@ Resource::Resource(const QString &path, const QByteArray &name)
     : m_file(path)
     , m_name(name)
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_map(nullptr)
 {
 }
 
@@ -113,6 +141,7 @@ Resource::Resource(const QString &path, const Range<qint64> &segment)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(segment)
+    , m_map(nullptr)
 {
 }
 
@@ -133,6 +162,14 @@ bool Resource::seek(qint64 pos)
     return QIODevice::seek(pos);
 }
 
+/*!
+    Returns the path of the file the resource reads from.
+*/
+QString Resource::path() const
+{
+    return m_file.fileName();
+}
+
 /*!
     Returns the name of the resource.
 */
@@ -162,6 +199,9 @@ bool Resource::open()
         setErrorString(m_file.errorString());
         return false;
     }
+    // mapping beyond the end of the file would crash on access instead of failing a read
+    if (m_segment.length() > 0 && m_segment.end() <= m_file.size())
+        m_map = m_file.map(m_segment.start(), m_segment.length(), QFileDevice::NoOptions);
 
     if (!QIODevice::open(QIODevice::ReadOnly)) {
         setErrorString(tr("Cannot open resource %1 for reading.").arg(QString::fromUtf8(m_name)));
@@ -174,6 +214,10 @@ bool Resource::open()
  */
 void Resource::close()
 {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
     m_file.close();
     QIODevice::close();
 }
@@ -196,11 +240,26 @@ qint64 Resource::readData(char* data, qint64 maxSize)
     if (maxSize <= 0)
         return 0;
 
-    const qint64 p = m_file.pos();
-    m_file.seek(m_segment.start() + pos());
-    const qint64 amountRead = m_file.read(data, maxSize);
-    m_file.seek(p);
+    if (m_map) {
+        memcpy(data, m_map + pos(), size_t(maxSize));
+        return maxSize;
+    }
+
+#ifdef Q_OS_UNIX
+    // positional read, the file offset is neither used nor changed
+    ssize_t amountRead;
+    do {
+        amountRead = ::pread(m_file.handle(), data, size_t(maxSize), m_segment.start() + pos());
+    } while (amountRead < 0 && errno == EINTR);
+    if (amountRead < 0)
+        setErrorString(qt_error_string(errno));
     return amountRead;
+#else
+    // the engine is private to this resource, so there is no position to restore afterwards
+    if (!m_file.seek(m_segment.start() + pos()))
+        return -1;
+    return m_file.read(data, maxSize);
+#endif
 }
 
 /*!
@@ -220,29 +279,95 @@ qint64 Resource::writeData(const char* data, qint64 maxSize)
     Copies the resource data to a file called \a out. Throws Error on failure.
 */
 
+#ifdef Q_OS_LINUX
+/*
+    Copies \a size bytes starting at \a offset of \a inFd to the current position of \a outFd
+    inside the kernel. Returns the number of bytes copied, which is less than \a size if
+    copy_file_range() is not supported for the given files.
+*/
+static qint64 kernelCopyRange(int inFd, qint64 offset, int outFd, qint64 size)
+{
+    struct stat st;
+    if (::fstat(outFd, &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+
+    qint64 copied = 0;
+    loff_t inOffset = offset;
+    while (copied < size) {
+        errno = 0;
+        const ssize_t written = ::copy_file_range(inFd, &inOffset, outFd, nullptr,
+            static_cast<size_t>(size - copied), 0);
+        if (written > 0) {
+            copied += written;
+            continue;
+        }
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && copied > 0) {
+            throw QInstaller::Error(Resource::tr("Write failed after %1 bytes: %2")
+                .arg(QString::number(copied), qt_error_string(errno)));
+        }
+        break; // not supported, or the file is shorter than expected: let the caller handle it
+    }
+    return copied;
+}
+#endif
+
 /*!
     \overload
 
     Copies the resource data of \a resource to a file called \a out. Throws Error on failure.
+
+    On Linux the data is copied inside the kernel if \a out is a regular file. Otherwise the data
+    is written straight from the mapped segment if the resource is mapped, or copied in large
+    blocks.
 */
 void Resource::copyData(Resource *resource, QFileDevice *out)
 {
-    qint64 left = resource->size();
-    char data[4096];
-    while (left > 0) {
-        const qint64 len = qMin<qint64>(left, 4096);
-        const qint64 bytesRead = resource->read(data, len);
-        if (bytesRead != len) {
-            throw QInstaller::Error(tr("Read failed after %1 bytes: %2")
-                .arg(QString::number(resource->size() - left), resource->errorString()));
-        }
-        const qint64 bytesWritten = out->write(data, len);
-        if (bytesWritten != len) {
+    static const qint64 ChunkSize = 16 * 1024 * 1024;
+
+    const qint64 size = resource->size();
+    qint64 copied = 0;
+#ifdef Q_OS_LINUX
+    if (out->handle() != -1 && out->flush()) {
+        copied = kernelCopyRange(resource->m_file.handle(), resource->m_segment.start(),
+            out->handle(), size);
+        if (copied > 0 && !out->seek(out->pos() + copied)) {
             throw QInstaller::Error(tr("Write failed after %1 bytes: %2")
-                .arg(QString::number(resource->size() - left), out->errorString()));
+                .arg(QString::number(copied), out->errorString()));
+        }
+    }
+#endif
+    if (resource->m_map) {
+        while (copied < size) {
+            const qint64 len = qMin(size - copied, ChunkSize);
+            const qint64 bytesWritten = out->write(reinterpret_cast<const char *>(resource->m_map)
+                + copied, len);
+            if (bytesWritten != len) {
+                throw QInstaller::Error(tr("Write failed after %1 bytes: %2")
+                    .arg(QString::number(copied), out->errorString()));
+            }
+            copied += len;
+        }
+    } else {
+        QByteArray data(int(qMin(size - copied, qint64(1024 * 1024))), Qt::Uninitialized);
+        resource->seek(copied);
+        while (copied < size) {
+            const qint64 len = qMin<qint64>(size - copied, data.size());
+            const qint64 bytesRead = resource->read(data.data(), len);
+            if (bytesRead != len) {
+                throw QInstaller::Error(tr("Read failed after %1 bytes: %2")
+                    .arg(QString::number(copied), resource->errorString()));
+            }
+            const qint64 bytesWritten = out->write(data.constData(), len);
+            if (bytesWritten != len) {
+                throw QInstaller::Error(tr("Write failed after %1 bytes: %2")
+                    .arg(QString::number(copied), out->errorString()));
+            }
+            copied += len;
         }
-        left -= len;
     }
+    resource->seek(size);
 }
 
 
@@ -64,12 +64,17 @@ public:
     bool seek(qint64 pos);
     qint64 size() const;
 
+    QString path() const;
+
     QByteArray name() const;
     void setName(const QByteArray &name);
 
     Range<qint64> segment() const { return m_segment; }
     void setSegment(const Range<qint64> &segment) { m_segment = segment; }
 
+    bool isMapped() const { return m_map != nullptr; }
+    const uchar *mappedData() const { return m_map; }
+
     void copyData(QFileDevice *out) { copyData(this, out); }
     static void copyData(Resource *archive, QFileDevice *out);
 
@@ -84,6 +89,7 @@ private:
     QFSFileEngine m_file;
     QByteArray m_name;
     Range<qint64> m_segment;
+    uchar *m_map;
 };
 
 
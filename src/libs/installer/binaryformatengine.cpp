@@ -28,6 +28,8 @@
 
 #include "binaryformatengine.h"
 
+#include "errors.h"
+
 #include <QRegExp>
 
 namespace {
@@ -74,6 +76,10 @@ namespace QInstaller {
     \inmodule QtInstallerFramework
     \brief The BinaryFormatEngine class is the default file engine for accessing resource
         collections and resource files.
+
+    Each engine reads through its own copy of the resource, so several files opened on the same
+    resource or on different resources of one installer binary can be read concurrently, for
+    example from parallel extraction threads.
 */
 
 /*!
@@ -108,7 +114,14 @@ void BinaryFormatEngine::setFileName(const QString &file)
 
     m_collection = m_collections.value(path.section(sep, 0, 0).toUtf8());
     m_collection.setName(path.section(sep, 0, 0).toUtf8());
-    m_resource = m_collection.resourceByName(path.section(sep, 1, 1).toUtf8());
+    m_resource.reset();
+    const QSharedPointer<Resource> resource = m_collection.resourceByName(path.section(sep, 1, 1)
+        .toUtf8());
+    if (resource) {
+        // do not share the open state and read position of the registered resource
+        m_resource.reset(new Resource(resource->path(), resource->segment()));
+        m_resource->setName(resource->name());
+    }
 }
 
 /*!
@@ -191,28 +204,18 @@ bool BinaryFormatEngine::copy(const QString &newName)
     if (!target.open(QIODevice::WriteOnly))
         return false;
 
-    qint64 bytesLeft = size();
     if (!open(QIODevice::ReadOnly))
         return false;
 
-    char data[4096];
-    while(bytesLeft > 0) {
-        const qint64 len = qMin<qint64>(bytesLeft, 4096);
-        const qint64 bytesRead = read(data, len);
-        if (bytesRead != len) {
-            close();
-            return false;
-        }
-        const qint64 bytesWritten = target.write(data, len);
-        if (bytesWritten != len) {
-            close();
-            return false;
-        }
-        bytesLeft -= len;
+    bool result = true;
+    try {
+        m_resource->copyData(&target);
+    } catch (const Error &) {
+        result = false;
     }
     close();
 
-    return true;
+    return result;
 }
 
 /*!
@@ -0,0 +1,147 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "checksumverifier.h"
+
+#include "utils.h"
+
+#include <QCoreApplication>
+#include <QIODevice>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ChecksumVerifier
+    \internal
+    \brief The ChecksumVerifier class verifies the checksum of an archive while it is extracted.
+
+    The decoder reads the archive anyway, so the checksum is calculated from the same bytes
+    instead of reading the whole archive a second time up front. Data passed to addData()
+    extends the checksum only where it continues the bytes hashed so far; reads behind or
+    ahead of that position, like the header lookups of 7z archives, are ignored. verify()
+    reads whatever was skipped from the device and compares the result.
+
+    The class is thread-safe, several extracting threads can pass the data they read.
+*/
+
+/*!
+    Constructs a verifier for the hex encoded SHA-1 or SHA-256 \a checksum.
+    The algorithm is chosen by the length of \a checksum.
+*/
+ChecksumVerifier::ChecksumVerifier(const QByteArray &checksum)
+    : m_hash(checksumAlgorithmForHex(checksum))
+    , m_expected(checksum.trimmed().toLower())
+    , m_hashedBytes(0)
+    , m_rereadBytes(0)
+{
+}
+
+/*!
+    Returns \c true if \a checksum is a hex encoded SHA-1 or SHA-256 checksum.
+*/
+bool ChecksumVerifier::isValidChecksum(const QByteArray &checksum)
+{
+    const QByteArray trimmed = checksum.trimmed();
+    if (trimmed.size() != 40 && trimmed.size() != 64)
+        return false;
+    return QByteArray::fromHex(trimmed).toHex() == trimmed.toLower();
+}
+
+/*!
+    Adds \a length bytes of \a data read at \a offset of the archive.
+*/
+void ChecksumVerifier::addData(qint64 offset, const char *data, qint64 length)
+{
+    QMutexLocker _(&m_mutex);
+    if (offset > m_hashedBytes || offset + length <= m_hashedBytes)
+        return;
+
+    const qint64 skip = m_hashedBytes - offset;
+    m_hash.addData(data + skip, int(length - skip));
+    m_hashedBytes += length - skip;
+}
+
+/*!
+    Hashes the data of \a device not passed to addData() and returns \c true if the
+    checksum matches; otherwise returns \c false and sets an error string.
+    The position of \a device is changed.
+*/
+bool ChecksumVerifier::verify(QIODevice *device)
+{
+    QMutexLocker _(&m_mutex);
+    if (m_hashedBytes < device->size()) {
+        if (!device->seek(m_hashedBytes)) {
+            m_errorString = QCoreApplication::translate("ChecksumVerifier",
+                "Cannot read archive for checksum verification: %1").arg(device->errorString());
+            return false;
+        }
+        QByteArray buffer(64 * 1024, Qt::Uninitialized);
+        while (!device->atEnd()) {
+            const qint64 bytesRead = device->read(buffer.data(), buffer.size());
+            if (bytesRead <= 0) {
+                m_errorString = QCoreApplication::translate("ChecksumVerifier",
+                    "Cannot read archive for checksum verification: %1").arg(device->errorString());
+                return false;
+            }
+            m_hash.addData(buffer.constData(), int(bytesRead));
+            m_hashedBytes += bytesRead;
+            m_rereadBytes += bytesRead;
+        }
+    }
+
+    const QByteArray actual = m_hash.result().toHex();
+    if (actual != m_expected) {
+        m_errorString = QCoreApplication::translate("ChecksumVerifier",
+            "Checksum mismatch: expected %1, got %2.").arg(QString::fromLatin1(m_expected),
+            QString::fromLatin1(actual));
+        return false;
+    }
+    return true;
+}
+
+/*!
+    Returns the number of bytes verify() had to read from the device itself, because
+    they were not passed to addData() during extraction.
+*/
+qint64 ChecksumVerifier::bytesReread() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_rereadBytes;
+}
+
+/*!
+    Returns a human-readable description of the last error.
+*/
+QString ChecksumVerifier::errorString() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_errorString;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,69 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef CHECKSUMVERIFIER_H
+#define CHECKSUMVERIFIER_H
+
+#include "installer_global.h"
+
+#include <QCryptographicHash>
+#include <QMutex>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT ChecksumVerifier
+{
+    Q_DISABLE_COPY(ChecksumVerifier)
+
+public:
+    explicit ChecksumVerifier(const QByteArray &checksum);
+
+    static bool isValidChecksum(const QByteArray &checksum);
+
+    void addData(qint64 offset, const char *data, qint64 length);
+    bool verify(QIODevice *device);
+
+    qint64 bytesReread() const;
+    QString errorString() const;
+
+private:
+    mutable QMutex m_mutex;
+    QCryptographicHash m_hash;
+    QByteArray m_expected;
+    qint64 m_hashedBytes;
+    qint64 m_rereadBytes;
+    QString m_errorString;
+};
+
+} // namespace QInstaller
+
+#endif // CHECKSUMVERIFIER_H
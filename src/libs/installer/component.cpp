@@ -32,6 +32,7 @@
 #include "fileutils.h"
 #include "globals.h"
 #include "archivefactory.h"
+#include "checksumverifier.h"
 #include "messageboxhandler.h"
 #include "packagemanagercore.h"
 #include "remoteclient.h"
@@ -326,6 +327,9 @@ void Component::loadDataFromPackage(const Package &package)
     setValue(scInheritVersion, package.data(scInheritVersion).toString());
     setValue(scDependencies, package.data(scDependencies).toString());
     setValue(scDownloadableArchives, package.data(scDownloadableArchives).toString());
+    setValue(scChunkManifests, package.data(scChunkManifests).toString());
+    setValue(scDeltaPatches, package.data(scDeltaPatches).toString());
+    setValue(scDeltaPatchFrom, package.data(scDeltaPatchFrom).toString());
     setValue(scVirtual, package.data(scVirtual).toString());
     setValue(scSortingPriority, package.data(scSortingPriority).toString());
 
@@ -810,7 +814,8 @@ void Component::createOperationsForPath(const QString &path)
     const QFileInfo fi(path);
 
     // don't copy over a checksum file
-    if (fi.suffix() == QLatin1String("sha1") && QFileInfo(fi.dir(), fi.completeBaseName()).exists())
+    if ((fi.suffix() == QLatin1String("sha1") || fi.suffix() == QLatin1String("sha256"))
+            && QFileInfo(fi.dir(), fi.completeBaseName()).exists())
         return;
 
     // the script can override this method
@@ -856,7 +861,8 @@ void Component::createOperationsForArchive(const QString &archive)
     const QFileInfo fi(archive);
 
     // don't do anything with sha1 files
-    if (fi.suffix() == QLatin1String("sha1") && QFileInfo(fi.dir(), fi.completeBaseName()).exists())
+    if ((fi.suffix() == QLatin1String("sha1") || fi.suffix() == QLatin1String("sha256"))
+            && QFileInfo(fi.dir(), fi.completeBaseName()).exists())
         return;
 
     // the script can override this method
@@ -870,10 +876,23 @@ void Component::createOperationsForArchive(const QString &archive)
 
     if (isZip) {
         // component.xml can override this value
+        QStringList arguments = QStringList() << archive;
         if (m_archivesHash.contains(archive))
-            addOperation(QLatin1String("Extract"), QStringList() << archive << m_archivesHash.value(archive));
+            arguments << m_archivesHash.value(archive);
         else
-            addOperation(QLatin1String("Extract"), QStringList() << archive << m_defaultArchivePath);
+            arguments << m_defaultArchivePath;
+
+        // let the extraction verify the archive against its checksum file, if there is one
+        foreach (const QString &suffix, QStringList() << QLatin1String(".sha256") << QLatin1String(".sha1")) {
+            QFile checksumFile(archive + suffix);
+            if (!checksumFile.open(QIODevice::ReadOnly))
+                continue;
+            const QByteArray checksum = checksumFile.read(128).trimmed();
+            if (ChecksumVerifier::isValidChecksum(checksum))
+                arguments << QString::fromLatin1(checksum);
+            break;
+        }
+        addOperation(QLatin1String("Extract"), arguments);
     } else {
         createOperationsForPath(archive);
     }
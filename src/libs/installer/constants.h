@@ -49,6 +49,9 @@ static const QLatin1String scRemoteDisplayVersion("RemoteDisplayVersion");
 static const QLatin1String scInheritVersion("inheritVersionFrom");
 static const QLatin1String scReplaces("Replaces");
 static const QLatin1String scDownloadableArchives("DownloadableArchives");
+static const QLatin1String scChunkManifests("ChunkManifests");
+static const QLatin1String scDeltaPatches("DeltaPatches");
+static const QLatin1String scDeltaPatchFrom("DeltaPatchFrom");
 static const QLatin1String scEssential("Essential");
 static const QLatin1String scForcedUpdate("ForcedUpdate");
 static const QLatin1String scTargetDir("TargetDir");
@@ -67,6 +70,8 @@ static const QLatin1String scUncompressedSizeSum("UncompressedSizeSum");
 static const QLatin1String scRequiresAdminRights("RequiresAdminRights");
 static const QLatin1String scOfflineBinaryName("OfflineBinaryName");
 static const QLatin1String scSHA1("SHA1");
+static const QLatin1String scSHA256("SHA256");
+static const QLatin1String scChecksumType("ChecksumType");
 static const QLatin1String scContentSha1("ContentSha1");
 
 // constants used throughout the components class
@@ -100,6 +105,7 @@ static const QLatin1String scWizardMinimumHeight("WizardMinimumHeight");
 static const QLatin1String scWizardShowPageList("WizardShowPageList");
 static const QLatin1String scProductImages("ProductImages");
 static const QLatin1String scUrlQueryString("UrlQueryString");
+static const QLatin1String scArchiveCacheDirectory("ArchiveCacheDirectory");
 static const QLatin1String scProductUUID("ProductUUID");
 static const QLatin1String scAllUsers("AllUsers");
 static const QLatin1String scSupportsModify("SupportsModify");
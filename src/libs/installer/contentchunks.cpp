@@ -0,0 +1,297 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "contentchunks.h"
+
+#include "fileutils.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QIODevice>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ContentChunk
+    \internal
+    \brief The ContentChunk class describes a chunk of a file found by ContentChunker.
+*/
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ContentChunker
+    \internal
+    \brief The ContentChunker class splits file contents into content-defined chunks.
+
+    The chunk boundaries are found with a gear rolling hash over the content, so they only
+    depend on the bytes close to them. Inserting or removing data in a file moves the
+    boundaries with it, and the chunks before and after the change keep their hashes. This
+    allows the maintenance tool to rebuild a new version of a file from the chunks of the
+    installed version and only download the chunks that changed.
+*/
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ChunkManifest
+    \internal
+    \brief The ChunkManifest class lists the files of an archive and the chunks they consist of.
+
+    Manifests are created by repogen --chunk-manifests next to each component archive, and
+    the chunks are stored once per repository below the path returned by
+    ContentChunker::chunkPath().
+*/
+
+const qint64 ContentChunker::MinimumChunkSize;
+const qint64 ContentChunker::MaximumChunkSize;
+
+// a boundary is set where the top bits of the hash are zero, on average every 1 MB
+static const quint64 scBoundaryMask = Q_UINT64_C(0xfffff00000000000);
+
+/*
+    Returns the random values mixed into the rolling hash for each byte value. They are
+    generated from a fixed seed, repogen and the maintenance tool must find the same chunks.
+*/
+static const quint64 *gearTable()
+{
+    static const QVector<quint64> table = [] {
+        QVector<quint64> values(256);
+        quint64 state = Q_UINT64_C(0x5176e6c7f1d2a3b4);
+        for (int i = 0; i < values.count(); ++i) {
+            // splitmix64
+            quint64 value = (state += Q_UINT64_C(0x9e3779b97f4a7c15));
+            value = (value ^ (value >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+            value = (value ^ (value >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+            values[i] = value ^ (value >> 31);
+        }
+        return values;
+    }();
+    return table.constData();
+}
+
+/*!
+    Reads \a device to its end and returns the chunks of its content, with their hex encoded
+    SHA-1 hashes. If \a contentHash is not \c nullptr, it is set to the hex encoded SHA-1
+    hash of the whole content.
+*/
+QVector<ContentChunk> ContentChunker::chunk(QIODevice *device, QByteArray *contentHash)
+{
+    const quint64 *const gear = gearTable();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    QVector<ContentChunk> chunks;
+    QByteArray buffer;
+    qint64 offset = 0;
+    forever {
+        while (buffer.size() < MaximumChunkSize && !device->atEnd()) {
+            const QByteArray data = device->read(MaximumChunkSize - buffer.size());
+            if (data.isEmpty())
+                break;
+            buffer.append(data);
+        }
+        if (buffer.isEmpty())
+            break;
+
+        int size = buffer.size();
+        if (size > MinimumChunkSize) {
+            const uchar *const data = reinterpret_cast<const uchar *>(buffer.constData());
+            const int end = int(qMin<qint64>(size, MaximumChunkSize));
+            size = end;
+            quint64 rolling = 0;
+            for (int i = MinimumChunkSize; i < end; ++i) {
+                rolling = (rolling << 1) + gear[data[i]];
+                if (!(rolling & scBoundaryMask)) {
+                    size = i + 1;
+                    break;
+                }
+            }
+        }
+
+        ContentChunk chunk;
+        chunk.offset = offset;
+        chunk.size = size;
+        chunk.hash = QCryptographicHash::hash(QByteArray::fromRawData(buffer.constData(), size),
+            QCryptographicHash::Sha1).toHex();
+        chunks.append(chunk);
+
+        hash.addData(buffer.constData(), size);
+        buffer.remove(0, size);
+        offset += size;
+    }
+    if (contentHash)
+        *contentHash = hash.result().toHex();
+    return chunks;
+}
+
+/*!
+    Returns the path of the chunk with the hex encoded \a hash, relative to the repository.
+*/
+QString ContentChunker::chunkPath(const QByteArray &hash)
+{
+    return QString::fromLatin1("chunks/%1/%2").arg(QString::fromLatin1(hash.left(2)),
+        QString::fromLatin1(hash));
+}
+
+/*!
+    Returns the files and directories listed in the manifest.
+*/
+QVector<ChunkManifest::Entry> ChunkManifest::entries() const
+{
+    return m_entries;
+}
+
+/*!
+    Adds the file or directory \a entry to the manifest.
+*/
+void ChunkManifest::addEntry(const Entry &entry)
+{
+    m_entries.append(entry);
+}
+
+/*
+    Returns whether \a hash is a lower case hex encoded SHA-1 hash. Chunk hashes end up in file
+    names and urls, so nothing else is accepted.
+*/
+static bool isSha1Hex(const QByteArray &hash)
+{
+    return hash.size() == 40 && QByteArray::fromHex(hash).toHex() == hash;
+}
+
+/*!
+    Reads the manifest from \a device. Returns \c false and sets the error string if the
+    manifest is invalid. Entries must have relative paths that do not leave the directory the
+    archive is rebuilt in, and all hashes must be hex encoded SHA-1 hashes.
+*/
+bool ChunkManifest::read(QIODevice *device)
+{
+    m_entries.clear();
+    m_errorString.clear();
+
+    QXmlStreamReader reader(device);
+    if (!reader.readNextStartElement() || reader.name() != QLatin1String("ChunkManifest"))
+        reader.raiseError(QCoreApplication::translate("ChunkManifest", "Unexpected root element."));
+
+    while (!reader.hasError() && reader.readNextStartElement()) {
+        Entry entry;
+        const QXmlStreamAttributes attributes = reader.attributes();
+        entry.path = attributes.value(QLatin1String("path")).toString();
+        entry.permissions = QFile::Permissions(attributes.value(QLatin1String("permissions"))
+            .toString().toInt(nullptr, 16));
+        if (reader.name() == QLatin1String("Directory")) {
+            entry.isDirectory = true;
+            reader.skipCurrentElement();
+        } else if (reader.name() == QLatin1String("File")) {
+            entry.size = attributes.value(QLatin1String("size")).toLongLong();
+            entry.hash = attributes.value(QLatin1String("sha1")).toLatin1();
+            qint64 offset = 0;
+            while (reader.readNextStartElement()) {
+                ContentChunk chunk;
+                chunk.offset = offset;
+                chunk.size = reader.attributes().value(QLatin1String("size")).toLongLong();
+                chunk.hash = reader.readElementText().toLatin1();
+                if (!isSha1Hex(chunk.hash)) {
+                    reader.raiseError(QCoreApplication::translate("ChunkManifest",
+                        "Invalid chunk hash in \"%1\".").arg(entry.path));
+                    break;
+                }
+                entry.chunks.append(chunk);
+                offset += chunk.size;
+            }
+            if (reader.hasError()) {
+                break;
+            } else if (!isSha1Hex(entry.hash)) {
+                reader.raiseError(QCoreApplication::translate("ChunkManifest",
+                    "Invalid hash of \"%1\".").arg(entry.path));
+            } else if (offset != entry.size) {
+                reader.raiseError(QCoreApplication::translate("ChunkManifest",
+                    "The chunks of \"%1\" do not match its size.").arg(entry.path));
+            }
+        } else {
+            reader.skipCurrentElement();
+            continue;
+        }
+        if (reader.hasError()) {
+            break;
+        } else if (entry.path.isEmpty()) {
+            reader.raiseError(QCoreApplication::translate("ChunkManifest",
+                "Entry without path."));
+        } else if (!isContainedRelativePath(entry.path)) {
+            reader.raiseError(QCoreApplication::translate("ChunkManifest",
+                "Invalid path \"%1\".").arg(entry.path));
+        }
+        m_entries.append(entry);
+    }
+
+    if (reader.hasError()) {
+        m_errorString = reader.errorString();
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    Writes the manifest to \a device.
+*/
+void ChunkManifest::write(QIODevice *device) const
+{
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement(QLatin1String("ChunkManifest"));
+    foreach (const Entry &entry, m_entries) {
+        writer.writeStartElement(entry.isDirectory ? QLatin1String("Directory") : QLatin1String("File"));
+        writer.writeAttribute(QLatin1String("path"), entry.path);
+        writer.writeAttribute(QLatin1String("permissions"), QString::number(int(entry.permissions), 16));
+        if (!entry.isDirectory) {
+            writer.writeAttribute(QLatin1String("size"), QString::number(entry.size));
+            writer.writeAttribute(QLatin1String("sha1"), QString::fromLatin1(entry.hash));
+            foreach (const ContentChunk &chunk, entry.chunks) {
+                writer.writeStartElement(QLatin1String("Chunk"));
+                writer.writeAttribute(QLatin1String("size"), QString::number(chunk.size));
+                writer.writeCharacters(QString::fromLatin1(chunk.hash));
+                writer.writeEndElement();
+            }
+        }
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+    writer.writeEndDocument();
+}
+
+/*!
+    Returns a human-readable description of the last error that occurred.
+*/
+QString ChunkManifest::errorString() const
+{
+    return m_errorString;
+}
+
+} // namespace QInstaller
@@ -28,6 +28,10 @@
 
 #include "copydirectoryoperation.h"
 
+#include "errors.h"
+#include "fileutils.h"
+#include "remotefileoperations.h"
+
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
 #include <QtCore/QFileInfo>
@@ -100,6 +104,8 @@ bool CopyDirectoryOperation::performOperation()
     const QDir targetDir = targetInfo.absoluteDir();
 
     AutoPush autoPush(this);
+    // copies the files in the server process during elevated installations
+    RemoteFileOperations operations;
     QDirIterator it(sourceInfo.absoluteFilePath(), QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden,
         QDirIterator::Subdirectories);
     while (it.hasNext()) {
@@ -135,13 +141,17 @@ bool CopyDirectoryOperation::performOperation()
                 setErrorString(tr("Failed to overwrite \"%1\".").arg(QDir::toNativeSeparators(absolutePath)));
                 return false;
             }
-            QFile file(sourceDir.absoluteFilePath(itemName));
-            if (!file.copy(absolutePath)) {
+            QString copyError;
+            if (QFile::exists(absolutePath))
+                copyError = tr("Destination file exists");
+            else if (!operations.copyFile(sourceDir.absoluteFilePath(itemName), absolutePath))
+                copyError = operations.errorString();
+            if (!copyError.isEmpty()) {
                 setError(UserDefinedError);
                 setErrorString(tr("Cannot copy file \"%1\" to \"%2\": %3").arg(
                                    QDir::toNativeSeparators(sourceDir.absoluteFilePath(itemName)),
                                    QDir::toNativeSeparators(targetDir.absoluteFilePath(relativePath)),
-                                   file.errorString()));
+                                   copyError));
                 return false;
             }
             autoPush.m_files.prepend(targetDir.absoluteFilePath(relativePath));
@@ -36,6 +36,70 @@
 
 namespace QInstaller {
 
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::DirectoryCache
+    \brief The DirectoryCache class remembers directories known to exist during an extraction.
+
+    Archives list many entries per directory. Sharing a cache between the DirectoryGuard
+    objects of one extraction makes sure every directory is checked for and created on
+    disk only once, instead of once per entry.
+
+    The cache is not thread-safe, every thread needs a copy of its own.
+*/
+
+/*!
+    Constructs an empty cache.
+*/
+DirectoryCache::DirectoryCache()
+    : m_fileSystemAccessCount(0)
+{
+}
+
+/*!
+    Returns \c true if the directory \a path is known to exist.
+*/
+bool DirectoryCache::contains(const QString &path) const
+{
+    return m_directories.contains(path);
+}
+
+/*!
+    Remembers that the directory \a path exists.
+*/
+void DirectoryCache::insert(const QString &path)
+{
+    m_directories.insert(path);
+}
+
+/*!
+    Adds the directories known to the cache \a other to this cache, for example to
+    collect the directories seen by the threads of a parallel extraction. The file system
+    access count is not changed.
+*/
+void DirectoryCache::unite(const DirectoryCache &other)
+{
+    m_directories.unite(other.m_directories);
+}
+
+/*!
+    Forgets all directories, to be called before a new extraction starts.
+*/
+void DirectoryCache::clear()
+{
+    m_directories.clear();
+    m_fileSystemAccessCount = 0;
+}
+
+/*!
+    Returns the number of times the guards using this cache checked for or created
+    a directory on disk since the cache was created or cleared.
+*/
+int DirectoryCache::fileSystemAccessCount() const
+{
+    return m_fileSystemAccessCount;
+}
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::DirectoryGuard
@@ -43,10 +107,13 @@ namespace QInstaller {
 */
 
 /*!
-    Constructs a new guard object for \a path.
+    Constructs a new guard object for \a path. If \a cache is set, directories known
+    to the cache are not checked on disk again, and created directories are added to
+    the cache when the guard is released.
 */
-DirectoryGuard::DirectoryGuard(const QString &path)
+DirectoryGuard::DirectoryGuard(const QString &path, DirectoryCache *cache)
     : m_path(path)
+    , m_cache(cache)
     , m_created(false)
     , m_released(false)
 {
@@ -74,30 +141,51 @@ QStringList DirectoryGuard::tryCreate()
 {
     if (m_path.isEmpty())
         return QStringList();
+    if (m_cache && m_cache->contains(m_path))
+        return QStringList();
 
     const QFileInfo fi(m_path);
-    if (fi.exists() && fi.isDir())
+    if (m_cache)
+        ++m_cache->m_fileSystemAccessCount;
+    if (fi.exists() && fi.isDir()) {
+        if (m_cache)
+            m_cache->insert(m_path);
         return QStringList();
+    }
     if (fi.exists() && !fi.isDir()) {
         throw Error(QCoreApplication::translate("DirectoryGuard",
             "Path \"%1\" exists but is not a directory.").arg(QDir::toNativeSeparators(m_path)));
     }
     QStringList created;
 
-    QDir toCreate(m_path);
-    while (!toCreate.exists()) {
-        QString p = toCreate.absolutePath();
+    // walk up to the first directory that exists, or is known to exist
+    QString p = QDir(m_path).absolutePath();
+    forever {
         created.push_front(p);
         p = p.section(QLatin1Char('/'), 0, -2);
-        toCreate = QDir(p);
+        if (p.isEmpty() || (m_cache && m_cache->contains(p)))
+            break;
+        if (m_cache)
+            ++m_cache->m_fileSystemAccessCount;
+        if (QFileInfo(p).isDir()) {
+            if (m_cache)
+                m_cache->insert(p);
+            break;
+        }
     }
 
-    QDir dir(m_path);
-    m_created = dir.mkpath(m_path);
-    if (!m_created) {
-        throw Error(QCoreApplication::translate("DirectoryGuard",
-            "Cannot create directory \"%1\".").arg(QDir::toNativeSeparators(m_path)));
+    // create the missing directories one by one, mkpath() would check all of them again
+    QDir dir;
+    foreach (const QString &directory, created) {
+        if (m_cache)
+            ++m_cache->m_fileSystemAccessCount;
+        if (!dir.mkdir(directory) && !QFileInfo(directory).isDir()) {
+            throw Error(QCoreApplication::translate("DirectoryGuard",
+                "Cannot create directory \"%1\".").arg(QDir::toNativeSeparators(directory)));
+        }
     }
+    m_created = true;
+    m_createdDirectories = created;
     return created;
 }
 
@@ -107,6 +195,10 @@ QStringList DirectoryGuard::tryCreate()
 void DirectoryGuard::release()
 {
     m_released = true;
+    if (m_cache) {
+        foreach (const QString &directory, m_createdDirectories)
+            m_cache->insert(directory);
+    }
 }
 
 } // namespace QInstaller
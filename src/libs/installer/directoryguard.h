@@ -31,14 +31,35 @@
 
 #include "installer_global.h"
 
+#include <QSet>
 #include <QString>
+#include <QStringList>
 
 namespace QInstaller {
 
+class INSTALLER_EXPORT DirectoryCache
+{
+public:
+    DirectoryCache();
+
+    bool contains(const QString &path) const;
+    void insert(const QString &path);
+    void unite(const DirectoryCache &other);
+    void clear();
+
+    int fileSystemAccessCount() const;
+
+private:
+    friend class DirectoryGuard;
+
+    QSet<QString> m_directories;
+    int m_fileSystemAccessCount;
+};
+
 class INSTALLER_EXPORT DirectoryGuard
 {
 public:
-    explicit DirectoryGuard(const QString &path);
+    explicit DirectoryGuard(const QString &path, DirectoryCache *cache = nullptr);
     ~DirectoryGuard();
 
     QStringList tryCreate();
@@ -46,6 +67,8 @@ public:
 
 private:
     QString m_path;
+    DirectoryCache *m_cache;
+    QStringList m_createdDirectories;
     bool m_created;
     bool m_released;
 };
@@ -27,8 +27,12 @@
 **************************************************************************/
 #include "downloadarchivesjob.h"
 
+#include "archivefactory.h"
 #include "binaryformatenginehandler.h"
 #include "component.h"
+#include "errors.h"
+#include "fileio.h"
+#include "globals.h"
 #include "messageboxhandler.h"
 #include "packagemanagercore.h"
 #include "utils.h"
@@ -37,9 +41,15 @@
 #include "filedownloader.h"
 #include "filedownloaderfactory.h"
 
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QSet>
 #include <QtCore/QTimerEvent>
 
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
 using namespace QInstaller;
 using namespace KDUpdater;
 
@@ -58,8 +68,16 @@ DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
     , m_progressChangedTimerId(0)
     , m_totalSizeToDownload(0)
     , m_totalSizeDownloaded(0)
+    , m_copyingFromCache(false)
+    , m_cacheFailed(false)
 {
     setCapabilities(Cancelable);
+    connect(&m_indexWatcher, &QFutureWatcherBase::finished,
+            this, &DownloadArchivesJob::finishedIndexingInstalledChunks);
+    connect(&m_rebuildWatcher, &QFutureWatcherBase::finished,
+            this, &DownloadArchivesJob::finishedRebuildingArchive);
+    connect(&m_patchWatcher, &QFutureWatcherBase::finished,
+            this, &DownloadArchivesJob::finishedApplyingDeltaPatch);
 }
 
 /*!
@@ -67,6 +85,10 @@ DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
 */
 DownloadArchivesJob::~DownloadArchivesJob()
 {
+    m_indexWatcher.cancel();
+    m_indexWatcher.waitForFinished();
+    m_rebuildWatcher.waitForFinished();
+    m_patchWatcher.waitForFinished();
     if (m_downloader)
         m_downloader->deleteLater();
 }
@@ -89,6 +111,28 @@ void DownloadArchivesJob::setExpectedTotalSize(quint64 total)
     m_totalSizeToDownload = total;
 }
 
+/*!
+    Sets the \a installedFiles of the previous version of archives, by the file name the
+    archives are registered with. For these archives the chunk manifest is downloaded first,
+    and only the chunks not found in the installed files are fetched to rebuild the archive.
+    If that fails, the whole archive is downloaded.
+*/
+void DownloadArchivesJob::setInstalledFiles(const QHash<QString, QStringList> &installedFiles)
+{
+    m_installedFiles = installedFiles;
+}
+
+/*!
+    Sets the installed files \a patchedFiles of the previous version of archives that a delta
+    patch was created from, by the file name the archives are registered with. For these
+    archives the patch is downloaded and applied to the installed files. If that fails, the
+    archive is rebuilt from chunks if possible, or downloaded completely.
+*/
+void DownloadArchivesJob::setPatchedFiles(const QHash<QString, QStringList> &patchedFiles)
+{
+    m_patchedFiles = patchedFiles;
+}
+
 /*!
     \reimp
 */
@@ -105,12 +149,25 @@ void DownloadArchivesJob::doStart()
 void DownloadArchivesJob::doCancel()
 {
     m_canceled = true;
+    m_indexWatcher.cancel();
     if (m_downloader != nullptr)
         m_downloader->cancelDownload();
 }
 
 void DownloadArchivesJob::fetchNextArchiveHash()
 {
+    if (!m_canceled && !m_archivesToDownload.isEmpty()) {
+        const QString archive = m_archivesToDownload.first().first;
+        if (m_patchedFiles.contains(archive)) {
+            fetchDeltaPatch();
+            return;
+        }
+        if (m_installedFiles.contains(archive)) {
+            fetchChunkManifest();
+            return;
+        }
+    }
+
     if (m_core->testChecksum()) {
         if (m_canceled) {
             finishWithError(tr("Canceled"));
@@ -125,7 +182,8 @@ void DownloadArchivesJob::fetchNextArchiveHash()
         if (m_downloader)
             m_downloader->deleteLater();
 
-        m_downloader = setupDownloader(QLatin1String(".sha1"));
+        m_downloader = setupDownloader(QLatin1Char('.')
+            + checksumName(repositoryChecksumAlgorithm()).toLower());
         if (!m_downloader) {
             m_archivesToDownload.removeFirst();
             QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
@@ -146,7 +204,7 @@ void DownloadArchivesJob::finishedHashDownload()
 
     QFile sha1HashFile(m_downloader->downloadedFileName());
     if (sha1HashFile.open(QFile::ReadOnly)) {
-        m_currentHash = sha1HashFile.readAll();
+        m_currentHash = sha1HashFile.readAll().trimmed();
         fetchNextArchive();
     } else {
         finishWithError(tr("Downloading hash signature failed."));
@@ -171,13 +229,20 @@ void DownloadArchivesJob::fetchNextArchive()
     if (m_downloader != nullptr)
         m_downloader->deleteLater();
 
-    m_downloader = setupDownloader(QString(), m_core->value(scUrlQueryString));
+    const QString cachedArchive = cachedArchivePath();
+    m_copyingFromCache = !m_cacheFailed && !cachedArchive.isEmpty() && QFileInfo(cachedArchive).isFile();
+    if (m_copyingFromCache)
+        m_downloader = setupCacheDownloader(cachedArchive);
+    else
+        m_downloader = setupDownloader(QString(), m_core->value(scUrlQueryString));
     if (!m_downloader) {
         m_archivesToDownload.removeFirst();
         QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
         return;
     }
 
+    // hashed while downloading, with the algorithm of the checksum file fetched before
+    m_downloader->setCheckSumAlgorithm(checksumAlgorithmForHex(m_currentHash));
     emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
     connect(m_downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
     connect(m_downloader, &FileDownloader::downloadCompleted,
@@ -283,7 +348,16 @@ void DownloadArchivesJob::registerFile()
     if (m_canceled)
         return;
 
-    if (m_core->testChecksum() && m_currentHash != m_downloader->sha1Sum().toHex()) {
+    if (m_core->testChecksum() && m_currentHash != m_downloader->checkSum().toHex()) {
+        if (m_copyingFromCache) {
+            qCWarning(QInstaller::lcInstallerInstallLog) << "Removing" << m_downloader->url().toLocalFile()
+                << "from the archive cache, its checksum does not match.";
+            QFile::remove(m_downloader->url().toLocalFile());
+            m_cacheFailed = true;
+            QMetaObject::invokeMethod(this, "fetchNextArchive", Qt::QueuedConnection);
+            return;
+        }
+
         //TODO: Maybe we should try to download the file again automatically
         const QMessageBox::Button res =
             MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
@@ -307,6 +381,10 @@ void DownloadArchivesJob::registerFile()
             emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
         }
 
+        if (!m_copyingFromCache)
+            storeInCache(m_downloader->downloadedFileName());
+        m_cacheFailed = false;
+
         const QPair<QString, QString> pair = m_archivesToDownload.takeFirst();
         BinaryFormatEngineHandler::instance()->registerResource(pair.first,
             m_downloader->downloadedFileName());
@@ -344,48 +422,696 @@ void DownloadArchivesJob::finishWithError(const QString &error)
     if (dl != nullptr)
         emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, dl->url().toString()));
     else
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, m_downloader->url().toString()));
+        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, m_downloader
+            ? m_downloader->url().toString() : m_archivesToDownload.value(0).second));
+}
+
+/*!
+    Returns the component of the archive that is currently downloaded.
+*/
+const Component *DownloadArchivesJob::currentComponent() const
+{
+    const QFileInfo fi = QFileInfo(m_archivesToDownload.first().first);
+    return m_core->componentByName(PackageManagerCore::checkableName(QFileInfo(fi.path()).fileName()));
+}
+
+/*!
+    Returns the algorithm of the checksum files in the repository of the archive that is
+    currently downloaded. Repositories without a \c ChecksumType element use SHA-1.
+*/
+QCryptographicHash::Algorithm DownloadArchivesJob::repositoryChecksumAlgorithm() const
+{
+    QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha1;
+    if (const Component *const component = currentComponent())
+        checksumAlgorithmFromName(component->value(scChecksumType), &algorithm);
+    return algorithm;
+}
+
+/*!
+    Returns the url of the archive that is currently downloaded, with \a suffix appended to
+    the file name and \a queryString as query.
+*/
+QUrl DownloadArchivesJob::currentUrl(const QString &suffix, const QString &queryString) const
+{
+    QString fullQueryString;
+    if (!queryString.isEmpty())
+        fullQueryString = QLatin1String("?") + queryString;
+    return QUrl(m_archivesToDownload.first().second + suffix + fullQueryString);
+}
+
+/*!
+    Creates a downloader for \a url using the credentials of \a component. The file is
+    downloaded to \a fileName if the scheme of \a url supports it. Returns \c nullptr if
+    the scheme is not supported.
+*/
+KDUpdater::FileDownloader *DownloadArchivesJob::createDownloader(const Component *component,
+    const QUrl &url, const QString &fileName)
+{
+    const QString &scheme = url.scheme();
+    KDUpdater::FileDownloader *downloader = FileDownloaderFactory::instance().create(scheme, this);
+    if (!downloader)
+        return nullptr;
+
+    downloader->setUrl(url);
+    downloader->setAutoRemoveDownloadedFile(false);
+
+    QAuthenticator auth;
+    auth.setUser(component->value(QLatin1String("username")));
+    auth.setPassword(component->value(QLatin1String("password")));
+    downloader->setAuthenticator(auth);
+
+    connect(downloader, &FileDownloader::downloadCanceled, this, &DownloadArchivesJob::downloadCanceled);
+    connect(downloader, &FileDownloader::downloadStatus, this, &DownloadArchivesJob::onDownloadStatusChanged);
+
+    if (FileDownloaderFactory::isSupportedScheme(scheme))
+        downloader->setDownloadedFileName(fileName);
+    return downloader;
 }
 
 KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &suffix, const QString &queryString)
 {
     KDUpdater::FileDownloader *downloader = nullptr;
     const QFileInfo fi = QFileInfo(m_archivesToDownload.first().first);
-    const Component *const component = m_core->componentByName(PackageManagerCore::checkableName(QFileInfo(fi.path()).fileName()));
+    const Component *const component = currentComponent();
     if (component) {
-        QString fullQueryString;
-        if (!queryString.isEmpty())
-            fullQueryString = QLatin1String("?") + queryString;
-        const QUrl url(m_archivesToDownload.first().second + suffix + fullQueryString);
-        const QString &scheme = url.scheme();
-        downloader = FileDownloaderFactory::instance().create(scheme, this);
+        const QUrl url = currentUrl(suffix, queryString);
+        downloader = createDownloader(component, url, component->localTempPath() + QLatin1Char('/')
+            + component->name() + QLatin1Char('/') + fi.fileName() + suffix);
 
         if (downloader) {
-            downloader->setUrl(url);
-            downloader->setAutoRemoveDownloadedFile(false);
-
-            QAuthenticator auth;
-            auth.setUser(component->value(QLatin1String("username")));
-            auth.setPassword(component->value(QLatin1String("password")));
-            downloader->setAuthenticator(auth);
-
-            connect(downloader, &FileDownloader::downloadCanceled, this, &DownloadArchivesJob::downloadCanceled);
             connect(downloader, &FileDownloader::downloadAborted, this, &DownloadArchivesJob::downloadFailed,
                 Qt::QueuedConnection);
-            connect(downloader, &FileDownloader::downloadStatus, this, &DownloadArchivesJob::onDownloadStatusChanged);
-
-            if (FileDownloaderFactory::isSupportedScheme(scheme)) {
-                downloader->setDownloadedFileName(component->localTempPath() + QLatin1Char('/')
-                    + component->name() + QLatin1Char('/') + fi.fileName() + suffix);
-            }
 
             emit outputTextChanged(tr("Downloading archive \"%1\" for component %2.")
                 .arg(fi.fileName() + suffix, component->displayName()));
         } else {
-            emit outputTextChanged(tr("Scheme %1 not supported (URL: %2).").arg(scheme, url.toString()));
+            emit outputTextChanged(tr("Scheme %1 not supported (URL: %2).").arg(url.scheme(), url.toString()));
         }
     } else {
         emit outputTextChanged(tr("Cannot find component for %1.").arg(QFileInfo(fi.path()).fileName()));
     }
     return downloader;
 }
+
+/*!
+    Returns the path of the current archive in the archive cache directory, where archives
+    are stored by their checksum. Returns an empty string if no cache directory is set or
+    the checksum of the archive is not known.
+*/
+QString DownloadArchivesJob::cachedArchivePath() const
+{
+    const QString directory = m_core->replaceVariables(m_core->value(scArchiveCacheDirectory));
+    if (directory.isEmpty() || !m_core->testChecksum() || m_currentHash.isEmpty())
+        return QString();
+
+    // the checksum is read from the repository, do not let it point anywhere else
+    const QByteArray hash = m_currentHash.toLower();
+    if (QByteArray::fromHex(hash).toHex() != hash)
+        return QString();
+
+    return QString::fromLatin1("%1/%2/%3/%4").arg(directory,
+        checksumName(checksumAlgorithmForHex(hash)).toLower(), QString::fromLatin1(hash.left(2)),
+        QString::fromLatin1(hash));
+}
+
+/*!
+    Creates a downloader copying the current archive from \a cachedArchive. If that fails,
+    the archive is downloaded from the repository.
+*/
+KDUpdater::FileDownloader *DownloadArchivesJob::setupCacheDownloader(const QString &cachedArchive)
+{
+    const Component *const component = currentComponent();
+    if (!component)
+        return setupDownloader(QString(), m_core->value(scUrlQueryString));
+
+    KDUpdater::FileDownloader *downloader = createDownloader(component,
+        QUrl::fromLocalFile(cachedArchive), localArchivePath());
+    if (downloader) {
+        connect(downloader, &FileDownloader::downloadAborted, this, &DownloadArchivesJob::cacheCopyFailed,
+            Qt::QueuedConnection);
+        emit outputTextChanged(tr("Copying archive \"%1\" for component %2 from the archive cache.")
+            .arg(QFileInfo(m_archivesToDownload.first().first).fileName(), component->displayName()));
+    }
+    return downloader;
+}
+
+void DownloadArchivesJob::cacheCopyFailed(const QString &error)
+{
+    if (m_canceled)
+        return;
+
+    qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot copy" << m_downloader->url().toLocalFile()
+        << "from the archive cache:" << error;
+    m_cacheFailed = true;
+    QMetaObject::invokeMethod(this, "fetchNextArchive", Qt::QueuedConnection);
+}
+
+/*!
+    Stores the downloaded archive \a fileName in the archive cache directory, if it is set and
+    does not contain the archive yet. Failing to do so does not affect the installation.
+*/
+void DownloadArchivesJob::storeInCache(const QString &fileName) const
+{
+    const QString cachedArchive = cachedArchivePath();
+    if (cachedArchive.isEmpty() || QFileInfo::exists(cachedArchive))
+        return;
+
+    // copied under a temporary name first, other installers must never see partial archives
+    QString temporaryFile;
+    try {
+        QInstaller::mkpath(QFileInfo(cachedArchive).absolutePath());
+        temporaryFile = generateTemporaryFileName(cachedArchive);
+        // the name is reserved by creating the file, it is ours to replace
+        QInstaller::copyFile(fileName, temporaryFile, nullptr, OverwriteFile);
+        // fails if another installer stored the archive in the meantime
+        if (!QFile::rename(temporaryFile, cachedArchive))
+            QFile::remove(temporaryFile);
+    } catch (const Error &e) {
+        if (!temporaryFile.isEmpty())
+            QFile::remove(temporaryFile);
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot store" << fileName
+            << "in the archive cache:" << e.message();
+    }
+}
+
+/*!
+    Creates a downloader for the delta patch, the chunk manifest or a chunk at \a url, stored
+    as \a fileName. Failing downloads fall back to downloading the whole archive.
+*/
+KDUpdater::FileDownloader *DownloadArchivesJob::setupChunkDownloader(const QUrl &url, const QString &fileName)
+{
+    const Component *const component = currentComponent();
+    if (!component)
+        return nullptr;
+
+    KDUpdater::FileDownloader *downloader = createDownloader(component, url, fileName);
+    if (downloader) {
+        connect(downloader, &FileDownloader::downloadAborted, this, &DownloadArchivesJob::chunkDownloadFailed,
+            Qt::QueuedConnection);
+    }
+    return downloader;
+}
+
+/*!
+    Fetches the chunk manifest of the next archive, to rebuild it from the installed files
+    of its previous version.
+*/
+void DownloadArchivesJob::fetchChunkManifest()
+{
+    if (m_downloader)
+        m_downloader->deleteLater();
+
+    const Component *const component = currentComponent();
+    const QFileInfo fi(m_archivesToDownload.first().first);
+    if (component) {
+        m_chunkDirectory = component->localTempPath() + QLatin1Char('/') + component->name()
+            + QLatin1Char('/') + fi.fileName() + QLatin1String(".chunks.d");
+    }
+    m_downloader = setupChunkDownloader(currentUrl(QLatin1String(".chunks"),
+        m_core->value(scUrlQueryString)), m_chunkDirectory + QLatin1String(".xml"));
+    if (!m_downloader) {
+        fallBack();
+        return;
+    }
+
+    emit outputTextChanged(tr("Downloading changes of archive \"%1\" for component %2.")
+        .arg(fi.fileName(), component->displayName()));
+    connect(m_downloader, &FileDownloader::downloadCompleted,
+            this, &DownloadArchivesJob::finishedChunkManifestDownload, Qt::QueuedConnection);
+    m_downloader->download();
+}
+
+void DownloadArchivesJob::finishedChunkManifestDownload()
+{
+    Q_ASSERT(m_downloader != nullptr);
+
+    if (m_canceled)
+        return;
+
+    QFile manifestFile(m_downloader->downloadedFileName());
+    const bool valid = manifestFile.open(QIODevice::ReadOnly) && m_chunkManifest.read(&manifestFile);
+    manifestFile.close();
+    manifestFile.remove();
+    if (!valid) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot read chunk manifest"
+            << m_downloader->url().toString() << ":" << m_chunkManifest.errorString();
+        fallBack();
+        return;
+    }
+
+    if (!QDir().mkpath(m_chunkDirectory)) {
+        fallBack();
+        return;
+    }
+    indexInstalledChunks(m_installedFiles.value(m_archivesToDownload.first().first));
+}
+
+void DownloadArchivesJob::finishedIndexingInstalledChunks()
+{
+    if (m_canceled) {
+        finishWithError(tr("Canceled"));
+        return;
+    }
+
+    m_localChunks = m_indexWatcher.result();
+    QSet<QByteArray> chunks;
+    qint64 reusedSize = 0;
+    foreach (const ChunkManifest::Entry &entry, m_chunkManifest.entries()) {
+        foreach (const ContentChunk &chunk, entry.chunks) {
+            if (m_localChunks.contains(chunk.hash)) {
+                reusedSize += chunk.size;
+            } else if (!chunks.contains(chunk.hash)) {
+                chunks.insert(chunk.hash);
+                m_chunksToDownload.append(chunk.hash);
+            }
+        }
+    }
+    qCDebug(QInstaller::lcInstallerInstallLog) << "Reusing" << humanReadableSize(reusedSize)
+        << "of installed files, downloading" << m_chunksToDownload.count() << "chunks for"
+        << m_archivesToDownload.first().first;
+    fetchNextChunk();
+}
+
+/*
+    The chunks of an installed file.
+*/
+struct InstalledFileChunks
+{
+    QString path;
+    QVector<ContentChunk> chunks;
+};
+
+static InstalledFileChunks chunkInstalledFile(const QString &path)
+{
+    InstalledFileChunks result;
+    result.path = path;
+    QFile file(path);
+    if (QFileInfo(path).isFile() && file.open(QIODevice::ReadOnly))
+        result.chunks = ContentChunker::chunk(&file);
+    return result;
+}
+
+/*
+    Remembers where the chunks of the installed \a file can be read from in \a localChunks.
+*/
+static void addInstalledFileChunks(QHash<QByteArray, QPair<QString, qint64> > &localChunks,
+    const InstalledFileChunks &file)
+{
+    foreach (const ContentChunk &chunk, file.chunks)
+        localChunks.insert(chunk.hash, qMakePair(file.path, chunk.offset));
+}
+
+/*!
+    Starts splitting the installed \a files into chunks, in parallel and off the calling
+    thread, to find out where each chunk can be read from. Continues with
+    finishedIndexingInstalledChunks() when done.
+*/
+void DownloadArchivesJob::indexInstalledChunks(const QStringList &files)
+{
+    m_localChunks.clear();
+    m_indexWatcher.setFuture(QtConcurrent::mappedReduced(files, chunkInstalledFile,
+        addInstalledFileChunks, QtConcurrent::OrderedReduce));
+}
+
+void DownloadArchivesJob::fetchNextChunk()
+{
+    if (m_canceled) {
+        finishWithError(tr("Canceled"));
+        return;
+    }
+
+    if (m_chunksToDownload.isEmpty()) {
+        rebuildArchive();
+        return;
+    }
+
+    if (m_downloader)
+        m_downloader->deleteLater();
+
+    const QByteArray hash = m_chunksToDownload.first();
+    QUrl url = currentUrl(QString(), m_core->value(scUrlQueryString));
+    url = url.resolved(QUrl(QLatin1String("../") + ContentChunker::chunkPath(hash)));
+    m_downloader = setupChunkDownloader(url, m_chunkDirectory + QLatin1Char('/') + QString::fromLatin1(hash));
+    if (!m_downloader) {
+        fallBack();
+        return;
+    }
+
+    connect(m_downloader, &FileDownloader::downloadCompleted,
+            this, &DownloadArchivesJob::finishedChunkDownload, Qt::QueuedConnection);
+    m_downloader->download();
+}
+
+void DownloadArchivesJob::finishedChunkDownload()
+{
+    Q_ASSERT(m_downloader != nullptr);
+
+    if (m_canceled)
+        return;
+
+    m_totalSizeDownloaded += QFile(m_downloader->downloadedFileName()).size();
+    m_chunksToDownload.removeFirst();
+    fetchNextChunk();
+}
+
+void DownloadArchivesJob::chunkDownloadFailed(const QString &error)
+{
+    if (m_canceled)
+        return;
+
+    qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot download" << m_downloader->url().toString()
+        << ":" << error;
+    fallBack();
+}
+
+/*!
+    Returns the content of \a chunk of \a archive, from the installed files listed in
+    \a localChunks or the chunk downloaded to \a chunkDirectory. Throws an Error if the
+    content does not match the hash of the chunk.
+*/
+QByteArray DownloadArchivesJob::chunkData(const ContentChunk &chunk, const LocalChunks &localChunks,
+    const QString &chunkDirectory, const QString &archive)
+{
+    QByteArray data;
+    if (localChunks.contains(chunk.hash)) {
+        const QPair<QString, qint64> location = localChunks.value(chunk.hash);
+        QFile file(location.first);
+        QInstaller::openForRead(&file);
+        if (file.seek(location.second))
+            data = file.read(chunk.size);
+    } else {
+        QFile file(chunkDirectory + QLatin1Char('/') + QString::fromLatin1(chunk.hash));
+        QInstaller::openForRead(&file);
+        data = qUncompress(file.readAll());
+    }
+    if (QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() != chunk.hash) {
+        throw Error(tr("Chunk %1 of \"%2\" does not match its checksum.")
+            .arg(QString::fromLatin1(chunk.hash), archive));
+    }
+    return data;
+}
+
+/*!
+    Starts rebuilding the current archive from the chunks off the calling thread. Continues
+    with finishedRebuildingArchive() when done.
+*/
+void DownloadArchivesJob::rebuildArchive()
+{
+    m_rebuildWatcher.setFuture(QtConcurrent::run(&DownloadArchivesJob::rebuildArchiveContent,
+        m_chunkManifest.entries(), m_localChunks, m_chunkDirectory,
+        m_archivesToDownload.first().first, localArchivePath()));
+}
+
+/*!
+    Rebuilds the files listed in \a entries from the chunks in \a localChunks and
+    \a chunkDirectory, and packs them into an uncompressed archive at \a archivePath. Returns
+    an error message if rebuilding \a archive fails, otherwise an empty string.
+
+    The rebuilt archive is not checked against the checksum of the archive in the repository:
+    it is packed uncompressed, so its bytes differ from the published archive anyway. Each
+    chunk and each rebuilt file is verified against the SHA-1 hashes of the chunk manifest
+    instead. The manifest is published next to the archive and its checksum file, so it is
+    as trustworthy as the checksum itself.
+*/
+QString DownloadArchivesJob::rebuildArchiveContent(const QVector<ChunkManifest::Entry> &entries,
+    const LocalChunks &localChunks, const QString &chunkDirectory, const QString &archive,
+    const QString &archivePath)
+{
+    const QString contentDir = chunkDirectory + QLatin1String("/content");
+    try {
+        QStringList topLevelEntries;
+        foreach (const ChunkManifest::Entry &entry, entries) {
+            const QString path = contentDir + QLatin1Char('/') + entry.path;
+            if (!entry.path.contains(QLatin1Char('/')))
+                topLevelEntries.append(path);
+            if (entry.isDirectory) {
+                QInstaller::mkpath(path);
+                continue;
+            }
+
+            QInstaller::mkpath(QFileInfo(path).absolutePath());
+            QFile file(path);
+            QInstaller::openForWrite(&file);
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            foreach (const ContentChunk &chunk, entry.chunks) {
+                const QByteArray data = chunkData(chunk, localChunks, chunkDirectory, archive);
+                hash.addData(data);
+                QInstaller::blockingWrite(&file, data);
+            }
+            file.close();
+            if (hash.result().toHex() != entry.hash)
+                throw Error(tr("The rebuilt file \"%1\" does not match its checksum.").arg(entry.path));
+            file.setPermissions(entry.permissions);
+        }
+        packRebuiltArchive(archivePath, topLevelEntries);
+    } catch (const Error &e) {
+        QFile::remove(archivePath);
+        return e.message();
+    }
+    return QString();
+}
+
+void DownloadArchivesJob::finishedRebuildingArchive()
+{
+    if (m_canceled) {
+        finishWithError(tr("Canceled"));
+        return;
+    }
+
+    const QString error = m_rebuildWatcher.result();
+    if (!error.isEmpty()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot rebuild"
+            << m_archivesToDownload.first().first << "from chunks:" << error;
+        fallBack();
+        return;
+    }
+    QInstaller::removeDirectory(m_chunkDirectory, true);
+    m_chunkDirectory.clear();
+    registerRebuiltArchive(localArchivePath());
+}
+
+/*!
+    Fetches the delta patch of the next archive, to apply it to the installed files of the
+    version it was created from.
+*/
+void DownloadArchivesJob::fetchDeltaPatch()
+{
+    if (m_downloader)
+        m_downloader->deleteLater();
+
+    const Component *const component = currentComponent();
+    const QFileInfo fi(m_archivesToDownload.first().first);
+    QString patchFile;
+    if (component) {
+        patchFile = component->localTempPath() + QLatin1Char('/') + component->name()
+            + QLatin1Char('/') + fi.fileName() + QLatin1String(".patch");
+        m_patchDirectory = patchFile + QLatin1String(".d");
+    }
+    m_downloader = setupChunkDownloader(currentUrl(QLatin1String(".patch"),
+        m_core->value(scUrlQueryString)), patchFile);
+    if (!m_downloader) {
+        fallBack();
+        return;
+    }
+
+    emit outputTextChanged(tr("Downloading patch of archive \"%1\" for component %2.")
+        .arg(fi.fileName(), component->displayName()));
+    connect(m_downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
+    connect(m_downloader, &FileDownloader::downloadCompleted,
+            this, &DownloadArchivesJob::finishedDeltaPatchDownload, Qt::QueuedConnection);
+    m_downloader->download();
+}
+
+void DownloadArchivesJob::finishedDeltaPatchDownload()
+{
+    Q_ASSERT(m_downloader != nullptr);
+
+    if (m_canceled)
+        return;
+
+    DeltaPatch patch;
+    QFile patchFile(m_downloader->downloadedFileName());
+    m_totalSizeDownloaded += patchFile.size();
+    const bool valid = patchFile.open(QIODevice::ReadOnly) && patch.read(&patchFile);
+    patchFile.close();
+    patchFile.remove();
+    if (!valid) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot read delta patch"
+            << m_downloader->url().toString() << ":" << patch.errorString();
+        fallBack();
+        return;
+    }
+    applyDeltaPatch(patch);
+}
+
+/*
+    Reads the installed file at the relative \a path with the hex encoded SHA-1 \a hash into
+    \a data. The candidates are looked up by file name in \a installedFiles, as the archive
+    may have been extracted to any directory. Files larger than BinaryDelta::MaximumFileSize
+    are never patched and not read.
+*/
+static bool readInstalledFile(const QMultiHash<QString, QString> &installedFiles, const QString &path,
+    const QByteArray &hash, QByteArray *data)
+{
+    const QString suffix = QLatin1Char('/') + path;
+    foreach (const QString &candidate, installedFiles.values(QFileInfo(path).fileName())) {
+        if (!QDir::fromNativeSeparators(candidate).endsWith(suffix))
+            continue;
+        QFile file(candidate);
+        if (file.size() > BinaryDelta::MaximumFileSize || !file.open(QIODevice::ReadOnly))
+            continue;
+        const QByteArray content = file.readAll();
+        if (QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex() == hash) {
+            *data = content;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+    Starts applying \a patch to the installed files off the calling thread. Continues with
+    finishedApplyingDeltaPatch() when done.
+*/
+void DownloadArchivesJob::applyDeltaPatch(const DeltaPatch &patch)
+{
+    const QString archive = m_archivesToDownload.first().first;
+    m_patchWatcher.setFuture(QtConcurrent::run(&DownloadArchivesJob::applyDeltaPatchContent,
+        patch.entries(), m_patchedFiles.value(archive), m_patchDirectory, localArchivePath()));
+}
+
+/*!
+    Applies the patch \a entries to the \a installedFiles, writes the result to
+    \a patchDirectory and packs it into an uncompressed archive at \a archivePath. Returns
+    an error message if patching fails, otherwise an empty string.
+*/
+QString DownloadArchivesJob::applyDeltaPatchContent(const QVector<DeltaPatch::Entry> &entries,
+    const QStringList &installedFiles, const QString &patchDirectory, const QString &archivePath)
+{
+    const QString contentDir = patchDirectory + QLatin1String("/content");
+
+    QMultiHash<QString, QString> installedFileNames;
+    foreach (const QString &path, installedFiles)
+        installedFileNames.insert(QFileInfo(path).fileName(), path);
+
+    try {
+        QStringList topLevelEntries;
+        foreach (const DeltaPatch::Entry &entry, entries) {
+            if (!isContainedRelativePath(entry.path))
+                throw Error(tr("Invalid path \"%1\" in the patch.").arg(entry.path));
+            const QString path = contentDir + QLatin1Char('/') + entry.path;
+            if (!entry.path.contains(QLatin1Char('/')))
+                topLevelEntries.append(path);
+            if (entry.isDirectory) {
+                QInstaller::mkpath(path);
+                continue;
+            }
+
+            QByteArray data = qUncompress(entry.data);
+            if (!entry.sourceHash.isEmpty()) {
+                QByteArray source;
+                if (!readInstalledFile(installedFileNames, entry.path, entry.sourceHash, &source))
+                    throw Error(tr("Cannot find the unchanged installed file \"%1\".").arg(entry.path));
+                QByteArray target;
+                if (!BinaryDelta::apply(source, data, &target))
+                    throw Error(tr("Cannot apply the patch to \"%1\".").arg(entry.path));
+                data = target;
+            }
+            if (QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() != entry.hash)
+                throw Error(tr("The patched file \"%1\" does not match its checksum.").arg(entry.path));
+
+            QInstaller::mkpath(QFileInfo(path).absolutePath());
+            QFile file(path);
+            QInstaller::openForWrite(&file);
+            QInstaller::blockingWrite(&file, data);
+            file.close();
+            file.setPermissions(entry.permissions);
+        }
+        packRebuiltArchive(archivePath, topLevelEntries);
+    } catch (const Error &e) {
+        QFile::remove(archivePath);
+        return e.message();
+    }
+    return QString();
+}
+
+void DownloadArchivesJob::finishedApplyingDeltaPatch()
+{
+    if (m_canceled) {
+        finishWithError(tr("Canceled"));
+        return;
+    }
+
+    const QString error = m_patchWatcher.result();
+    if (!error.isEmpty()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot patch"
+            << m_archivesToDownload.first().first << ":" << error;
+        fallBack();
+        return;
+    }
+    QInstaller::removeDirectory(m_patchDirectory, true);
+    m_patchDirectory.clear();
+    registerRebuiltArchive(localArchivePath());
+}
+
+/*!
+    Returns the path the current archive is downloaded, copied from the archive cache or
+    rebuilt to.
+*/
+QString DownloadArchivesJob::localArchivePath() const
+{
+    const Component *const component = currentComponent();
+    return component->localTempPath() + QLatin1Char('/') + component->name()
+        + QLatin1Char('/') + QFileInfo(m_archivesToDownload.first().first).fileName();
+}
+
+/*!
+    Packs the rebuilt top-level \a entries into an uncompressed archive at \a archivePath.
+    Throws an Error on failure.
+*/
+void DownloadArchivesJob::packRebuiltArchive(const QString &archivePath, const QStringList &entries)
+{
+    QScopedPointer<AbstractArchive> archiveFile(ArchiveFactory::instance().create(archivePath));
+    if (!archiveFile)
+        throw Error(tr("Unsupported archive \"%1\".").arg(archivePath));
+    archiveFile->setCompressionLevel(AbstractArchive::Non);
+    if (!(archiveFile->open(QIODevice::WriteOnly) && archiveFile->create(entries)))
+        throw Error(archiveFile->errorString());
+}
+
+/*!
+    Registers the archive rebuilt at \a archivePath in the installer's file system and
+    continues with the next archive.
+*/
+void DownloadArchivesJob::registerRebuiltArchive(const QString &archivePath)
+{
+    const QString archive = m_archivesToDownload.first().first;
+    ++m_archivesDownloaded;
+    emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
+    m_patchedFiles.remove(archive);
+    m_installedFiles.remove(archive);
+    m_archivesToDownload.removeFirst();
+    BinaryFormatEngineHandler::instance()->registerResource(archive, archivePath);
+    fetchNextArchiveHash();
+}
+
+/*!
+    Gives up patching or rebuilding the current archive from chunks. If the archive was being
+    patched, it is rebuilt from chunks if possible, otherwise it is downloaded completely.
+*/
+void DownloadArchivesJob::fallBack()
+{
+    if (!m_patchDirectory.isEmpty())
+        QInstaller::removeDirectory(m_patchDirectory, true);
+    m_patchDirectory.clear();
+    if (!m_chunkDirectory.isEmpty())
+        QInstaller::removeDirectory(m_chunkDirectory, true);
+    m_chunkDirectory.clear();
+    m_chunksToDownload.clear();
+    m_localChunks.clear();
+
+    const QString archive = m_archivesToDownload.first().first;
+    if (!m_patchedFiles.remove(archive))
+        m_installedFiles.remove(archive);
+    QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
+}
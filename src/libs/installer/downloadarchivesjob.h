@@ -29,10 +29,16 @@
 #ifndef DOWNLOADARCHIVESJOB_H
 #define DOWNLOADARCHIVESJOB_H
 
+#include "binarydelta.h"
+#include "contentchunks.h"
 #include "job.h"
 
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QHash>
 #include <QtCore/QPair>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QUrl>
 
 QT_BEGIN_NAMESPACE
 class QTimerEvent;
@@ -44,6 +50,7 @@ namespace KDUpdater {
 
 namespace QInstaller {
 
+class Component;
 class MessageBoxHandler;
 class PackageManagerCore;
 
@@ -58,6 +65,8 @@ public:
     int numberOfDownloads() const { return m_archivesDownloaded; }
     void setArchivesToDownload(const QList<QPair<QString, QString> > &archives);
     void setExpectedTotalSize(quint64 total);
+    void setInstalledFiles(const QHash<QString, QStringList> &installedFiles);
+    void setPatchedFiles(const QHash<QString, QStringList> &patchedFiles);
 
 Q_SIGNALS:
     void progressChanged(double progress);
@@ -81,9 +90,46 @@ protected Q_SLOTS:
     void fetchNextArchiveHash();
     void finishedHashDownload();
     void emitDownloadProgress(double progress);
+    void fetchChunkManifest();
+    void finishedChunkManifestDownload();
+    void finishedIndexingInstalledChunks();
+    void fetchNextChunk();
+    void finishedChunkDownload();
+    void chunkDownloadFailed(const QString &error);
+    void finishedRebuildingArchive();
+    void fetchDeltaPatch();
+    void finishedDeltaPatchDownload();
+    void finishedApplyingDeltaPatch();
+    void cacheCopyFailed(const QString &error);
 
 private:
+    typedef QHash<QByteArray, QPair<QString, qint64> > LocalChunks;
+
+    const Component *currentComponent() const;
+    QCryptographicHash::Algorithm repositoryChecksumAlgorithm() const;
+    QUrl currentUrl(const QString &suffix, const QString &queryString) const;
+    KDUpdater::FileDownloader *createDownloader(const Component *component, const QUrl &url,
+        const QString &fileName);
     KDUpdater::FileDownloader *setupDownloader(const QString &suffix = QString(), const QString &queryString = QString());
+    KDUpdater::FileDownloader *setupChunkDownloader(const QUrl &url, const QString &fileName);
+    QString cachedArchivePath() const;
+    KDUpdater::FileDownloader *setupCacheDownloader(const QString &cachedArchive);
+    void storeInCache(const QString &fileName) const;
+    void indexInstalledChunks(const QStringList &files);
+    static QByteArray chunkData(const ContentChunk &chunk, const LocalChunks &localChunks,
+        const QString &chunkDirectory, const QString &archive);
+    void rebuildArchive();
+    static QString rebuildArchiveContent(const QVector<ChunkManifest::Entry> &entries,
+        const LocalChunks &localChunks, const QString &chunkDirectory, const QString &archive,
+        const QString &archivePath);
+    void applyDeltaPatch(const DeltaPatch &patch);
+    static QString applyDeltaPatchContent(const QVector<DeltaPatch::Entry> &entries,
+        const QStringList &installedFiles, const QString &patchDirectory,
+        const QString &archivePath);
+    QString localArchivePath() const;
+    static void packRebuiltArchive(const QString &archivePath, const QStringList &entries);
+    void registerRebuiltArchive(const QString &archivePath);
+    void fallBack();
 
 private:
     PackageManagerCore *m_core;
@@ -101,6 +147,19 @@ private:
     quint64 m_totalSizeToDownload;
     quint64 m_totalSizeDownloaded;
     QElapsedTimer m_totalDownloadSpeedTimer;
+
+    QHash<QString, QStringList> m_installedFiles;
+    ChunkManifest m_chunkManifest;
+    LocalChunks m_localChunks;
+    QFutureWatcher<LocalChunks> m_indexWatcher;
+    QList<QByteArray> m_chunksToDownload;
+    QString m_chunkDirectory;
+    QFutureWatcher<QString> m_rebuildWatcher;
+    QHash<QString, QStringList> m_patchedFiles;
+    QString m_patchDirectory;
+    QFutureWatcher<QString> m_patchWatcher;
+    bool m_copyingFromCache;
+    bool m_cacheFailed;
 };
 
 } // namespace QInstaller
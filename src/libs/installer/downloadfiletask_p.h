@@ -31,6 +31,7 @@
 
 #include "downloadfiletask.h"
 #include <observer.h>
+#include <utils.h>
 
 #include <QFile>
 #include <QNetworkAccessManager>
@@ -59,7 +60,9 @@ struct Data
     Data(const FileTaskItem &fti)
         : taskItem(fti)
         , file(Q_NULLPTR)
-        , observer(new FileTaskObserver(QCryptographicHash::Sha1))
+        // the length of the expected checksum tells SHA-1 from SHA-256 repositories
+        , observer(new FileTaskObserver(QInstaller::checksumAlgorithmForHex(
+            fti.value(TaskRole::Checksum).toByteArray())))
     {}
 
     FileTaskItem taskItem;
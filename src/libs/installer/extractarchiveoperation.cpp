@@ -28,6 +28,7 @@
 
 #include "extractarchiveoperation_p.h"
 
+#include "checksumverifier.h"
 #include "constants.h"
 #include "globals.h"
 
@@ -76,24 +77,32 @@ void ExtractArchiveOperation::backup()
 
 bool ExtractArchiveOperation::performOperation()
 {
-    if (!checkArgumentCount(2))
+    if (!checkArgumentCount(2, 3))
         return false;
 
     const QStringList args = arguments();
     const QString archivePath = args.at(0);
     const QString targetDir = args.at(1);
+    const QByteArray checksum = args.value(2).toLatin1();
+    if (!checksum.isEmpty() && !ChecksumVerifier::isValidChecksum(checksum)) {
+        setError(InvalidArguments);
+        setErrorString(tr("Invalid checksum \"%1\" for archive \"%2\".")
+            .arg(QString::fromLatin1(checksum), archivePath));
+        return false;
+    }
 
     Receiver receiver;
     Callback callback;
 
     connect(&callback, &Callback::progressChanged, this, &ExtractArchiveOperation::progressChanged);
 
-    Worker *worker = new Worker(archivePath, targetDir, &callback);
+    Worker *worker = new Worker(archivePath, targetDir, checksum, &callback);
     connect(worker, &Worker::finished, &receiver, &Receiver::workerFinished,
         Qt::QueuedConnection);
 
     if (PackageManagerCore *core = packageManager())
-        connect(core, &PackageManagerCore::statusChanged, worker, &Worker::onStatusChanged);
+        connect(core, &PackageManagerCore::statusChanged, worker, &Worker::onStatusChanged,
+            Qt::DirectConnection);
 
     QFileInfo fileInfo(archivePath);
     emit outputTextChanged(tr("Extracting \"%1\"").arg(fileInfo.fileName()));
@@ -177,7 +186,7 @@ bool ExtractArchiveOperation::performOperation()
 
 bool ExtractArchiveOperation::undoOperation()
 {
-    Q_ASSERT(arguments().count() == 2);
+    Q_ASSERT(arguments().count() == 2 || arguments().count() == 3);
 
     // For backward compatibility, check if "files" can be converted to QStringList.
     // If yes, files are listed in .dat instead of in a separate file.
@@ -34,6 +34,7 @@
 #include "archivefactory.h"
 #include "packagemanagercore.h"
 
+#include <QMutex>
 #include <QRunnable>
 #include <QThread>
 
@@ -94,47 +95,36 @@ public:
 
     BackupFiles backupFiles() const
     {
+        QMutexLocker _(&m_backupMutex);
         return m_backupFiles;
     }
 
     QStringList extractedFiles() const
     {
-        return m_extractedFiles;
-    }
-
-    static QString generateBackupName(const QString &fn)
-    {
-        const QString bfn = fn + QLatin1String(".tmpUpdate");
-        QString res = bfn;
-        int i = 0;
-        while (QFile::exists(res))
-            res = bfn + QString::fromLatin1(".%1").arg(i++);
-        return res;
-    }
-
-    bool prepareForFile(const QString &filename)
-    {
-        if (!QFile::exists(filename))
-            return true;
-        const QString backup = generateBackupName(filename);
-        QFile f(filename);
-        const bool renamed = f.rename(backup);
-        if (f.exists() && !renamed) {
-            qCritical("Cannot rename %s to %s: %s", qPrintable(filename), qPrintable(backup),
-                qPrintable(f.errorString()));
-            return false;
-        }
-        m_backupFiles.append(qMakePair(filename, backup));
-        return true;
+        // newest first, so that files are removed before their directories on undo
+        QStringList files;
+        files.reserve(m_extractedFiles.count());
+        for (auto it = m_extractedFiles.crbegin(); it != m_extractedFiles.crend(); ++it)
+            files.append(*it);
+        return files;
     }
 
 Q_SIGNALS:
     void progressChanged(double progress);
 
 public Q_SLOTS:
-    void onCurrentEntryChanged(const QString &filename)
+    void onEntriesExtracted(const QStringList &filenames)
+    {
+        m_extractedFiles.reserve(m_extractedFiles.count() + filenames.count());
+        for (const QString &filename : filenames)
+            m_extractedFiles.append(QDir::toNativeSeparators(filename));
+    }
+
+    // Called directly from the extracting threads, which might be several.
+    void onFileBackedUp(const QString &filename, const QString &backupFilename)
     {
-        m_extractedFiles.prepend(QDir::toNativeSeparators(filename));
+        QMutexLocker _(&m_backupMutex);
+        m_backupFiles.append(qMakePair(filename, backupFilename));
     }
 
     void onCompletedChanged(quint64 completed, quint64 total)
@@ -143,6 +133,7 @@ public Q_SLOTS:
     }
 
 private:
+    mutable QMutex m_backupMutex;
     BackupFiles m_backupFiles;
     QStringList m_extractedFiles;
 };
@@ -153,10 +144,12 @@ class ExtractArchiveOperation::Worker : public QObject
     Q_DISABLE_COPY(Worker)
 
 public:
-    Worker(const QString &archivePath, const QString &targetDir, Callback *callback)
+    Worker(const QString &archivePath, const QString &targetDir, const QByteArray &checksum,
+            Callback *callback)
         : m_archivePath(archivePath)
         , m_targetDir(targetDir)
-        , m_canceled(false)
+        , m_checksum(checksum)
+        , m_canceled(0)
         , m_callback(callback)
     {}
 
@@ -166,40 +159,35 @@ Q_SIGNALS:
 public Q_SLOTS:
     void run()
     {
-        m_canceled = false;
-        m_archive.reset(ArchiveFactory::instance().create(m_archivePath));
+        m_canceled.storeRelease(0);
+        {
+            QMutexLocker _(&m_archiveLock);
+            m_archive.reset(ArchiveFactory::instance().create(m_archivePath));
+        }
         if (!m_archive) {
             emit finished(false, tr("Could not create handler object for archive \"%1\": \"%2\".")
                 .arg(m_archivePath, QLatin1String(Q_FUNC_INFO)));
             return;
         }
 
-        connect(m_archive.get(), &AbstractArchive::currentEntryChanged, m_callback, &Callback::onCurrentEntryChanged);
+        connect(m_archive.get(), &AbstractArchive::entriesExtracted, m_callback, &Callback::onEntriesExtracted);
         connect(m_archive.get(), &AbstractArchive::completedChanged, m_callback, &Callback::onCompletedChanged);
+        connect(m_archive.get(), &AbstractArchive::fileBackedUp, m_callback, &Callback::onFileBackedUp,
+            Qt::DirectConnection);
 
         if (!(m_archive->open(QIODevice::ReadOnly) && m_archive->isSupported())) {
             emit finished(false, tr("Cannot open archive \"%1\" for reading: %2").arg(m_archivePath,
                 m_archive->errorString()));
             return;
         }
-        const QVector<ArchiveEntry> entries = m_archive->list();
-        if (entries.isEmpty()) {
-            emit finished(false, tr("Error while reading contents of archive \"%1\": %2").arg(m_archivePath,
-                m_archive->errorString()));
-            return;
-        }
-        for (auto &entry : entries) {
-            QString completeFilePath = m_targetDir + QDir::separator() + entry.path;
-            if (!entry.isDirectory && !m_callback->prepareForFile(completeFilePath)) {
-                emit finished(false, tr("Cannot prepare for file \"%1\"").arg(completeFilePath));
-                return;
-            }
-        }
-        if (m_canceled) {
-            // For large archives the reading takes some time, and the user might have
-            // canceled before we start the actual extracting.
+        // Existing files are backed up while extracting, so the archive is decompressed once.
+        m_archive->setBackupExistingFiles(true);
+        // verified on the data read for extracting, instead of reading the archive twice
+        m_archive->setExpectedChecksum(m_checksum);
+        if (m_canceled.loadAcquire()) {
+            // The user might have canceled before we start the actual extracting.
             emit finished(false, tr("Extract for archive \"%1\" canceled.").arg(m_archivePath));
-        } else if (!m_archive->extract(m_targetDir, entries.size())) {
+        } else if (!m_archive->extract(m_targetDir)) {
             emit finished(false, tr("Error while extracting archive \"%1\": %2").arg(m_archivePath,
                 m_archive->errorString()));
         } else {
@@ -207,18 +195,21 @@ public Q_SLOTS:
         }
     }
 
+    // Called directly from the thread changing the status, the extraction
+    // does not process events of its own thread while running.
     void onStatusChanged(PackageManagerCore::Status status)
     {
+        QMutexLocker _(&m_archiveLock);
         if (!m_archive)
             return;
 
         switch (status) {
         case PackageManagerCore::Canceled:
-            m_canceled = true;
+            m_canceled.storeRelease(1);
             m_archive->cancel();
             break;
         case PackageManagerCore::Failure:
-            m_canceled = true;
+            m_canceled.storeRelease(1);
             m_archive->cancel();
             break;
         default: // ignore all other status values
@@ -229,8 +220,10 @@ public Q_SLOTS:
 private:
     QString m_archivePath;
     QString m_targetDir;
+    QByteArray m_checksum;
     QScopedPointer<AbstractArchive> m_archive;
-    bool m_canceled;
+    QMutex m_archiveLock;
+    QAtomicInt m_canceled;
     Callback *m_callback;
 };
 
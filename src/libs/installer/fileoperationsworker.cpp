@@ -0,0 +1,461 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "fileoperationsworker.h"
+
+#include "errors.h"
+#include "fileutils.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::FileOperationsWorker
+    \internal
+    \brief The FileOperationsWorker class runs bulk file system operations in a
+    background thread and exposes their status and progress.
+
+    The worker is used by the remote server to execute whole file operations, like copying
+    or removing a directory tree, in the server process. The client only polls the status
+    and progress instead of sending a request for each file system call.
+*/
+
+/*!
+    \enum FileOperationsWorker::Operation
+
+    This enum type specifies the file operation to run:
+
+    \value CopyFile
+           Copies a single file.
+    \value CopyDirectory
+           Copies a directory tree.
+    \value Move
+           Moves a file or a directory tree.
+    \value RemoveDirectory
+           Removes a directory tree.
+    \value SetPermissions
+           Sets the permissions of a file or, recursively, of a directory tree.
+    \value HashFile
+           Calculates the checksum of a file.
+*/
+
+/*!
+    \enum FileOperationsWorker::Status
+
+    This enum type specifies the status of the worker:
+
+    \value Idle
+           No operation was started.
+    \value Running
+           An operation is in progress.
+    \value Success
+           The last operation finished successfully.
+    \value Failure
+           The last operation failed, errorString() contains the reason.
+    \value Canceled
+           The last operation was canceled.
+*/
+
+/*!
+    Constructs the worker. Operations are run in a thread of \a pool, or
+    of the global thread pool if \a pool is \c nullptr.
+*/
+FileOperationsWorker::FileOperationsWorker(QThreadPool *pool)
+    : m_pool(pool ? pool : QThreadPool::globalInstance())
+    , m_status(Idle)
+    , m_canceled(0)
+    , m_completed(0)
+    , m_total(0)
+{
+}
+
+/*!
+    Cancels a running operation and waits for it to finish before destroying the worker.
+*/
+FileOperationsWorker::~FileOperationsWorker()
+{
+    cancel();
+    waitForFinished();
+}
+
+/*!
+    Starts \a operation on \a path with the operation specific \a argument in a
+    background thread. The \a argument is the target path for the copy and move
+    operations, the permissions for SetPermissions and the QCryptographicHash::Algorithm
+    for HashFile.
+
+    Returns \c false if another operation is still running; otherwise \c true.
+*/
+bool FileOperationsWorker::start(Operation operation, const QString &path, const QVariant &argument)
+{
+    if (m_future.isRunning())
+        return false;
+
+    reset();
+    m_future = QtConcurrent::run(m_pool, this, &FileOperationsWorker::execute, operation, path,
+        argument);
+    return true;
+}
+
+/*!
+    Runs \a operation on \a path with the operation specific \a argument in the
+    calling thread and blocks until it has finished. The operation can still be
+    canceled from another thread with cancel().
+
+    Returns \c false if an operation started with start() is still running or the
+    operation did not succeed; otherwise \c true.
+*/
+bool FileOperationsWorker::run(Operation operation, const QString &path, const QVariant &argument)
+{
+    if (m_future.isRunning())
+        return false;
+
+    reset();
+    execute(operation, path, argument);
+    return status() == Success;
+}
+
+void FileOperationsWorker::reset()
+{
+    m_status.storeRelease(Running);
+    m_canceled.storeRelease(0);
+    m_completed.storeRelease(0);
+    m_total.storeRelease(0);
+    QMutexLocker _(&m_mutex);
+    m_errorString.clear();
+    m_result.clear();
+}
+
+void FileOperationsWorker::execute(Operation operation, const QString &path, const QVariant &argument)
+{
+    try {
+        switch (operation) {
+        case CopyFile:
+            copyFile(path, argument.toString());
+            break;
+        case CopyDirectory:
+            copyDirectory(path, argument.toString());
+            break;
+        case Move:
+            move(path, argument.toString());
+            break;
+        case RemoveDirectory:
+            removeDirectory(path);
+            break;
+        case SetPermissions:
+            setPermissions(path, argument.toUInt());
+            break;
+        case HashFile:
+            hashFile(path, argument.toInt());
+            break;
+        default:
+            throw Error(QCoreApplication::translate("QInstaller",
+                "Unknown file operation: %1").arg(operation));
+        }
+        m_status.storeRelease(Success);
+    } catch (const Error &e) {
+        {
+            QMutexLocker _(&m_mutex);
+            m_errorString = e.message();
+        }
+        m_status.storeRelease(m_canceled.loadAcquire() ? Canceled : Failure);
+    }
+}
+
+/*!
+    Requests cancellation of the running operation.
+*/
+void FileOperationsWorker::cancel()
+{
+    m_canceled.storeRelease(1);
+}
+
+/*!
+    Blocks until the operation started with start() has finished.
+*/
+void FileOperationsWorker::waitForFinished()
+{
+    m_future.waitForFinished();
+}
+
+/*!
+    Returns the status of the last operation.
+*/
+FileOperationsWorker::Status FileOperationsWorker::status() const
+{
+    return static_cast<Status>(m_status.loadAcquire());
+}
+
+/*!
+    Returns the amount of work completed by the running operation, in bytes for
+    copy, move and hash operations and in entries otherwise.
+*/
+quint64 FileOperationsWorker::completed() const
+{
+    return m_completed.loadAcquire();
+}
+
+/*!
+    Returns the total amount of work of the running operation.
+*/
+quint64 FileOperationsWorker::total() const
+{
+    return m_total.loadAcquire();
+}
+
+/*!
+    Returns a human-readable description of the last error that occurred.
+*/
+QString FileOperationsWorker::errorString() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_errorString;
+}
+
+/*!
+    Returns the result of the last operation, which is the checksum for HashFile
+    and empty for all other operations.
+*/
+QByteArray FileOperationsWorker::result() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_result;
+}
+
+void FileOperationsWorker::copyFile(const QString &source, const QString &target)
+{
+    m_total.storeRelease(QFileInfo(source).size());
+    QInstaller::copyFile(source, target, [this](qint64 copied) {
+        return reportProgress(copied);
+    });
+}
+
+void FileOperationsWorker::copyDirectory(const QString &source, const QString &target)
+{
+    const QDir sourceDir(source);
+    const QDir targetDir(target);
+
+    QFileInfoList entries;
+    quint64 total = 0;
+    QDirIterator it(source, QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden
+        | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        if (fi.isFile() && !fi.isSymLink())
+            total += fi.size();
+        entries.append(fi);
+    }
+    m_total.storeRelease(total);
+
+    QInstaller::mkpath(target);
+    quint64 completed = 0;
+    foreach (const QFileInfo &fi, entries) {
+        throwIfCanceled();
+        const QString targetPath = targetDir.absoluteFilePath(sourceDir.relativeFilePath(fi
+            .absoluteFilePath()));
+        if (fi.isSymLink()) {
+            QFile::remove(targetPath);
+            if (!QFile::link(fi.symLinkTarget(), targetPath)) {
+                throw Error(QCoreApplication::translate("QInstaller",
+                    "Cannot create link from \"%1\" to \"%2\".").arg(
+                    QDir::toNativeSeparators(fi.symLinkTarget()),
+                    QDir::toNativeSeparators(targetPath)));
+            }
+        } else if (fi.isDir()) {
+            QInstaller::mkpath(targetPath);
+        } else {
+            const quint64 base = completed;
+            completed += QInstaller::copyFile(fi.absoluteFilePath(), targetPath,
+                [this, base](qint64 copied) {
+                    return reportProgress(base + copied);
+                });
+        }
+    }
+}
+
+void FileOperationsWorker::move(const QString &source, const QString &target)
+{
+    // Keep an existing target until the source has been moved, so that it is
+    // restored if the move fails.
+    QString backup;
+    if (QFileInfo::exists(target) || QFileInfo(target).isSymLink()) {
+        backup = generateTemporaryFileName(target);
+        QFile::remove(backup);
+        if (!QDir().rename(target, backup)) {
+            throw Error(QCoreApplication::translate("QInstaller",
+                "Cannot rename \"%1\" to \"%2\".").arg(QDir::toNativeSeparators(target),
+                                                       QDir::toNativeSeparators(backup)));
+        }
+    }
+
+    try {
+        moveEntry(source, target);
+    } catch (const Error &) {
+        if (!backup.isEmpty()) {
+            if (QFileInfo(target).isDir() && !QFileInfo(target).isSymLink())
+                QInstaller::removeDirectory(target, true);
+            else
+                QFile::remove(target);
+            QDir().rename(backup, target);
+        }
+        throw;
+    }
+
+    if (backup.isEmpty())
+        return;
+    if (QFileInfo(backup).isDir() && !QFileInfo(backup).isSymLink())
+        QInstaller::removeDirectory(backup, true);
+    else
+        QFile::remove(backup);
+}
+
+void FileOperationsWorker::moveEntry(const QString &source, const QString &target)
+{
+    const QFileInfo fi(source);
+    if (fi.isDir() && !fi.isSymLink()) {
+        if (QDir().rename(source, target))
+            return;
+        // not on the same file system
+        try {
+            copyDirectory(source, target);
+            throwIfCanceled();
+        } catch (const Error &) {
+            QInstaller::removeDirectory(target, true);
+            throw;
+        }
+        QInstaller::removeDirectory(source);
+        return;
+    }
+
+    if (QFile::rename(source, target))
+        return;
+    copyFile(source, target);
+    try {
+        throwIfCanceled();
+    } catch (const Error &) {
+        QFile::remove(target);
+        throw;
+    }
+    QFile file(source);
+    if (!file.remove()) {
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot remove file \"%1\": %2").arg(QDir::toNativeSeparators(source),
+                                                 file.errorString()));
+    }
+}
+
+void FileOperationsWorker::removeDirectory(const QString &path)
+{
+    QInstaller::removeDirectory(path);
+}
+
+void FileOperationsWorker::setPermissions(const QString &path, uint permissions)
+{
+    QStringList entries(path);
+    if (QFileInfo(path).isDir()) {
+        QDirIterator it(path, QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden
+            | QDir::System, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            entries.append(it.next());
+    }
+    m_total.storeRelease(entries.count());
+
+    // Apply the permissions to the content of a directory before the directory itself,
+    // which might lose the permissions needed to access its entries.
+    std::reverse(entries.begin(), entries.end());
+
+    quint64 completed = 0;
+    foreach (const QString &entry, entries) {
+        throwIfCanceled();
+        if (!QFile::setPermissions(entry, static_cast<QFileDevice::Permissions>(permissions))) {
+            throw Error(QCoreApplication::translate("QInstaller",
+                "Cannot set permissions for \"%1\".").arg(QDir::toNativeSeparators(entry)));
+        }
+        reportProgress(++completed);
+    }
+}
+
+void FileOperationsWorker::hashFile(const QString &path, int algorithm)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot open file \"%1\" for reading: %2").arg(QDir::toNativeSeparators(path),
+                                                           file.errorString()));
+    }
+    m_total.storeRelease(file.size());
+
+    QCryptographicHash hash(static_cast<QCryptographicHash::Algorithm>(algorithm));
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    quint64 completed = 0;
+    while (true) {
+        throwIfCanceled();
+        const qint64 numRead = file.read(buffer.data(), buffer.size());
+        if (numRead < 0) {
+            throw Error(QCoreApplication::translate("QInstaller",
+                "Cannot read from file \"%1\": %2").arg(QDir::toNativeSeparators(path),
+                                                        file.errorString()));
+        }
+        if (numRead == 0)
+            break;
+        hash.addData(buffer.constData(), numRead);
+        reportProgress(completed += numRead);
+    }
+
+    QMutexLocker _(&m_mutex);
+    m_result = hash.result();
+}
+
+/*!
+    Stores \a completed as the current progress. Returns \c false if the
+    operation was canceled.
+*/
+bool FileOperationsWorker::reportProgress(quint64 completed)
+{
+    m_completed.storeRelease(completed);
+    return !m_canceled.loadAcquire();
+}
+
+void FileOperationsWorker::throwIfCanceled() const
+{
+    if (m_canceled.loadAcquire())
+        throw Error(QCoreApplication::translate("QInstaller", "File operation canceled."));
+}
+
+} // namespace QInstaller
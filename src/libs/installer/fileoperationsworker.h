@@ -0,0 +1,110 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef FILEOPERATIONSWORKER_H
+#define FILEOPERATIONSWORKER_H
+
+#include "installer_global.h"
+
+#include <QAtomicInteger>
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+#include <QVariant>
+
+QT_FORWARD_DECLARE_CLASS(QThreadPool)
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT FileOperationsWorker
+{
+    Q_DISABLE_COPY(FileOperationsWorker)
+
+public:
+    enum Operation {
+        CopyFile = 0,
+        CopyDirectory = 1,
+        Move = 2,
+        RemoveDirectory = 3,
+        SetPermissions = 4,
+        HashFile = 5
+    };
+
+    enum Status {
+        Idle = 0,
+        Running = 1,
+        Success = 2,
+        Failure = 3,
+        Canceled = 4
+    };
+
+    explicit FileOperationsWorker(QThreadPool *pool = nullptr);
+    ~FileOperationsWorker();
+
+    bool start(Operation operation, const QString &path, const QVariant &argument);
+    bool run(Operation operation, const QString &path, const QVariant &argument);
+    void cancel();
+    void waitForFinished();
+
+    Status status() const;
+    quint64 completed() const;
+    quint64 total() const;
+    QString errorString() const;
+    QByteArray result() const;
+
+private:
+    void reset();
+    void execute(Operation operation, const QString &path, const QVariant &argument);
+
+    void copyFile(const QString &source, const QString &target);
+    void copyDirectory(const QString &source, const QString &target);
+    void move(const QString &source, const QString &target);
+    void moveEntry(const QString &source, const QString &target);
+    void removeDirectory(const QString &path);
+    void setPermissions(const QString &path, uint permissions);
+    void hashFile(const QString &path, int algorithm);
+
+    bool reportProgress(quint64 completed);
+    void throwIfCanceled() const;
+
+private:
+    QThreadPool *m_pool;
+    QFuture<void> m_future;
+    QAtomicInt m_status;
+    QAtomicInt m_canceled;
+    QAtomicInteger<quint64> m_completed;
+    QAtomicInteger<quint64> m_total;
+
+    mutable QMutex m_mutex;
+    QString m_errorString;
+    QByteArray m_result;
+};
+
+} // namespace QInstaller
+
+#endif // FILEOPERATIONSWORKER_H
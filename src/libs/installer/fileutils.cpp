@@ -36,6 +36,7 @@
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
 #include <QtCore/QEventLoop>
+#include <QtCore/QRegularExpression>
 #include <QtCore/QTemporaryFile>
 #include <QtCore/QThread>
 #include <QtCore/QUrl>
@@ -53,6 +54,12 @@
 #include <unistd.h>
 #endif
 
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
+
 using namespace QInstaller;
 
 /*!
@@ -176,6 +183,29 @@ QString QInstaller::pathFromUrl(const QUrl &url)
     return str;
 }
 
+/*!
+    \internal
+
+    Returns \c true if \a path is a non-empty relative path that stays inside the directory
+    it is resolved against, meaning it is not absolute and has no \c{..} components. Both
+    slashes and backslashes are treated as separators and drive letters are rejected,
+    regardless of the platform.
+*/
+bool QInstaller::isContainedRelativePath(const QString &path)
+{
+    if (path.isEmpty() || QDir::isAbsolutePath(path) || path.startsWith(QLatin1Char('/'))
+            || path.startsWith(QLatin1Char('\\')) || path.contains(QLatin1Char(':'))) {
+        return false;
+    }
+
+    static const QRegularExpression separators(QLatin1String("[/\\\\]"));
+    foreach (const QString &component, path.split(separators)) {
+        if (component == QLatin1String(".."))
+            return false;
+    }
+    return true;
+}
+
 /*!
     \internal
 */
@@ -375,17 +405,161 @@ void QInstaller::copyDirectoryContents(const QString &sourceDir, const QString &
             copyDirectoryContents(QDir(sourceDir).absoluteFilePath(i.fileName()),
                 QDir(targetDir).absoluteFilePath(i.fileName()));
         } else {
-            QFile f(i.filePath());
-            const QString target = QDir(targetDir).absoluteFilePath(i.fileName());
-            if (!f.copy(target)) {
+            copyFile(i.filePath(), QDir(targetDir).absoluteFilePath(i.fileName()));
+        }
+    }
+}
+
+#ifdef Q_OS_LINUX
+/*
+    Makes \a outFd share the data blocks of \a inFd instead of copying them, which is
+    supported by copy-on-write file systems like Btrfs and XFS if both files reside on
+    the same file system. Returns \c true on success.
+*/
+static bool cloneFile(int inFd, int outFd)
+{
+#ifdef FICLONE
+    return ::ioctl(outFd, FICLONE, inFd) == 0;
+#else
+    Q_UNUSED(inFd)
+    Q_UNUSED(outFd)
+    return false;
+#endif
+}
+
+/*
+    Copies \a size bytes from \a inFd to \a outFd without moving the data through
+    user space, first with copy_file_range() and then with sendfile() if the former
+    is not supported for the given file systems. Returns the number of bytes copied,
+    which is less than \a size if the kernel cannot copy the data at all.
+*/
+static qint64 kernelCopyFile(int inFd, int outFd, qint64 size,
+    const std::function<bool(qint64)> &progress, const QString &source)
+{
+    static const qint64 ChunkSize = 16 * 1024 * 1024;
+
+    qint64 copied = 0;
+    bool useSendfile = false;
+    while (copied < size) {
+        const size_t chunk = static_cast<size_t>(qMin(size - copied, ChunkSize));
+        errno = 0;
+        const ssize_t written = useSendfile
+            ? ::sendfile(outFd, inFd, nullptr, chunk)
+            : ::copy_file_range(inFd, nullptr, outFd, nullptr, chunk, 0);
+        if (written > 0) {
+            copied += written;
+            if (progress && !progress(copied)) {
                 throw Error(QCoreApplication::translate("QInstaller",
-                    "Cannot copy file from \"%1\" to \"%2\": %3").arg(
-                                QDir::toNativeSeparators(f.fileName()),
-                                QDir::toNativeSeparators(target),
-                                f.errorString()));
+                    "Copying of file \"%1\" was canceled.").arg(QDir::toNativeSeparators(source)));
+            }
+            continue;
+        }
+        if (written == 0)
+            break; // source was truncated while copying, let the caller handle the rest
+        if (errno == EINTR)
+            continue;
+        if (copied == 0 && !useSendfile && (errno == ENOSYS || errno == EXDEV
+                || errno == EINVAL || errno == EOPNOTSUPP)) {
+            useSendfile = true;
+            continue;
+        }
+        if (copied == 0 && (errno == ENOSYS || errno == EINVAL))
+            break; // neither is usable, fall back to a user space copy
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot copy file \"%1\": %2").arg(QDir::toNativeSeparators(source),
+                                               errnoToQString(errno)));
+    }
+    return copied;
+}
+#endif
+
+/*!
+    \internal
+
+    Copies the file \a source to \a target and preserves the permissions of the source
+    file. Like QFile::copy(), this fails if \a target exists, unless \a mode is
+    QInstaller::OverwriteFile, in which case an existing \a target is truncated and
+    replaced. On Linux the target is created
+    as a reflink sharing the data of the source where the file system supports it,
+    otherwise the data is copied by the kernel with \c copy_file_range() or
+    \c sendfile(). On other platforms and for files not supporting these, for
+    example Qt resources, the data is copied in large blocks.
+
+    If \a progress is given it is called with the number of bytes copied so far,
+    returning \c false from it cancels the copy. Returns the number of bytes copied.
+
+    Throws QInstaller::Error if the file cannot be copied, in which case a partially
+    written \a target is removed. An existing \a target that is not overwritten is
+    left untouched.
+*/
+qint64 QInstaller::copyFile(const QString &source, const QString &target,
+    const std::function<bool(qint64)> &progress, CopyFileMode mode)
+{
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot open file \"%1\" for reading: %2").arg(QDir::toNativeSeparators(source),
+                                                           in.errorString()));
+    }
+    QFile out(target);
+    const QIODevice::OpenMode openMode = QIODevice::WriteOnly | QIODevice::Unbuffered
+        | (mode == OverwriteFile ? QIODevice::Truncate : QIODevice::NewOnly);
+    if (!out.open(openMode)) {
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot open file \"%1\" for writing: %2").arg(QDir::toNativeSeparators(target),
+                                                           out.errorString()));
+    }
+
+    qint64 copied = 0;
+    try {
+        const qint64 size = in.size();
+#ifdef Q_OS_LINUX
+        if (in.handle() != -1 && out.handle() != -1) {
+            if (size > 0 && cloneFile(in.handle(), out.handle())) {
+                if (progress && !progress(size)) {
+                    throw Error(QCoreApplication::translate("QInstaller",
+                        "Copying of file \"%1\" was canceled.").arg(QDir::toNativeSeparators(source)));
+                }
+                out.setPermissions(in.permissions());
+                return size;
+            }
+            copied = kernelCopyFile(in.handle(), out.handle(), size, progress, source);
+        }
+#endif
+        if (copied > 0 && (!in.seek(copied) || !out.seek(copied))) {
+            throw Error(QCoreApplication::translate("QInstaller",
+                "Cannot copy file from \"%1\" to \"%2\": %3").arg(QDir::toNativeSeparators(source),
+                    QDir::toNativeSeparators(target), in.errorString()));
+        }
+
+        QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+        while (true) {
+            const qint64 numRead = in.read(buffer.data(), buffer.size());
+            if (numRead < 0) {
+                throw Error(QCoreApplication::translate("QInstaller",
+                    "Cannot read from file \"%1\": %2").arg(QDir::toNativeSeparators(source),
+                                                            in.errorString()));
+            }
+            if (numRead == 0)
+                break;
+            if (out.write(buffer.constData(), numRead) != numRead) {
+                throw Error(QCoreApplication::translate("QInstaller",
+                    "Cannot write to file \"%1\": %2").arg(QDir::toNativeSeparators(target),
+                                                           out.errorString()));
+            }
+            copied += numRead;
+            if (progress && !progress(copied)) {
+                throw Error(QCoreApplication::translate("QInstaller",
+                    "Copying of file \"%1\" was canceled.").arg(QDir::toNativeSeparators(source)));
             }
         }
+        out.setPermissions(in.permissions());
+    } catch (const Error &) {
+        out.close();
+        out.remove();
+        throw;
     }
+    return copied;
 }
 
 /*!
@@ -482,6 +656,32 @@ QString QInstaller::generateTemporaryFileName(const QString &templ)
     return f.fileName();
 }
 
+/*!
+    Renames the existing file \a fileName to a unique backup name next to it, so that the
+    file can be replaced. Returns the backup name, or an empty string if \a fileName does
+    not exist. Throws Error if the file cannot be renamed.
+*/
+QString QInstaller::backupFile(const QString &fileName)
+{
+    if (!QFile::exists(fileName))
+        return QString();
+
+    const QString backupName = fileName + QLatin1String(".tmpUpdate");
+    QString backup = backupName;
+    int i = 0;
+    while (QFile::exists(backup))
+        backup = backupName + QString::fromLatin1(".%1").arg(i++);
+
+    QFile f(fileName);
+    const bool renamed = f.rename(backup);
+    if (f.exists() && !renamed) {
+        throw Error(QCoreApplication::translate("QInstaller", "Cannot rename %1 to %2: %3")
+            .arg(QDir::toNativeSeparators(fileName), QDir::toNativeSeparators(backup),
+            f.errorString()));
+    }
+    return renamed ? backup : QString();
+}
+
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
 
@@ -36,6 +36,8 @@
 #include <QtXml/QDomDocument>
 #include <QtXml/QDomNodeList>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 class QFileInfo;
 class QFile;
@@ -49,6 +51,11 @@ enum DefaultFilePermissions {
     Executable = 0x7755
 };
 
+enum CopyFileMode {
+    NewFileOnly,
+    OverwriteFile
+};
+
 class INSTALLER_EXPORT TempDirDeleter
 {
 public:
@@ -80,12 +87,16 @@ private:
     bool INSTALLER_EXPORT setDefaultFilePermissions(QFile *file, DefaultFilePermissions permissions);
 
     QString INSTALLER_EXPORT generateTemporaryFileName(const QString &templ=QString());
+    QString INSTALLER_EXPORT backupFile(const QString &fileName);
 
     void INSTALLER_EXPORT moveDirectoryContents(const QString &sourceDir, const QString &targetDir);
     void INSTALLER_EXPORT copyDirectoryContents(const QString &sourceDir, const QString &targetDir);
+    qint64 INSTALLER_EXPORT copyFile(const QString &source, const QString &target,
+        const std::function<bool(qint64)> &progress = nullptr, CopyFileMode mode = NewFileOnly);
 
     bool INSTALLER_EXPORT isLocalUrl(const QUrl &url);
     QString INSTALLER_EXPORT pathFromUrl(const QUrl &url);
+    bool INSTALLER_EXPORT isContainedRelativePath(const QString &path);
 
     void INSTALLER_EXPORT mkdir(const QString &path);
     void INSTALLER_EXPORT mkpath(const QString &path);
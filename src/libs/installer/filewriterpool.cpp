@@ -0,0 +1,189 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "filewriterpool.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentRun>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::FileWriterPool
+    \internal
+    \brief The FileWriterPool class writes extracted files concurrently.
+
+    For archives with many small files, creating, writing and closing the files and setting
+    their attributes takes longer than decompressing them. The decoding thread hands the
+    complete content of small files to the pool instead, which writes them on several
+    threads while decoding continues.
+
+    Entries that need to be written in order, like directories and links, are still written
+    by the decoding thread. Before doing so, it must call waitForPath() or waitForDone()
+    to make sure no pending write conflicts with the entry.
+*/
+
+/*!
+    \class QInstaller::FileWriterPool::Entry
+    \internal
+    \brief The Entry struct holds the content and attributes of a file to write.
+*/
+
+static const quint64 scMaxBufferedFileSize = 1024 * 1024;
+static const qint64 scMaxPendingBytes = 64 * 1024 * 1024;
+
+/*!
+    Constructs a pool writing files with up to \a threadCount threads. The default value
+    \c 0 uses as many threads as there are processor cores.
+*/
+FileWriterPool::FileWriterPool(int threadCount)
+    : m_pendingBytes(0)
+{
+    m_pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+}
+
+/*!
+    Waits for all pending writes and destroys the pool.
+*/
+FileWriterPool::~FileWriterPool()
+{
+    m_pool.waitForDone();
+}
+
+/*!
+    Returns \c true if files of \a size bytes should be buffered and handed to the pool;
+    larger files are better streamed to disk by the decoding thread.
+*/
+bool FileWriterPool::isBufferedSize(quint64 size)
+{
+    return size <= scMaxBufferedFileSize;
+}
+
+/*!
+    Queues \a entry for writing. Blocks while too much data is pending. Returns \c false
+    if a previous write failed, in which case the extraction should be aborted.
+*/
+bool FileWriterPool::write(const Entry &entry)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // bound the memory held by queued files, the decoder waits for the writers
+        while (m_pendingBytes > 0 && m_pendingBytes + entry.data.size() > scMaxPendingBytes)
+            m_finished.wait(&m_mutex);
+        if (!m_errorString.isEmpty())
+            return false;
+        m_pendingBytes += entry.data.size();
+        ++m_pendingPaths[entry.path];
+    }
+    QtConcurrent::run(&m_pool, [this, entry]() { writeEntry(entry); });
+    return true;
+}
+
+/*!
+    Blocks until no write to \a path is pending.
+*/
+void FileWriterPool::waitForPath(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pendingPaths.contains(path))
+        m_finished.wait(&m_mutex);
+}
+
+/*!
+    Blocks until all pending writes are done. Returns \c false if any of them failed.
+*/
+bool FileWriterPool::waitForDone()
+{
+    m_pool.waitForDone();
+
+    QMutexLocker _(&m_mutex);
+    return m_errorString.isEmpty();
+}
+
+/*!
+    Returns a human-readable description of the first error that occurred.
+*/
+QString FileWriterPool::errorString() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_errorString;
+}
+
+/*!
+    \internal
+*/
+void FileWriterPool::writeEntry(const Entry &entry)
+{
+    QString error;
+    QFile file(entry.path);
+    // do not follow symlinks, replace them like the decoding thread does
+    if (QFileInfo(entry.path).isSymLink())
+        QFile::remove(entry.path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        // the archive does not necessarily contain entries for all parent directories
+        QDir().mkpath(QFileInfo(entry.path).absolutePath());
+        file.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+
+    if (!file.isOpen()) {
+        error = QCoreApplication::translate("FileWriterPool",
+            "Cannot open file \"%1\" for writing: %2").arg(QDir::toNativeSeparators(entry.path),
+            file.errorString());
+    } else if (file.write(entry.data) != entry.data.size()) {
+        error = QCoreApplication::translate("FileWriterPool",
+            "Cannot write file \"%1\": %2").arg(QDir::toNativeSeparators(entry.path),
+            file.errorString());
+    } else {
+        // failing to restore the times is not an error, same as for sequential extraction
+        if (entry.lastModified.isValid())
+            file.setFileTime(entry.lastModified, QFileDevice::FileModificationTime);
+        if (entry.lastRead.isValid())
+            file.setFileTime(entry.lastRead, QFileDevice::FileAccessTime);
+        if (entry.birthTime.isValid())
+            file.setFileTime(entry.birthTime, QFileDevice::FileBirthTime);
+        file.close();
+        if (entry.hasPermissions)
+            QFile::setPermissions(entry.path, entry.permissions);
+    }
+
+    {
+        QMutexLocker _(&m_mutex);
+        if (!error.isEmpty() && m_errorString.isEmpty())
+            m_errorString = error;
+        m_pendingBytes -= entry.data.size();
+        if (--m_pendingPaths[entry.path] == 0)
+            m_pendingPaths.remove(entry.path);
+    }
+    m_finished.wakeAll();
+}
+
+} // namespace QInstaller
@@ -0,0 +1,84 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef FILEWRITERPOOL_H
+#define FILEWRITERPOOL_H
+
+#include "installer_global.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT FileWriterPool
+{
+    Q_DISABLE_COPY(FileWriterPool)
+
+public:
+    struct Entry
+    {
+        QString path;
+        QByteArray data;
+        QDateTime lastModified;
+        QDateTime lastRead;
+        QDateTime birthTime;
+        QFile::Permissions permissions = QFile::Permissions();
+        bool hasPermissions = false;
+    };
+
+    explicit FileWriterPool(int threadCount = 0);
+    ~FileWriterPool();
+
+    static bool isBufferedSize(quint64 size);
+
+    bool write(const Entry &entry);
+    void waitForPath(const QString &path);
+    bool waitForDone();
+
+    QString errorString() const;
+
+private:
+    void writeEntry(const Entry &entry);
+
+private:
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    QWaitCondition m_finished;
+    QHash<QString, int> m_pendingPaths;
+    qint64 m_pendingBytes;
+    QString m_errorString;
+};
+
+} // namespace QInstaller
+
+#endif // FILEWRITERPOOL_H
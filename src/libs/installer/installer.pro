@@ -118,6 +118,8 @@ HEADERS += packagemanagercore.h \
     remoteclient_p.h \
     remoteserver_p.h \
     remotefileengine.h \
+    remotefileoperations.h \
+    fileoperationsworker.h \
     remoteserverconnection.h \
     remoteserverconnection_p.h \
     fileio.h \
@@ -141,6 +143,10 @@ HEADERS += packagemanagercore.h \
     commandlineparser_p.h \
     abstractarchive.h \
     directoryguard.h \
+    checksumverifier.h \
+    contentchunks.h \
+    binarydelta.h \
+    filewriterpool.h \
     lib7zarchive.h \
     archivefactory.h
 
@@ -149,6 +155,10 @@ SOURCES += packagemanagercore.cpp \
     archivefactory.cpp \
     aspectratiolabel.cpp \
     directoryguard.cpp \
+    checksumverifier.cpp \
+    contentchunks.cpp \
+    binarydelta.cpp \
+    filewriterpool.cpp \
     lib7zarchive.cpp \
     loggingutils.cpp \
     packagemanagercore_p.cpp \
@@ -211,6 +221,8 @@ SOURCES += packagemanagercore.cpp \
     remoteclient.cpp \
     remoteserver.cpp \
     remotefileengine.cpp \
+    remotefileoperations.cpp \
+    fileoperationsworker.cpp \
     remoteserverconnection.cpp \
     fileio.cpp \
     binarycontent.cpp \
@@ -62,9 +62,12 @@ namespace Lib7z
     };
 
     void INSTALLER_EXPORT createArchive(QFileDevice *archive, const QStringList &sources,
-        Compression level = Compression::Normal, UpdateCallback *callback = 0);
+        Compression level = Compression::Normal, UpdateCallback *callback = 0,
+        int threads = 0, qint64 solidBlockSize = 0,
+        const QList<QCryptographicHash *> &hashes = QList<QCryptographicHash *>());
     void INSTALLER_EXPORT createArchive(const QString &archive, const QStringList &sources,
-        TmpFile mode, Compression level = Compression::Normal, UpdateCallback *callback = 0);
+        TmpFile mode, Compression level = Compression::Normal, UpdateCallback *callback = 0,
+        int threads = 0, qint64 solidBlockSize = 0);
 
 } // namespace Lib7z
 
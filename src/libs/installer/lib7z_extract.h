@@ -40,30 +40,43 @@
 #define LIB7Z_EXTRACT_H
 
 #include "installer_global.h"
+#include "directoryguard.h"
 
 #include <Common/MyCom.h>
 #include <7zip/Archive/IArchive.h>
 
+#include <QByteArray>
 #include <QString>
+#include <QStringList>
 
 class CArc;
 
+namespace QInstaller {
+class ChecksumVerifier;
+class FileWriterPool;
+}
+
 QT_BEGIN_NAMESPACE
 class QFileDevice;
 QT_END_NAMESPACE
 
 namespace Lib7z
 {
+    class ParallelExtractCallback;
+
     class INSTALLER_EXPORT ExtractCallback : public IArchiveExtractCallback, public CMyUnknownImp
     {
         Q_DISABLE_COPY(ExtractCallback)
+        friend class ParallelExtractCallback;
 
     public:
         ExtractCallback() = default;
         virtual ~ExtractCallback() = default;
 
         void setArchive(CArc *carc) { arc = carc; }
-        void setTarget(const QString &dir) { targetDir = dir; }
+        void setTarget(const QString &dir) { targetDir = dir; directoryCache.clear(); }
+
+        const QInstaller::DirectoryCache &directories() const { return directoryCache; }
 
         MY_UNKNOWN_IMP
         INTERFACE_IArchiveExtractCallback(;)
@@ -77,13 +90,21 @@ namespace Lib7z
         CArc *arc = 0;
 
         QString targetDir;
+        QInstaller::DirectoryCache directoryCache;
         quint64 total = 0;
         quint64 completed = 0;
         quint32 currentIndex = 0;
+
+        QInstaller::FileWriterPool *writerPool = nullptr;
+        QInstaller::ChecksumVerifier *verifier = nullptr;
+        QByteArray bufferedData;
+        bool buffered = false;
     };
 
     void INSTALLER_EXPORT extractArchive(QFileDevice *archive, const QString &targetDirectory,
-        ExtractCallback *callback = 0);
+        ExtractCallback *callback = 0, int threadCount = 0,
+        QInstaller::ChecksumVerifier *verifier = nullptr,
+        const QStringList &entries = QStringList());
 
 } // namespace Lib7z
 
@@ -28,6 +28,7 @@
 
 #include "lib7z_facade.h"
 
+#include "checksumverifier.h"
 #include "errors.h"
 #include "fileio.h"
 
@@ -37,6 +38,7 @@
 #include "lib7z_guid.h"
 #include "globals.h"
 #include "directoryguard.h"
+#include "filewriterpool.h"
 
 #ifndef Q_OS_WIN
 #   include "StdAfx.h"
@@ -54,14 +56,22 @@
 #include <Windows/PropVariant.h>
 #include <Windows/PropVariantConv.h>
 
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFileInfo>
 #include <QIODevice>
+#include <QMap>
+#include <QMutex>
 #include <QPointer>
 #include <QReadWriteLock>
 #include <QTemporaryFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
+#include <algorithm>
 #include <mutex>
 #include <memory>
 
@@ -333,6 +343,14 @@ static bool getFileTimeFromProperty(IInArchive* archive, int index, int propId,
     return !IsFileTimeZero(ft);
 }
 
+static QDateTime dateTimeFromFileTime(const FILETIME &ft)
+{
+    // 100-nanosecond intervals since January 1, 1601 (UTC)
+    const quint64 intervals = (quint64(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    return QDateTime::fromMSecsSinceEpoch(qint64(intervals / 10000) - Q_INT64_C(11644473600000),
+        Qt::UTC);
+}
+
 static bool getDateTimeProperty(IInArchive *arc, int index, int id, QDateTime *value)
 {
     FILETIME ft7z;
@@ -436,10 +454,12 @@ class QIODeviceInStream : public IInStream, public CMyUnknownImp
 public:
     MY_UNKNOWN_IMP
 
-    explicit QIODeviceInStream(QIODevice *device)
+    explicit QIODeviceInStream(QIODevice *device,
+            QInstaller::ChecksumVerifier *verifier = nullptr)
         : IInStream()
         , CMyUnknownImp()
         , m_device(device)
+        , m_verifier(verifier)
     {
         LIB7Z_ASSERTS(m_device, Readable)
     }
@@ -449,8 +469,11 @@ public:
         if (m_device.isNull())
             return E_FAIL;
 
+        const qint64 offset = m_device->pos();
         const qint64 actual = m_device->read(reinterpret_cast<char*>(data), size);
         Q_ASSERT(actual != 0 || m_device->atEnd());
+        if (m_verifier && actual > 0)
+            m_verifier->addData(offset, reinterpret_cast<const char*>(data), actual);
         if (processedSize)
             *processedSize = actual;
         return actual >= 0 ? S_OK : E_FAIL;
@@ -486,6 +509,7 @@ public:
 
 private:
     QPointer<QIODevice> m_device;
+    QInstaller::ChecksumVerifier *m_verifier;
 };
 
 /*!
@@ -601,6 +625,7 @@ STDMETHODIMP ExtractCallback::SetCompleted(const UInt64 *c)
 STDMETHODIMP ExtractCallback::GetStream(UInt32 index, ISequentialOutStream **outStream, Int32 /*askExtractMode*/)
 {
     *outStream = nullptr;
+    buffered = false;
     if (targetDir.isEmpty())
         return E_FAIL;
 
@@ -616,20 +641,29 @@ STDMETHODIMP ExtractCallback::GetStream(UInt32 index, ISequentialOutStream **out
 
     const QFileInfo fi(QString::fromLatin1("%1/%2").arg(targetDir, UString2QString(s)));
 
-    QInstaller::DirectoryGuard guard(fi.absolutePath());
-    const QStringList directories = guard.tryCreate();
-
     bool isDir = false;
     Archive_IsItem_Folder(arc->Archive, index, isDir);
-    if (isDir)
-        QDir(fi.absolutePath()).mkdir(fi.fileName());
+
+    // directories this extraction already created or saw are not checked on disk again
+    QInstaller::DirectoryGuard guard(isDir ? fi.absoluteFilePath() : fi.absolutePath(),
+        &directoryCache);
+    const QStringList directories = guard.tryCreate();
 
     // this makes sure that all directories created get removed as well
-    foreach (const QString &directory, directories)
-        setCurrentFile(directory);
+    foreach (const QString &directory, directories) {
+        if (directory != fi.absoluteFilePath())
+            setCurrentFile(directory);
+    }
+
+    // an earlier entry with the same path might still be written
+    if (!isDir && writerPool)
+        writerPool->waitForPath(fi.absoluteFilePath());
 
-    if (!isDir && !prepareForFile(fi.absoluteFilePath()))
+    if (!isDir && !prepareForFile(fi.absoluteFilePath())) {
+        setLastError(QCoreApplication::translate("ExtractCallbackImpl",
+            "Cannot prepare for file \"%1\".").arg(QDir::toNativeSeparators(fi.absoluteFilePath())));
         return E_FAIL;
+    }
 
     setCurrentFile(fi.absoluteFilePath());
 
@@ -642,15 +676,27 @@ STDMETHODIMP ExtractCallback::GetStream(UInt32 index, ISequentialOutStream **out
             return E_FAIL;
         }
 #endif
-        std::unique_ptr<QFile> file(new QFile(fi.absoluteFilePath()));
-        if (!file->open(QIODevice::WriteOnly)) {
+        // small files are collected in memory and written by the writer pool,
+        // symlinks are created from the extracted file in SetOperationResult()
+        const quint32 attributes = getUInt32Property(arc->Archive, index, kpidAttrib, 0);
+        buffered = writerPool && !S_ISLNK(attributes >> 16) && QInstaller::FileWriterPool
+            ::isBufferedSize(getUInt64Property(arc->Archive, index, kpidSize, 0));
+
+        std::unique_ptr<QIODevice> device;
+        if (buffered) {
+            bufferedData.clear();
+            device.reset(new QBuffer(&bufferedData));
+        } else {
+            device.reset(new QFile(fi.absoluteFilePath()));
+        }
+        if (!device->open(QIODevice::WriteOnly)) {
             setLastError(QCoreApplication::translate("ExtractCallbackImpl",
                                                      "Cannot open file \"%1\" for writing: %2").arg(
-                             QDir::toNativeSeparators(fi.absoluteFilePath()), file->errorString()));
+                             QDir::toNativeSeparators(fi.absoluteFilePath()), device->errorString()));
             return E_FAIL;
         }
         CMyComPtr<ISequentialOutStream> stream =
-            new QIODeviceSequentialOutStream(std::move(file));
+            new QIODeviceSequentialOutStream(std::move(device));
         *outStream = stream.Detach(); // CMyComPtr is needed, otherwise it crashes in Write().
     }
 
@@ -684,6 +730,34 @@ STDMETHODIMP ExtractCallback::SetOperationResult(Int32 /*resultEOperationResult*
     const QString absFilePath = QFileInfo(QString::fromLatin1("%1/%2").arg(targetDir,
         UString2QString(s).replace(QLatin1Char('\\'), QLatin1Char('/')))).absoluteFilePath();
 
+    if (buffered) {
+        buffered = false;
+        QInstaller::FileWriterPool::Entry entry;
+        entry.path = absFilePath;
+        entry.data = bufferedData;
+        bufferedData.clear();
+        try {
+            FILETIME fileTime;
+            if (getFileTimeFromProperty(arc->Archive, currentIndex, kpidMTime, &fileTime))
+                entry.lastModified = dateTimeFromFileTime(fileTime);
+#ifdef Q_OS_WIN
+            if (getFileTimeFromProperty(arc->Archive, currentIndex, kpidATime, &fileTime))
+                entry.lastRead = dateTimeFromFileTime(fileTime);
+            if (getFileTimeFromProperty(arc->Archive, currentIndex, kpidCTime, &fileTime))
+                entry.birthTime = dateTimeFromFileTime(fileTime);
+#else
+            entry.lastRead = entry.lastModified;
+#endif
+        } catch (...) {}
+        entry.permissions = getPermissions(arc->Archive, currentIndex, &entry.hasPermissions);
+
+        if (!writerPool->write(entry)) {
+            setLastError(writerPool->errorString());
+            return E_FAIL;
+        }
+        return S_OK;
+    }
+
     // do we have a symlink?
     const quint32 attributes = getUInt32Property(arc->Archive, currentIndex, kpidAttrib, 0);
     struct stat stat_info;
@@ -825,6 +899,338 @@ STDMETHODIMP ExtractCallback::SetOperationResult(Int32 /*resultEOperationResult*
     \internal
 */
 
+// -- ParallelExtractCallback
+
+/*
+    Opens \a archive into \a archiveLink, using \a codecs and \a stream, which must
+    outlive the archive link.
+*/
+static void openArchiveLink(QFileDevice *archive, CCodecs *codecs,
+    const CMyComPtr<IInStream> &stream, CArchiveLink *archiveLink)
+{
+    if (codecs->Load() != S_OK)
+        throw SevenZipException(QCoreApplication::translate("Lib7z", "Cannot load codecs."));
+
+    COpenOptions op;
+    op.codecs = codecs;
+
+    CObjectVector<COpenType> types;
+    op.types = &types;  // Empty, because we use a stream.
+
+    CIntVector excluded;
+    excluded.Add(codecs->FindFormatForExtension(
+        QString2UString(QLatin1String("xz")))); // handled by libarchive
+    op.excludedFormats = &excluded;
+    op.stream = stream; // CMyComPtr is needed, otherwise it crashes in OpenStream().
+
+    CObjectVector<CProperty> properties;
+    op.props = &properties;
+
+    if (archiveLink->Open2(op, nullptr) != S_OK) {
+        throw SevenZipException(QCoreApplication::translate("Lib7z",
+            "Cannot open archive \"%1\".").arg(archive->fileName()));
+    }
+}
+
+/*
+    Returns the indices of the items of \a arc to extract: all items if \a entries is empty,
+    otherwise the items whose path is one of \a entries or lies inside one of them. Throws
+    SevenZipException if one of \a entries is not part of the archive.
+*/
+static QVector<UInt32> selectItems(const CArc &arc, const QStringList &entries)
+{
+    UInt32 numItems = 0;
+    if (arc.Archive->GetNumberOfItems(&numItems) != S_OK) {
+        throw SevenZipException(QCoreApplication::translate("Lib7z",
+            "Cannot retrieve number of items in archive."));
+    }
+
+    QVector<UInt32> items;
+    if (entries.isEmpty()) {
+        items.reserve(int(numItems));
+        for (UInt32 item = 0; item < numItems; ++item)
+            items.append(item);
+        return items;
+    }
+
+    QStringList missing;
+    foreach (const QString &entry, entries)
+        missing.append(QDir::cleanPath(QDir::fromNativeSeparators(entry)));
+    const QStringList wanted = missing;
+    for (UInt32 item = 0; item < numItems; ++item) {
+        UString s;
+        if (arc.GetItemPath(item, s) != S_OK) {
+            throw SevenZipException(QCoreApplication::translate("Lib7z",
+                "Cannot retrieve path of archive item \"%1\".").arg(item));
+        }
+        const QString path = QDir::cleanPath(UString2QString(s).replace(QLatin1Char('\\'),
+            QLatin1Char('/')));
+        bool selected = false;
+        foreach (const QString &entry, wanted) {
+            if (path == entry || path.startsWith(entry + QLatin1Char('/'))) {
+                missing.removeAll(entry);
+                selected = true;
+            }
+        }
+        if (selected)
+            items.append(item);
+    }
+    if (!missing.isEmpty()) {
+        throw SevenZipException(QCoreApplication::translate("Lib7z",
+            "Cannot find \"%1\" in archive.").arg(missing.first()));
+    }
+    return items;
+}
+
+/*
+    Shared state of all threads of a parallel extraction.
+*/
+struct ParallelExtractState
+{
+    struct Block {
+        QVector<UInt32> indices;
+        quint64 size = 0;
+    };
+
+    ParallelExtractState(ExtractCallback *callback, int threads, quint64 totalSize)
+        : target(callback)
+        , completed(threads, 0)
+        , total(totalSize)
+    {}
+
+    void fail(const QString &error)
+    {
+        QMutexLocker _(&mutex);
+        if (errorString.isEmpty())
+            errorString = error;
+        aborted.storeRelease(1);
+    }
+
+    ExtractCallback *const target;
+    QMutex mutex;
+    QVector<quint64> completed;
+    const quint64 total;
+    QAtomicInt aborted;
+    QString errorString;
+
+    QString archiveName;
+    QString targetDir;
+    QInstaller::DirectoryCache directoryCache;
+    QVector<Block> blocks;
+    QAtomicInt nextBlock;
+};
+
+/*
+    Extraction callback of a single thread of a parallel extraction. The calls into the
+    callback passed to extractArchive() are serialized, progress is summed up over all
+    threads.
+*/
+class ParallelExtractCallback : public ExtractCallback
+{
+    Q_DISABLE_COPY(ParallelExtractCallback)
+
+public:
+    ParallelExtractCallback(ParallelExtractState *state, int slot)
+        : m_state(state)
+        , m_slot(slot)
+        , m_base(0)
+    {}
+
+    static bool extract(QFileDevice *archive, const QString &directory, ExtractCallback *callback,
+        CArchiveLink *archiveLink, const QVector<UInt32> &items, int threadCount);
+
+protected:
+    bool prepareForFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        QMutexLocker _(&m_state->mutex);
+        return m_state->target->prepareForFile(filename);
+    }
+
+    void setCurrentFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        QMutexLocker _(&m_state->mutex);
+        m_state->target->setCurrentFile(filename);
+    }
+
+    HRESULT setCompleted(quint64 completed, quint64 /*total*/) Q_DECL_OVERRIDE
+    {
+        if (m_state->aborted.loadAcquire())
+            return E_ABORT;
+
+        QMutexLocker _(&m_state->mutex);
+        m_state->completed[m_slot] = m_base + completed;
+        quint64 sum = 0;
+        foreach (const quint64 value, m_state->completed)
+            sum += value;
+        const HRESULT result = m_state->target->setCompleted(sum, m_state->total);
+        if (result != S_OK)
+            m_state->aborted.storeRelease(1);
+        return result;
+    }
+
+private:
+    static void run(ParallelExtractState *state, int slot);
+
+private:
+    ParallelExtractState *const m_state;
+    const int m_slot;
+    quint64 m_base;
+};
+
+/*
+    Extracts the 7z \a archive already opened in \a archiveLink to \a directory with up to
+    \a threadCount threads, each of them decoding whole solid blocks with its own archive
+    handler. Returns \c false without extracting anything if the archive does not consist of
+    several blocks or the archive file cannot be opened a second time.
+*/
+bool ParallelExtractCallback::extract(QFileDevice *archive, const QString &directory,
+    ExtractCallback *callback, CArchiveLink *archiveLink, const QVector<UInt32> &items,
+    int threadCount)
+{
+    if (archiveLink->Arcs.Size() != 1 || archive->fileName().isEmpty())
+        return false;
+
+    IInArchive *const arch = archiveLink->Arcs[0].Archive;
+    NCOM::CPropVariant numBlocks;
+    if (arch->GetArchiveProperty(kpidNumBlocks, &numBlocks) != S_OK || numBlocks.vt != VT_UI4)
+        return false;
+
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    threadCount = qMin(threadCount, static_cast<int>(numBlocks.ulVal));
+    if (threadCount < 2)
+        return false;
+
+    // group the items by the solid block they are stored in, items without data
+    // (directories, empty files) are collected in a block of their own
+    static const quint32 NoBlock = 0xFFFFFFFF;
+    QMap<quint32, ParallelExtractState::Block> blocks;
+    QSet<QString> directories;
+    quint64 totalSize = 0;
+    foreach (const UInt32 item, items) {
+        UString s;
+        if (archiveLink->Arcs[0].GetItemPath(item, s) != S_OK) {
+            throw SevenZipException(QCoreApplication::translate("Lib7z",
+                "Cannot retrieve path of archive item \"%1\".").arg(item));
+        }
+        const QFileInfo fi(QString::fromLatin1("%1/%2").arg(directory, UString2QString(s)));
+        bool isDir = false;
+        Archive_IsItem_Folder(arch, item, isDir);
+        directories.insert(isDir ? fi.absoluteFilePath() : fi.absolutePath());
+
+        const quint64 size = getUInt64Property(arch, item, kpidSize, 0);
+        ParallelExtractState::Block &block = blocks[getUInt32Property(arch, item, kpidBlock,
+            NoBlock)];
+        block.indices.append(item);
+        block.size += size;
+        totalSize += size;
+    }
+
+    // only a few blocks are involved when extracting single entries
+    threadCount = qMin(threadCount, blocks.size());
+    if (threadCount < 2)
+        return false;
+
+    // Create the directory tree up front, in the calling thread, so that the extracting
+    // threads neither race on creating nor need to check for the same directories.
+    QStringList sortedDirectories = directories.values();
+    std::sort(sortedDirectories.begin(), sortedDirectories.end());
+    try {
+        foreach (const QString &path, sortedDirectories) {
+            QInstaller::DirectoryGuard guard(path, &callback->directoryCache);
+            foreach (const QString &created, guard.tryCreate())
+                callback->setCurrentFile(created);
+            guard.release();
+        }
+    } catch (const QInstaller::Error &e) {
+        throw SevenZipException(e.message());
+    }
+
+    ParallelExtractState state(callback, threadCount, totalSize);
+    state.archiveName = archive->fileName();
+    state.targetDir = directory;
+    state.directoryCache = callback->directoryCache;
+    state.blocks = blocks.values().toVector();
+    // start with the largest blocks to keep all threads busy until the end
+    std::sort(state.blocks.begin(), state.blocks.end(),
+        [](const ParallelExtractState::Block &lhs, const ParallelExtractState::Block &rhs) {
+            return lhs.size > rhs.size;
+        });
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    for (int slot = 0; slot < threadCount; ++slot)
+        QtConcurrent::run(&pool, &ParallelExtractCallback::run, &state, slot);
+
+    pool.waitForDone();
+
+    // the threads might have seen further directories, they are merged into the
+    // state when a thread finishes
+    callback->directoryCache = state.directoryCache;
+
+    if (!state.errorString.isEmpty())
+        throw SevenZipException(state.errorString);
+    return true;
+}
+
+/*
+    Thread function of a parallel extraction, extracts blocks from \a state until all
+    are taken. Uses \a slot to report its progress.
+*/
+void ParallelExtractCallback::run(ParallelExtractState *state, int slot)
+{
+    ParallelExtractCallback *const extractCallback = new ParallelExtractCallback(state, slot);
+    const CMyComPtr<IArchiveExtractCallback> callback = extractCallback;
+    extractCallback->setTarget(state->targetDir);
+    {
+        QMutexLocker _(&state->mutex);
+        extractCallback->directoryCache = state->directoryCache;
+    }
+    extractCallback->writerPool = state->target->writerPool;
+
+    try {
+        QFile file(state->archiveName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            throw SevenZipException(QCoreApplication::translate("Lib7z",
+                "Cannot open archive \"%1\" for reading: %2").arg(state->archiveName,
+                file.errorString()));
+        }
+
+        CCodecs codecs;
+        const CMyComPtr<IInStream> stream = new QIODeviceInStream(&file,
+            state->target->verifier);
+        CArchiveLink archiveLink;
+        openArchiveLink(&file, &codecs, stream, &archiveLink);
+
+        extractCallback->setArchive(&archiveLink.Arcs[0]);
+        IInArchive *const arch = archiveLink.Arcs[0].Archive;
+        for (int i = state->nextBlock.fetchAndAddOrdered(1); i < state->blocks.size();
+                i = state->nextBlock.fetchAndAddOrdered(1)) {
+            if (state->aborted.loadAcquire())
+                break;
+
+            const QVector<UInt32> &indices = state->blocks.at(i).indices;
+            const LONG result = arch->Extract(indices.constData(), indices.size(), false,
+                callback);
+            if (result != S_OK)
+                throw SevenZipException(errorMessageFrom7zResult(result));
+
+            // the progress reported by the archive handler restarts for each call
+            extractCallback->m_base += extractCallback->total;
+            extractCallback->total = 0;
+            extractCallback->completed = 0;
+        }
+    } catch (const QInstaller::Error &e) {
+        state->fail(e.message());
+    } catch (...) {
+        state->fail(QCoreApplication::translate("Lib7z",
+            "Unknown exception caught (%1).").arg(QString::fromLatin1(Q_FUNC_INFO)));
+    }
+
+    QMutexLocker _(&state->mutex);
+    state->directoryCache.unite(extractCallback->directoryCache);
+}
+
 // -- UpdateCallback
 
 HRESULT UpdateCallback::SetTotal(UInt64)
@@ -944,25 +1350,46 @@ static QString createTmp7z()
     more files, one or more directories or a combination of files and folders. Also, \c * wildcard
     is supported. The value of \a level specifies the compression ratio, the default is set
     to \c 5 (Normal compression). The \a callback can be used to get information about the archive
-    creation process. If no \a callback is given, an empty implementation is used.
+    creation process. If no \a callback is given, an empty implementation is used. See the
+    overload below for the meaning of \a threads and \a solidBlockSize.
+
+    The archive is compressed into a temporary file first and then copied to \a archive.
+    The copied data is passed to \a hashes, so the checksums of the archive are known
+    without reading it again.
 
     \note Throws SevenZipException on error.
     \note Filenames are stored case-sensitive with UTF-8 encoding.
     \note The ownership of \a callback is transferred to the function and gets delete on exit.
 */
 void INSTALLER_EXPORT createArchive(QFileDevice *archive, const QStringList &sources,
-    Compression level, UpdateCallback *callback)
+    Compression level, UpdateCallback *callback, int threads, qint64 solidBlockSize,
+    const QList<QCryptographicHash *> &hashes)
 {
     LIB7Z_ASSERTS(archive, Writable)
 
     const QString tmpArchive = createTmp7z();
-    Lib7z::createArchive(tmpArchive, sources, TmpFile::No, level, callback);
-
+    QFile source(tmpArchive);
     try {
-        QFile source(tmpArchive);
+        Lib7z::createArchive(tmpArchive, sources, TmpFile::No, level, callback, threads,
+            solidBlockSize);
+
         QInstaller::openForRead(&source);
-        QInstaller::blockingCopy(&source, archive, source.size());
+        QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+        qint64 remaining = source.size();
+        while (remaining > 0) {
+            const qint64 size = qMin<qint64>(buffer.size(), remaining);
+            QInstaller::blockingRead(&source, buffer.data(), size);
+            QInstaller::blockingWrite(archive, buffer.constData(), size);
+            foreach (QCryptographicHash *hash, hashes)
+                hash->addData(buffer.constData(), int(size));
+            remaining -= size;
+        }
+        source.remove();
+    } catch (const SevenZipException &) {
+        source.remove();
+        throw;
     } catch (const QInstaller::Error &error) {
+        source.remove();
         throw SevenZipException(error.message());
     }
 }
@@ -975,13 +1402,18 @@ void INSTALLER_EXPORT createArchive(QFileDevice *archive, const QStringList &sou
     to \c 5 (Normal compression). The \a callback can be used to get information about the archive
     creation process. If no \a callback is given, an empty implementation is used.
 
+    The LZMA2 compressor uses \a threads threads, or all processor cores if \a threads is \c 0.
+    A positive \a solidBlockSize limits the solid blocks to the given number of bytes, so that
+    the archive can be extracted in parallel, a negative value creates a non-solid archive. If
+    \a solidBlockSize is \c 0, the default block size of the compression \a level is used.
+
     \note Throws SevenZipException on error.
     \note If \a archive exists, it will be overwritten.
     \note Filenames are stored case-sensitive with UTF-8 encoding.
     \note The ownership of \a callback is transferred to the function and gets delete on exit.
 */
 void createArchive(const QString &archive, const QStringList &sources, TmpFile mode,
-    Compression level, UpdateCallback *callback)
+    Compression level, UpdateCallback *callback, int threads, qint64 solidBlockSize)
 {
     try {
         QString target = archive;
@@ -996,7 +1428,14 @@ void createArchive(const QString &archive, const QStringList &sources, TmpFile m
             commandStrings.Add(L"-mtm=on"); // time: modeifier|creation|access
             commandStrings.Add(L"-mtc=on");
             commandStrings.Add(L"-mta=on");
-            commandStrings.Add(L"-mmt=on"); // threads: multi-threaded
+            if (threads > 0) // threads: fixed count|multi-threaded
+                commandStrings.Add(QString2UString(QString::fromLatin1("-mmt=%1").arg(threads)));
+            else
+                commandStrings.Add(L"-mmt=on");
+            if (solidBlockSize < 0) // solid: off|block size in bytes
+                commandStrings.Add(L"-ms=off");
+            else if (solidBlockSize > 0)
+                commandStrings.Add(QString2UString(QString::fromLatin1("-ms=%1b").arg(solidBlockSize)));
 #ifdef Q_OS_WIN
             commandStrings.Add(L"-sccUTF-8"); // files: case-sensitive|UTF8
 #endif
@@ -1071,10 +1510,23 @@ void createArchive(const QString &archive, const QStringList &sources, TmpFile m
     Extracts the given \a archive content into target directory \a directory using the provided
     extract callback \a callback. The output filenames are deduced from the \a archive content.
 
+    7z archives consisting of several solid blocks are extracted with up to \a threadCount
+    threads, each decoding whole blocks. If \a threadCount is \c 0, the number of processor
+    cores is used; \c 1 extracts on the calling thread only. In the parallel case the calls to
+    the protected methods of \a callback are serialized, but made from the extracting threads.
+
+    If \a verifier is set, it is passed the archive data as it is read for decoding, and
+    the extraction fails if the checksum of the archive does not match.
+
+    If \a entries is not empty, only the items with these paths and the contents of
+    directories with these paths are extracted. For archives without solid blocks only the
+    data of these items is decoded.
+
     \note Throws SevenZipException on error.
     \note The ownership of \a callback is not transferred to the function.
 */
-void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallback *callback)
+void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallback *callback,
+    int threadCount, QInstaller::ChecksumVerifier *verifier, const QStringList &entries)
 {
     LIB7Z_ASSERTS(archive, Readable)
 
@@ -1088,49 +1540,58 @@ void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallb
     }
 
     QInstaller::DirectoryGuard outDir(QFileInfo(directory).absolutePath());
+    // declared after the guard, so pending writes finish before it cleans up
+    QInstaller::FileWriterPool writerPool;
     try {
         outDir.tryCreate();
 
         CCodecs codecs;
-        if (codecs.Load() != S_OK)
-            throw SevenZipException(QCoreApplication::translate("Lib7z", "Cannot load codecs."));
-
-        COpenOptions op;
-        op.codecs = &codecs;
-
-        CObjectVector<COpenType> types;
-        op.types = &types;  // Empty, because we use a stream.
-
-        CIntVector excluded;
-        excluded.Add(codecs.FindFormatForExtension(
-            QString2UString(QLatin1String("xz")))); // handled by libarchive
-        op.excludedFormats = &excluded;
-
-        const CMyComPtr<IInStream> stream = new QIODeviceInStream(archive);
-        op.stream = stream; // CMyComPtr is needed, otherwise it crashes in OpenStream().
-
-        CObjectVector<CProperty> properties;
-        op.props = &properties;
-
+        const CMyComPtr<IInStream> stream = new QIODeviceInStream(archive, verifier);
         CArchiveLink archiveLink;
-        if (archiveLink.Open2(op, nullptr) != S_OK) {
-            throw SevenZipException(QCoreApplication::translate("Lib7z",
-                "Cannot open archive \"%1\".").arg(archive->fileName()));
-        }
+        openArchiveLink(archive, &codecs, stream, &archiveLink);
 
         callback->setTarget(directory);
-        for (unsigned a = 0; a < archiveLink.Arcs.Size(); ++a) {
-            callback->setArchive(&archiveLink.Arcs[a]);
-            IInArchive *const arch = archiveLink.Arcs[a].Archive;
-
-            const LONG result = arch->Extract(0, static_cast<UInt32>(-1), false, callback);
-            if (result != S_OK)
-                throw SevenZipException(errorMessageFrom7zResult(result));
+        callback->writerPool = &writerPool;
+        callback->verifier = verifier;
+        // nested archives hold their items in the innermost one
+        CArc &innermost = archiveLink.Arcs[archiveLink.Arcs.Size() - 1];
+        const QVector<UInt32> items = selectItems(innermost, entries);
+        if (threadCount == 1 || !ParallelExtractCallback::extract(archive, directory, callback,
+                &archiveLink, items, threadCount)) {
+            if (entries.isEmpty()) {
+                for (unsigned a = 0; a < archiveLink.Arcs.Size(); ++a) {
+                    callback->setArchive(&archiveLink.Arcs[a]);
+                    IInArchive *const arch = archiveLink.Arcs[a].Archive;
+
+                    const LONG result = arch->Extract(0, static_cast<UInt32>(-1), false,
+                        callback);
+                    if (result != S_OK)
+                        throw SevenZipException(errorMessageFrom7zResult(result));
+                }
+            } else {
+                callback->setArchive(&innermost);
+                const LONG result = innermost.Archive->Extract(items.constData(),
+                    static_cast<UInt32>(items.size()), false, callback);
+                if (result != S_OK)
+                    throw SevenZipException(errorMessageFrom7zResult(result));
+            }
         }
+        if (!writerPool.waitForDone())
+            throw SevenZipException(writerPool.errorString());
+        callback->writerPool = nullptr;
+        callback->verifier = nullptr;
+        if (verifier && !verifier->verify(archive))
+            throw SevenZipException(verifier->errorString());
     } catch (const SevenZipException &e) {
+        writerPool.waitForDone();
+        callback->writerPool = nullptr;
+        callback->verifier = nullptr;
         externCallback.Detach();
         throw e; // re-throw unmodified
     } catch (...) {
+        writerPool.waitForDone();
+        callback->writerPool = nullptr;
+        callback->verifier = nullptr;
         externCallback.Detach();
         throw SevenZipException(QCoreApplication::translate("Lib7z",
             "Unknown exception caught (%1).").arg(QString::fromLatin1(Q_FUNC_INFO)));
@@ -28,13 +28,13 @@
 
 #include "lib7zarchive.h"
 
+#include "checksumverifier.h"
 #include "errors.h"
+#include "fileutils.h"
 #include "lib7z_facade.h"
 #include "lib7z_create.h"
 #include "lib7z_list.h"
 
-#include <QCoreApplication>
-
 namespace QInstaller {
 
 /*!
@@ -123,38 +123,47 @@ void Lib7zArchive::setFilename(const QString &filename)
 */
 bool Lib7zArchive::extract(const QString &dirPath)
 {
-    m_extractCallback->setState(S_OK);
-    try {
-        Lib7z::extractArchive(&m_file, dirPath, m_extractCallback);
-    } catch (const Lib7z::SevenZipException &e) {
-        setErrorString(e.message());
-        return false;
-    }
-    return true;
+    return extract(dirPath, QStringList());
 }
 
 /*!
     \reimp
 
-    Extracts the contents of this archive to \a dirPath. The \a totalFiles
-    parameter is unused. Returns \c true on success; \c false otherwise.
+    Extracts the \a entries of this archive to \a dirPath, or all of it if \a entries is
+    empty. Archives created without solid compression decode only the blocks of the
+    selected entries. Returns \c true on success; \c false otherwise.
 */
-bool Lib7zArchive::extract(const QString &dirPath, const quint64 totalFiles)
+bool Lib7zArchive::extract(const QString &dirPath, const QStringList &entries)
 {
-    Q_UNUSED(totalFiles)
-    return extract(dirPath);
+    m_extractCallback->setState(S_OK);
+    m_extractCallback->setBackupExistingFiles(backupExistingFiles());
+    m_extractCallback->notifier()->reset();
+    QScopedPointer<ChecksumVerifier> verifier;
+    if (!expectedChecksum().isEmpty())
+        verifier.reset(new ChecksumVerifier(expectedChecksum()));
+    try {
+        Lib7z::extractArchive(&m_file, dirPath, m_extractCallback, 0, verifier.data(), entries);
+    } catch (const Lib7z::SevenZipException &e) {
+        m_extractCallback->notifier()->flush();
+        setErrorString(e.message());
+        return false;
+    }
+    m_extractCallback->notifier()->flush();
+    return true;
 }
 
 /*!
     \reimp
 
-    Packages the given \a data into the archive and creates the file on disk.
+    Packages the given \a data into the archive and creates the file on disk. The
+    checksums set with setCreatedChecksumAlgorithms() are calculated while writing.
 */
 bool Lib7zArchive::create(const QStringList &data)
 {
     try {
         // No support for callback yet.
-        Lib7z::createArchive(&m_file, data, compressionLevel());
+        Lib7z::createArchive(&m_file, data, compressionLevel(), 0, compressionThreads(),
+            solidBlockSize(), createdChecksumHashes());
     } catch (const Lib7z::SevenZipException &e) {
         setErrorString(e.message());
         return false;
@@ -209,34 +218,63 @@ void Lib7zArchive::cancel()
 */
 void Lib7zArchive::listenExtractCallback()
 {
-    connect(m_extractCallback, &ExtractCallbackWrapper::currentEntryChanged,
-            this, &Lib7zArchive::currentEntryChanged);
-    connect(m_extractCallback, &ExtractCallbackWrapper::completedChanged,
-            this, &Lib7zArchive::completedChanged);
+    // parallel extraction notifies from pool threads, forward without a detour
+    // through the event loop of the calling thread
+    connect(m_extractCallback->notifier(), &ExtractNotifier::entriesExtracted,
+            this, &Lib7zArchive::entriesExtracted, Qt::DirectConnection);
+    connect(m_extractCallback->notifier(), &ExtractNotifier::completedChanged,
+            this, &Lib7zArchive::completedChanged, Qt::DirectConnection);
+    connect(m_extractCallback, &ExtractCallbackWrapper::fileBackedUp,
+            this, &Lib7zArchive::fileBackedUp, Qt::DirectConnection);
 }
 
 
 Lib7zArchive::ExtractCallbackWrapper::ExtractCallbackWrapper()
     : m_state(S_OK)
+    , m_backupExistingFiles(false)
 {
 }
 
 void Lib7zArchive::ExtractCallbackWrapper::setState(HRESULT state)
 {
-    m_state = state;
+    m_state.storeRelease(state);
+}
+
+void Lib7zArchive::ExtractCallbackWrapper::setBackupExistingFiles(bool backup)
+{
+    m_backupExistingFiles = backup;
+}
+
+ExtractNotifier *Lib7zArchive::ExtractCallbackWrapper::notifier()
+{
+    return &m_notifier;
+}
+
+bool Lib7zArchive::ExtractCallbackWrapper::prepareForFile(const QString &filename)
+{
+    if (!m_backupExistingFiles)
+        return true;
+
+    try {
+        const QString backup = backupFile(filename);
+        if (!backup.isEmpty())
+            emit fileBackedUp(filename, backup);
+    } catch (const Error &e) {
+        qCritical("%s", qPrintable(e.message()));
+        return false;
+    }
+    return true;
 }
 
 void Lib7zArchive::ExtractCallbackWrapper::setCurrentFile(const QString &filename)
 {
-    emit currentEntryChanged(filename);
+    m_notifier.addEntry(filename);
 }
 
 HRESULT Lib7zArchive::ExtractCallbackWrapper::setCompleted(quint64 completed, quint64 total)
 {
-    qApp->processEvents();
-
-    emit completedChanged(completed, total);
-    return m_state;
+    m_notifier.setCompleted(completed, total);
+    return m_state.loadAcquire();
 }
 
 } // namespace QInstaller
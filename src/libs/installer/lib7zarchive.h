@@ -50,7 +50,7 @@ public:
     void setFilename(const QString &filename) Q_DECL_OVERRIDE;
 
     bool extract(const QString &dirPath) Q_DECL_OVERRIDE;
-    bool extract(const QString &dirPath, const quint64 totalFiles) Q_DECL_OVERRIDE;
+    bool extract(const QString &dirPath, const QStringList &entries) Q_DECL_OVERRIDE;
     bool create(const QStringList &data) Q_DECL_OVERRIDE;
     QVector<ArchiveEntry> list() Q_DECL_OVERRIDE;
     bool isSupported() Q_DECL_OVERRIDE;
@@ -77,17 +77,21 @@ public:
     ExtractCallbackWrapper();
 
     void setState(HRESULT state);
+    void setBackupExistingFiles(bool backup);
+    ExtractNotifier *notifier();
 
 Q_SIGNALS:
-    void currentEntryChanged(const QString &filename);
-    void completedChanged(quint64 completed, quint64 total);
+    void fileBackedUp(const QString &filename, const QString &backupFilename);
 
 private:
+    bool prepareForFile(const QString &filename) Q_DECL_OVERRIDE;
     void setCurrentFile(const QString &filename) Q_DECL_OVERRIDE;
     HRESULT setCompleted(quint64 completed, quint64 total) Q_DECL_OVERRIDE;
 
 private:
-    HRESULT m_state;
+    QAtomicInt m_state;
+    bool m_backupExistingFiles;
+    ExtractNotifier m_notifier;
 };
 
 } // namespace QInstaller
@@ -28,15 +28,21 @@
 
 #include "libarchivearchive.h"
 
+#include "checksumverifier.h"
 #include "directoryguard.h"
 #include "errors.h"
+#include "fileio.h"
+#include "fileutils.h"
+#include "filewriterpool.h"
 #include "globals.h"
 
-#include <QApplication>
+#include <QEventLoop>
 #include <QFileInfo>
 #include <QDir>
 #include <QTimer>
 
+#include <cerrno>
+
 namespace QInstaller {
 
 /*!
@@ -57,27 +63,131 @@ namespace QInstaller {
     \internal
 */
 
+/*
+    Returns \c true if \a entry is a small regular file without any attributes that
+    only the libarchive disk writer can restore, so it can be written by a FileWriterPool.
+*/
+static bool isPoolWritable(archive_entry *entry)
+{
+    unsigned long fflagsSet = 0;
+    unsigned long fflagsClear = 0;
+    archive_entry_fflags(entry, &fflagsSet, &fflagsClear);
+
+    return archive_entry_filetype(entry) == AE_IFREG
+        && archive_entry_size_is_set(entry)
+        && FileWriterPool::isBufferedSize(quint64(archive_entry_size(entry)))
+        && !archive_entry_hardlink(entry)
+        && (archive_entry_perm(entry) & 07000) == 0 // setuid, setgid, sticky
+        && archive_entry_sparse_count(entry) == 0
+        && archive_entry_acl_count(entry, ARCHIVE_ENTRY_ACL_TYPE_POSIX1E
+            | ARCHIVE_ENTRY_ACL_TYPE_NFS4) == 0
+        && archive_entry_xattr_count(entry) == 0
+        && fflagsSet == 0 && fflagsClear == 0;
+}
+
+static QDateTime entryTime(time_t seconds, long nanoseconds)
+{
+    return QDateTime::fromMSecsSinceEpoch(qint64(seconds) * 1000 + nanoseconds / 1000000, Qt::UTC);
+}
+
+/*
+    Creates the parent directory of \a path unless \a cache knows it exists, and adds
+    the created directories to \a notifier. Throws an Error on failure.
+*/
+static void createParentDirectory(const QString &path, DirectoryCache *cache,
+    ExtractNotifier *notifier)
+{
+    DirectoryGuard guard(QFileInfo(path).absolutePath(), cache);
+    foreach (const QString &directory, guard.tryCreate())
+        notifier->addEntry(directory);
+    guard.release();
+}
+
+/*
+    Returns \c true if \a path is one of \a entries or inside one of them, or if \a entries
+    is empty. Matched entries are removed from \a missing.
+*/
+static bool isSelectedEntry(const QString &path, const QStringList &entries, QStringList *missing)
+{
+    if (entries.isEmpty())
+        return true;
+    const QString cleanPath = QDir::cleanPath(path);
+    foreach (const QString &entry, entries) {
+        if (cleanPath == entry || cleanPath.startsWith(entry + QLatin1Char('/'))) {
+            missing->removeAll(entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Reads the data of \a entry from \a reader and queues it for writing to \a writers.
+    Throws an Error on failure.
+*/
+static void writeToPool(archive *reader, archive_entry *entry, FileWriterPool *writers)
+{
+    FileWriterPool::Entry poolEntry;
+    poolEntry.path = QString::fromLocal8Bit(archive_entry_pathname(entry));
+    poolEntry.data.resize(int(archive_entry_size(entry)));
+    int bytesRead = 0;
+    while (bytesRead < poolEntry.data.size()) {
+        const la_ssize_t result = archive_read_data(reader, poolEntry.data.data() + bytesRead,
+            size_t(poolEntry.data.size() - bytesRead));
+        if (result < 0)
+            throw Error(QLatin1String(archive_error_string(reader)));
+        if (result == 0)
+            break;
+        bytesRead += int(result);
+    }
+    poolEntry.data.resize(bytesRead);
+
+    if (archive_entry_mtime_is_set(entry))
+        poolEntry.lastModified = entryTime(archive_entry_mtime(entry), archive_entry_mtime_nsec(entry));
+    if (archive_entry_atime_is_set(entry))
+        poolEntry.lastRead = entryTime(archive_entry_atime(entry), archive_entry_atime_nsec(entry));
+    if (archive_entry_birthtime_is_set(entry)) {
+        poolEntry.birthTime = entryTime(archive_entry_birthtime(entry),
+            archive_entry_birthtime_nsec(entry));
+    }
+
+    const int mode = archive_entry_perm(entry);
+    poolEntry.permissions = static_cast<QFile::Permissions>((mode & 0700) << 2)  // owner rights
+        | static_cast<QFile::Permissions>((mode & 0070) << 1)  // group
+        | static_cast<QFile::Permissions>(mode & 0007);  // and world rights
+    poolEntry.hasPermissions = true;
+
+    if (!writers->write(poolEntry))
+        throw Error(writers->errorString());
+}
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::ExtractWorker
     \internal
 */
 
+ExtractWorker::ExtractWorker()
+    : m_notifier(this) // moved to the worker thread together with the worker
+{
+    connect(&m_notifier, &ExtractNotifier::entriesExtracted, this, &ExtractWorker::entriesExtracted);
+    connect(&m_notifier, &ExtractNotifier::completedChanged, this, &ExtractWorker::completedChanged);
+}
+
 ExtractWorker::Status ExtractWorker::status() const
 {
     return m_status;
 }
 
-void ExtractWorker::extract(const QString &dirPath, const quint64 totalFiles)
+void ExtractWorker::setBackupExistingFiles(bool backup)
 {
-    m_status = Unfinished;
-    quint64 completed = 0;
+    m_backupExistingFiles = backup;
+}
 
-    if (!totalFiles) {
-        m_status = Failure;
-        emit finished(QLatin1String("The file count for current archive is null!"));
-        return;
-    }
+void ExtractWorker::extract(const QString &dirPath, const quint64 totalBytes)
+{
+    m_status = Unfinished;
+    m_notifier.reset();
 
     QScopedPointer<archive, ScopedPointerReaderDeleter> reader(archive_read_new());
     QScopedPointer<archive, ScopedPointerWriterDeleter> writer(archive_write_disk_new());
@@ -87,21 +197,27 @@ void ExtractWorker::extract(const QString &dirPath, const quint64 totalFiles)
     LibArchiveArchive::configureDiskWriter(writer.get());
 
     DirectoryGuard targetDir(QFileInfo(dirPath).absolutePath());
+    // destroyed first, so pending writes finish before the guard and the disk writer clean up
+    FileWriterPool writers;
+    // directories created or seen by this extraction, checked on disk only once
+    DirectoryCache directories;
     try {
         const QStringList createdDirs = targetDir.tryCreate();
         // Make sure that all leading directories created get removed as well
         foreach (const QString &directory, createdDirs)
-            emit currentEntryChanged(directory);
+            m_notifier.addEntry(directory);
 
         int status = archive_read_open(reader.get(), this, nullptr, readCallback, nullptr);
         if (status != ARCHIVE_OK) {
             m_status = Failure;
+            m_notifier.flush();
             emit finished(QLatin1String(archive_error_string(reader.get())));
             return;
         }
 
         forever {
             if (m_status == Canceled) {
+                m_notifier.flush();
                 emit finished(QLatin1String("Extract canceled."));
                 return;
             }
@@ -110,6 +226,7 @@ void ExtractWorker::extract(const QString &dirPath, const quint64 totalFiles)
                 break;
             if (status != ARCHIVE_OK) {
                 m_status = Failure;
+                m_notifier.flush();
                 emit finished(QLatin1String(archive_error_string(reader.get())));
                 return;
             }
@@ -117,22 +234,45 @@ void ExtractWorker::extract(const QString &dirPath, const quint64 totalFiles)
             const QString outputPath = dirPath + QDir::separator() + QString::fromLocal8Bit(current);
             archive_entry_set_pathname(entry, outputPath.toLocal8Bit());
 
-            emit currentEntryChanged(outputPath);
-            if (!writeEntry(reader.get(), writer.get(), entry))
-                return;
+            // an earlier entry with the same path might still be written
+            writers.waitForPath(outputPath);
+            if (m_backupExistingFiles && archive_entry_filetype(entry) != AE_IFDIR) {
+                const QString backup = backupFile(outputPath);
+                if (!backup.isEmpty())
+                    emit fileBackedUp(outputPath, backup);
+            }
 
-            ++completed;
-            emit completedChanged(completed, totalFiles);
+            m_notifier.addEntry(outputPath);
+            if (isPoolWritable(entry)) {
+                // create the parent here, instead of once per file in the writer threads
+                createParentDirectory(outputPath, &directories, &m_notifier);
+                writeToPool(reader.get(), entry, &writers);
+            } else {
+                // links might refer to files still being written
+                if (archive_entry_hardlink(entry) || archive_entry_filetype(entry) == AE_IFLNK)
+                    writers.waitForDone();
+                if (!writeEntry(reader.get(), writer.get(), entry)) {
+                    m_notifier.flush();
+                    return;
+                }
+                if (archive_entry_filetype(entry) == AE_IFDIR)
+                    directories.insert(QFileInfo(QDir::cleanPath(outputPath)).absoluteFilePath());
+            }
 
-            qApp->processEvents();
+            // progress by compressed bytes consumed, so no listing pass is needed
+            m_notifier.setCompleted(quint64(archive_filter_bytes(reader.get(), -1)), totalBytes);
         }
+        if (!writers.waitForDone())
+            throw Error(writers.errorString());
     } catch (const Error &e) {
         m_status = Failure;
+        m_notifier.flush();
         emit finished(e.message());
         return;
     }
     targetDir.release();
     m_status = Success;
+    m_notifier.flush();
     emit finished();
 }
 
@@ -226,6 +366,9 @@ bool ExtractWorker::writeEntry(archive *reader, archive *writer, archive_entry *
     \class QInstaller::LibArchiveArchive::ArchiveData
     \brief Bundles a file device and associated read buffer for access
            as client data in libarchive callbacks.
+
+    If a checksum verifier is set, it is passed all data read from the file.
+
 */
 
 /*!
@@ -241,10 +384,10 @@ bool ExtractWorker::writeEntry(archive *reader, archive *writer, archive_entry *
 */
 
 /*!
-    \fn QInstaller::LibArchiveArchive::workerAboutToExtract(const QString &dirPath, const quint64 totalFiles)
+    \fn QInstaller::LibArchiveArchive::workerAboutToExtract(const QString &dirPath, const quint64 totalBytes)
 
-    Emitted when the worker object is about to extract \a totalFiles
-    from an archive to \a dirPath.
+    Emitted when the worker object is about to extract an archive of
+    \a totalBytes size to \a dirPath.
 */
 
 /*!
@@ -273,7 +416,7 @@ bool ExtractWorker::writeEntry(archive *reader, archive *writer, archive_entry *
 LibArchiveArchive::LibArchiveArchive(const QString &filename, QObject *parent)
     : AbstractArchive(parent)
     , m_data(new ArchiveData())
-    , m_cancelScheduled(false)
+    , m_cancelScheduled(0)
 {
     LibArchiveArchive::setFilename(filename);
     initExtractWorker();
@@ -285,7 +428,7 @@ LibArchiveArchive::LibArchiveArchive(const QString &filename, QObject *parent)
 LibArchiveArchive::LibArchiveArchive(QObject *parent)
     : AbstractArchive(parent)
     , m_data(new ArchiveData())
-    , m_cancelScheduled(false)
+    , m_cancelScheduled(0)
 {
     initExtractWorker();
 }
@@ -339,29 +482,32 @@ void LibArchiveArchive::setFilename(const QString &filename)
 /*!
     \reimp
 
-    Extracts the contents of this archive to \a dirPath.
+    Extracts the contents of this archive to \a dirPath in a single pass. The progress
+    is reported in compressed bytes read from the archive file.
     Returns \c true on success; \c false otherwise.
 */
 bool LibArchiveArchive::extract(const QString &dirPath)
 {
-    return extract(dirPath, totalFiles());
+    return extract(dirPath, QStringList());
 }
 
 /*!
     \reimp
 
-    Extracts the contents of this archive to \a dirPath with
-    precalculated count of \a totalFiles. Returns \c true on
-    success; \c false otherwise.
+    Extracts the \a entries of this archive to \a dirPath. The data of all other
+    entries is skipped without being written. Returns \c true on success;
+    \c false otherwise.
 */
-bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles)
+bool LibArchiveArchive::extract(const QString &dirPath, const QStringList &entries)
 {
-    m_cancelScheduled = false;
-    quint64 completed = 0;
-    if (!totalFiles) {
-        setErrorString(QLatin1String("The file count for current archive is null!"));
-        return false;
-    }
+    QStringList wanted;
+    foreach (const QString &entry, entries)
+        wanted.append(QDir::cleanPath(QDir::fromNativeSeparators(entry)));
+    QStringList missing = wanted;
+
+    m_cancelScheduled.storeRelease(0);
+    m_notifier.reset();
+    const quint64 totalBytes = quint64(qMax(Q_INT64_C(0), m_data->file.size()));
 
     QScopedPointer<archive, ScopedPointerReaderDeleter> reader(archive_read_new());
     QScopedPointer<archive, ScopedPointerWriterDeleter> writer(archive_write_disk_new());
@@ -370,19 +516,31 @@ bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles
     configureReader(reader.get());
     configureDiskWriter(writer.get());
 
+    // the checksum is calculated from the data read for decoding
+    QScopedPointer<ChecksumVerifier> verifier;
+    if (!expectedChecksum().isEmpty()) {
+        verifier.reset(new ChecksumVerifier(expectedChecksum()));
+        m_data->file.seek(0);
+    }
+    m_data->verifier = verifier.data();
+
     DirectoryGuard targetDir(QFileInfo(dirPath).absolutePath());
+    // destroyed first, so pending writes finish before the guard and the disk writer clean up
+    FileWriterPool writers;
+    // directories created or seen by this extraction, checked on disk only once
+    DirectoryCache directories;
     try {
         const QStringList createdDirs = targetDir.tryCreate();
         // Make sure that all leading directories created get removed as well
         foreach (const QString &directory, createdDirs)
-            emit currentEntryChanged(directory);
+            m_notifier.addEntry(directory);
 
         int status = archive_read_open(reader.get(), m_data, nullptr, readCallback, nullptr);
         if (status != ARCHIVE_OK)
             throw Error(QLatin1String(archive_error_string(reader.get())));
 
         forever {
-            if (m_cancelScheduled)
+            if (m_cancelScheduled.loadAcquire())
                 throw Error(QLatin1String("Extract canceled."));
 
             status = archive_read_next_header(reader.get(), &entry);
@@ -392,23 +550,55 @@ bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles
                 throw Error(QLatin1String(archive_error_string(reader.get())));
 
             const char *current = archive_entry_pathname(entry);
+            if (!isSelectedEntry(QString::fromLocal8Bit(current), wanted, &missing)) {
+                if (archive_read_data_skip(reader.get()) != ARCHIVE_OK)
+                    throw Error(QLatin1String(archive_error_string(reader.get())));
+                m_notifier.setCompleted(quint64(archive_filter_bytes(reader.get(), -1)), totalBytes);
+                continue;
+            }
             const QString outputPath = dirPath + QDir::separator() + QString::fromLocal8Bit(current);
             archive_entry_set_pathname(entry, outputPath.toLocal8Bit());
 
-            emit currentEntryChanged(outputPath);
-            if (!writeEntry(reader.get(), writer.get(), entry))
-                throw Error(errorString()); // appropriate error string set in writeEntry()
+            // an earlier entry with the same path might still be written
+            writers.waitForPath(outputPath);
+            if (backupExistingFiles() && archive_entry_filetype(entry) != AE_IFDIR) {
+                const QString backup = backupFile(outputPath);
+                if (!backup.isEmpty())
+                    emit fileBackedUp(outputPath, backup);
+            }
 
-            ++completed;
-            emit completedChanged(completed, totalFiles);
+            m_notifier.addEntry(outputPath);
+            if (isPoolWritable(entry)) {
+                // create the parent here, instead of once per file in the writer threads
+                createParentDirectory(outputPath, &directories, &m_notifier);
+                writeToPool(reader.get(), entry, &writers);
+            } else {
+                // links might refer to files still being written
+                if (archive_entry_hardlink(entry) || archive_entry_filetype(entry) == AE_IFLNK)
+                    writers.waitForDone();
+                if (!writeEntry(reader.get(), writer.get(), entry))
+                    throw Error(errorString()); // appropriate error string set in writeEntry()
+                if (archive_entry_filetype(entry) == AE_IFDIR)
+                    directories.insert(QFileInfo(QDir::cleanPath(outputPath)).absoluteFilePath());
+            }
 
-            qApp->processEvents();
+            m_notifier.setCompleted(quint64(archive_filter_bytes(reader.get(), -1)), totalBytes);
         }
+        if (!writers.waitForDone())
+            throw Error(writers.errorString());
+        if (!missing.isEmpty())
+            throw Error(tr("Cannot find \"%1\" in archive.").arg(missing.first()));
+        m_data->verifier = nullptr;
+        if (verifier && !verifier->verify(&m_data->file))
+            throw Error(verifier->errorString());
     } catch (const Error &e) {
+        m_data->verifier = nullptr;
+        m_notifier.flush();
         setErrorString(e.message());
         m_data->file.seek(0);
         return false;
     }
+    m_notifier.flush();
     targetDir.release();
     m_data->file.seek(0);
     return true;
@@ -417,16 +607,24 @@ bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles
 /*!
     \reimp
 
-    Packages the given \a data into the archive and creates the file on disk.
+    Packages the given \a data into the archive and creates the file on disk. The
+    checksums set with setCreatedChecksumAlgorithms() are calculated while writing.
 */
 bool LibArchiveArchive::create(const QStringList &data)
 {
     QScopedPointer<archive, ScopedPointerWriterDeleter> writer(archive_write_new());
     configureWriter(writer.get());
+    // like archive_write_open_filename(), do not pad the last block of a regular file
+    archive_write_set_bytes_in_last_block(writer.get(), 1);
 
+    const bool wasOpen = m_data->file.isOpen();
     try {
+        if (!wasOpen)
+            openForWrite(&m_data->file);
+        m_data->hashes = createdChecksumHashes();
+
         int status;
-        if ((status = archive_write_open_filename(writer.get(), m_data->file.fileName().toLocal8Bit())))
+        if ((status = archive_write_open(writer.get(), m_data, nullptr, writeCallback, nullptr)))
             throw Error(QLatin1String(archive_error_string(writer.get())));
 
         for (auto &dataEntry : data) {
@@ -474,10 +672,21 @@ bool LibArchiveArchive::create(const QStringList &data)
                 file.close();
             }
         }
+        // flush the remaining data before the checksums are taken
+        if (archive_write_close(writer.get()) != ARCHIVE_OK)
+            throw Error(QLatin1String(archive_error_string(writer.get())));
     } catch (const Error &e) {
+        m_data->hashes.clear();
+        if (!wasOpen)
+            m_data->file.close();
         setErrorString(e.message());
         return false;
     }
+    m_data->hashes.clear();
+    if (!wasOpen)
+        m_data->file.close();
+    else
+        m_data->file.seek(0); // the archive can be read right away, as with list()
     return true;
 }
 
@@ -550,12 +759,13 @@ bool LibArchiveArchive::isSupported()
 }
 
 /*!
-    Requests to extract the archive to \a dirPath with \a totalFiles
+    Requests to extract the archive of \a totalBytes size to \a dirPath
     in a separate thread with a worker object.
 */
-void LibArchiveArchive::workerExtract(const QString &dirPath, const quint64 totalFiles)
+void LibArchiveArchive::workerExtract(const QString &dirPath, const quint64 totalBytes)
 {
-    emit workerAboutToExtract(dirPath, totalFiles);
+    m_worker.setBackupExistingFiles(backupExistingFiles());
+    emit workerAboutToExtract(dirPath, totalBytes);
 }
 
 /*!
@@ -597,7 +807,7 @@ ExtractWorker::Status LibArchiveArchive::workerStatus() const
 */
 void LibArchiveArchive::cancel()
 {
-    m_cancelScheduled = true;
+    m_cancelScheduled.storeRelease(1);
 }
 
 /*!
@@ -617,6 +827,7 @@ void LibArchiveArchive::configureReader(archive *archive)
     archive_read_support_filter_bzip2(archive);
     archive_read_support_filter_gzip(archive);
     archive_read_support_filter_xz(archive);
+    archive_read_support_filter_zstd(archive);
 
     archive_read_support_format_tar(archive);
     archive_read_support_format_zip(archive);
@@ -638,6 +849,22 @@ void LibArchiveArchive::configureWriter(archive *archive)
         qCWarning(QInstaller::lcInstallerInstallLog) << "Could not set options" << options
             << "for archive" << m_data->file.fileName() << ":" << archive_error_string(archive);
     }
+    // only some filters (e.g. xz) compress in parallel, others reject the option
+    if (compressionThreads() > 0) {
+        const QByteArray threads = "threads=" + QByteArray::number(compressionThreads());
+        if (archive_write_set_options(archive, threads.constData())) { // not fatal
+            qCDebug(QInstaller::lcInstallerInstallLog) << "Could not set options" << threads
+                << "for archive" << m_data->file.fileName() << ":" << archive_error_string(archive);
+        }
+    }
+    // long distance matching finds repetitions across files in large payloads
+    if (m_data->file.fileName().endsWith(QLatin1String(".tar.zst"), Qt::CaseInsensitive)
+            && compressionLevel() >= CompressionLevel::Normal) {
+        if (archive_write_set_options(archive, "zstd:long")) { // not fatal
+            qCWarning(QInstaller::lcInstallerInstallLog) << "Could not enable long distance matching"
+                << "for archive" << m_data->file.fileName() << ":" << archive_error_string(archive);
+        }
+    }
 }
 
 /*!
@@ -667,6 +894,9 @@ void LibArchiveArchive::configureDiskWriter(archive *archive)
 */
 void LibArchiveArchive::initExtractWorker()
 {
+    connect(&m_notifier, &ExtractNotifier::entriesExtracted, this, &LibArchiveArchive::entriesExtracted);
+    connect(&m_notifier, &ExtractNotifier::completedChanged, this, &LibArchiveArchive::completedChanged);
+
     m_worker.moveToThread(&m_workerThread);
 
     connect(this, &LibArchiveArchive::workerAboutToExtract, &m_worker, &ExtractWorker::extract);
@@ -677,8 +907,9 @@ void LibArchiveArchive::initExtractWorker()
     connect(&m_worker, &ExtractWorker::dataBlockRequested, this, &LibArchiveArchive::dataBlockRequested);
     connect(&m_worker, &ExtractWorker::finished, this, &LibArchiveArchive::onWorkerFinished);
 
-    connect(&m_worker, &ExtractWorker::currentEntryChanged, this, &LibArchiveArchive::currentEntryChanged);
+    connect(&m_worker, &ExtractWorker::entriesExtracted, this, &LibArchiveArchive::entriesExtracted);
     connect(&m_worker, &ExtractWorker::completedChanged, this, &LibArchiveArchive::completedChanged);
+    connect(&m_worker, &ExtractWorker::fileBackedUp, this, &LibArchiveArchive::fileBackedUp);
 
     m_workerThread.start();
 }
@@ -763,7 +994,35 @@ ssize_t LibArchiveArchive::readCallback(archive *reader, void *archiveData, cons
 
     // Doesn't matter if the buffer size exceeds the actual data read,
     // the return value indicates the length of relevant bytes.
-    return readData(&data->file, data->buffer.data(), data->buffer.size());
+    const qint64 offset = data->file.pos();
+    const qint64 bytesRead = readData(&data->file, data->buffer.data(), data->buffer.size());
+    if (data->verifier && bytesRead > 0)
+        data->verifier->addData(offset, data->buffer.constData(), bytesRead);
+    return bytesRead;
+}
+
+/*!
+    \internal
+
+    Called by libarchive when archive data was written. Writes \a length bytes from
+    \a buff to the file device in \a archiveData and passes them to the hashes of the
+    created checksums. Returns the number of bytes written.
+*/
+ssize_t LibArchiveArchive::writeCallback(archive *writer, void *archiveData, const void *buff,
+    size_t length)
+{
+    ArchiveData *data;
+    if (!(data = static_cast<ArchiveData *>(archiveData)))
+        return ARCHIVE_FATAL;
+
+    const char *const bytes = static_cast<const char *>(buff);
+    if (data->file.write(bytes, qint64(length)) != qint64(length)) {
+        archive_set_error(writer, EIO, "%s", qPrintable(data->file.errorString()));
+        return ARCHIVE_FATAL;
+    }
+    foreach (QCryptographicHash *hash, data->hashes)
+        hash->addData(bytes, int(length));
+    return ssize_t(length);
 }
 
 /*!
@@ -782,38 +1041,4 @@ QString LibArchiveArchive::pathWithoutNamespace(const QString &path)
     return aPath;
 }
 
-/*!
-    Returns the number of files in this archive.
-*/
-quint64 LibArchiveArchive::totalFiles()
-{
-    QScopedPointer<archive, ScopedPointerReaderDeleter> reader(archive_read_new());
-    archive_entry *entry = nullptr;
-    quint64 files = 0;
-
-    configureReader(reader.get());
-
-    try {
-        int status = archive_read_open(reader.get(), m_data, nullptr, readCallback, nullptr);
-        if (status != ARCHIVE_OK)
-            throw Error(QLatin1String(archive_error_string(reader.get())));
-
-        forever {
-            status = archive_read_next_header(reader.get(), &entry);
-            if (status == ARCHIVE_EOF)
-                break;
-            if (status != ARCHIVE_OK)
-                throw Error(QLatin1String(archive_error_string(reader.get())));
-
-            ++files;
-        }
-    } catch (const Error &e) {
-        setErrorString(e.message());
-        m_data->file.seek(0);
-        return 0;
-    }
-    m_data->file.seek(0);
-    return files;
-}
-
 } // namespace QInstaller
@@ -44,6 +44,8 @@ typedef SSIZE_T ssize_t;
 
 namespace QInstaller {
 
+class ChecksumVerifier;
+
 class ExtractWorker : public QObject
 {
     Q_OBJECT
@@ -57,12 +59,13 @@ public:
         Unfinished = 3
     };
 
-    ExtractWorker() = default;
+    ExtractWorker();
 
     Status status() const;
+    void setBackupExistingFiles(bool backup);
 
 public Q_SLOTS:
-    void extract(const QString &dirPath, const quint64 totalFiles);
+    void extract(const QString &dirPath, const quint64 totalBytes);
     void addDataBlock(const QByteArray buffer);
     void cancel();
 
@@ -72,8 +75,9 @@ Q_SIGNALS:
     void dataReadyForRead();
     void finished(const QString &errorString = QString());
 
-    void currentEntryChanged(const QString &filename);
+    void entriesExtracted(const QStringList &filenames);
     void completedChanged(quint64 completed, quint64 total);
+    void fileBackedUp(const QString &filename, const QString &backupFilename);
 
 private:
     static ssize_t readCallback(archive *reader, void *caller, const void **buff);
@@ -82,6 +86,8 @@ private:
 private:
     QByteArray m_buffer;
     Status m_status;
+    bool m_backupExistingFiles = false;
+    ExtractNotifier m_notifier;
 };
 
 class INSTALLER_EXPORT LibArchiveArchive : public AbstractArchive
@@ -99,12 +105,12 @@ public:
     void setFilename(const QString &filename) Q_DECL_OVERRIDE;
 
     bool extract(const QString &dirPath) Q_DECL_OVERRIDE;
-    bool extract(const QString &dirPath, const quint64 totalFiles) Q_DECL_OVERRIDE;
+    bool extract(const QString &dirPath, const QStringList &entries) Q_DECL_OVERRIDE;
     bool create(const QStringList &data) Q_DECL_OVERRIDE;
     QVector<ArchiveEntry> list() Q_DECL_OVERRIDE;
     bool isSupported() Q_DECL_OVERRIDE;
 
-    void workerExtract(const QString &dirPath, const quint64 totalFiles);
+    void workerExtract(const QString &dirPath, const quint64 totalBytes);
     void workerAddDataBlock(const QByteArray buffer);
     void workerSetDataAtEnd();
     void workerCancel();
@@ -114,7 +120,7 @@ Q_SIGNALS:
     void dataBlockRequested();
     void workerFinished();
 
-    void workerAboutToExtract(const QString &dirPath, const quint64 totalFiles);
+    void workerAboutToExtract(const QString &dirPath, const quint64 totalBytes);
     void workerAboutToAddDataBlock(const QByteArray buffer);
     void workerAboutToSetDataAtEnd();
     void workerAboutToCancel();
@@ -137,11 +143,11 @@ private:
 
     static qint64 readData(QFile *file, char *data, qint64 maxSize);
     static ssize_t readCallback(archive *reader, void *archiveData, const void **buff);
+    static ssize_t writeCallback(archive *writer, void *archiveData, const void *buff,
+        size_t length);
 
     static QString pathWithoutNamespace(const QString &path);
 
-    quint64 totalFiles();
-
 private:
     friend class ExtractWorker;
     friend class LibArchiveWrapperPrivate;
@@ -150,14 +156,17 @@ private:
     {
         QFile file;
         QByteArray buffer;
+        ChecksumVerifier *verifier = nullptr;
+        QList<QCryptographicHash *> hashes;
     };
 
 private:
     ArchiveData *m_data;
     ExtractWorker m_worker;
     QThread m_workerThread;
+    ExtractNotifier m_notifier;
 
-    bool m_cancelScheduled;
+    QAtomicInt m_cancelScheduled;
 };
 
 struct ScopedPointerReaderDeleter
@@ -45,9 +45,9 @@ namespace QInstaller {
 */
 
 /*!
-    \fn QInstaller::LibArchiveWrapper::currentEntryChanged(const QString &filename)
+    \fn QInstaller::LibArchiveWrapper::entriesExtracted(const QStringList &filenames)
 
-    Current entry changed to \a filename. Emitted when the entry to process is changed.
+    The entries \a filenames were extracted. Emitted in batches while extracting.
 */
 
 /*!
@@ -65,10 +65,12 @@ LibArchiveWrapper::LibArchiveWrapper(const QString &filename, QObject *parent)
     : AbstractArchive(parent)
     , d(new LibArchiveWrapperPrivate(filename))
 {
-    connect(d, &LibArchiveWrapperPrivate::currentEntryChanged,
-        this, &LibArchiveWrapper::currentEntryChanged);
+    connect(d, &LibArchiveWrapperPrivate::entriesExtracted,
+        this, &LibArchiveWrapper::entriesExtracted);
     connect(d, &LibArchiveWrapperPrivate::completedChanged,
         this, &LibArchiveWrapper::completedChanged);
+    connect(d, &LibArchiveWrapperPrivate::fileBackedUp,
+        this, &LibArchiveWrapper::fileBackedUp);
 }
 
 /*!
@@ -78,10 +80,12 @@ LibArchiveWrapper::LibArchiveWrapper(QObject *parent)
     : AbstractArchive(parent)
     , d(new LibArchiveWrapperPrivate())
 {
-    connect(d, &LibArchiveWrapperPrivate::currentEntryChanged,
-        this, &LibArchiveWrapper::currentEntryChanged);
+    connect(d, &LibArchiveWrapperPrivate::entriesExtracted,
+        this, &LibArchiveWrapper::entriesExtracted);
     connect(d, &LibArchiveWrapperPrivate::completedChanged,
         this, &LibArchiveWrapper::completedChanged);
+    connect(d, &LibArchiveWrapperPrivate::fileBackedUp,
+        this, &LibArchiveWrapper::fileBackedUp);
 }
 
 /*!
@@ -142,16 +146,12 @@ bool LibArchiveWrapper::extract(const QString &dirPath)
 }
 
 /*!
-    Extracts the contents of this archive to \a dirPath with
-    precalculated count of \a totalFiles. Returns \c true
-    on success; \c false otherwise.
-
-    If the remote connection is active, the method is called by the server instead,
-    with the client starting a new event loop waiting for the extraction to finish.
+    Extracts the \a entries of this archive to \a dirPath. Returns \c true
+    on success; \c false otherwise. Not supported with an active remote connection.
 */
-bool LibArchiveWrapper::extract(const QString &dirPath, const quint64 totalFiles)
+bool LibArchiveWrapper::extract(const QString &dirPath, const QStringList &entries)
 {
-    return d->extract(dirPath, totalFiles);
+    return d->extract(dirPath, entries);
 }
 
 /*!
@@ -191,6 +191,60 @@ void LibArchiveWrapper::setCompressionLevel(const CompressionLevel level)
     d->setCompressionLevel(level);
 }
 
+/*!
+    Sets the number of \a threads used to compress new archives.
+*/
+void LibArchiveWrapper::setCompressionThreads(const int threads)
+{
+    d->setCompressionThreads(threads);
+}
+
+/*!
+    Sets the maximum \a size of a solid block in new archives.
+*/
+void LibArchiveWrapper::setSolidBlockSize(const qint64 size)
+{
+    d->setSolidBlockSize(size);
+}
+
+/*!
+    Sets whether existing files are backed up before being overwritten on extraction
+    to \a backup.
+*/
+void LibArchiveWrapper::setBackupExistingFiles(const bool backup)
+{
+    AbstractArchive::setBackupExistingFiles(backup);
+    d->setBackupExistingFiles(backup);
+}
+
+/*!
+    Sets the \a checksum the archive file must match on extraction.
+*/
+void LibArchiveWrapper::setExpectedChecksum(const QByteArray &checksum)
+{
+    AbstractArchive::setExpectedChecksum(checksum);
+    d->setExpectedChecksum(checksum);
+}
+
+/*!
+    Sets the checksum \a algorithms calculated while creating the archive.
+*/
+void LibArchiveWrapper::setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms)
+{
+    AbstractArchive::setCreatedChecksumAlgorithms(algorithms);
+    d->setCreatedChecksumAlgorithms(algorithms);
+}
+
+/*!
+    Returns the checksum calculated with \a algorithm while creating the archive. If the
+    remote connection is active, the archive was written by the server and an empty
+    byte array is returned.
+*/
+QByteArray LibArchiveWrapper::createdChecksum(QCryptographicHash::Algorithm algorithm) const
+{
+    return d->createdChecksum(algorithm);
+}
+
 /*!
     Cancels the extract operation in progress.
 
@@ -52,12 +52,18 @@ public:
     QString errorString() const Q_DECL_OVERRIDE;
 
     bool extract(const QString &dirPath) Q_DECL_OVERRIDE;
-    bool extract(const QString &dirPath, const quint64 totalFiles) Q_DECL_OVERRIDE;
+    bool extract(const QString &dirPath, const QStringList &entries) Q_DECL_OVERRIDE;
     bool create(const QStringList &data) Q_DECL_OVERRIDE;
     QVector<ArchiveEntry> list() Q_DECL_OVERRIDE;
     bool isSupported() Q_DECL_OVERRIDE;
 
     void setCompressionLevel(const AbstractArchive::CompressionLevel level) Q_DECL_OVERRIDE;
+    void setCompressionThreads(const int threads) Q_DECL_OVERRIDE;
+    void setSolidBlockSize(const qint64 size) Q_DECL_OVERRIDE;
+    void setBackupExistingFiles(const bool backup) Q_DECL_OVERRIDE;
+    void setExpectedChecksum(const QByteArray &checksum) Q_DECL_OVERRIDE;
+    void setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms) Q_DECL_OVERRIDE;
+    QByteArray createdChecksum(QCryptographicHash::Algorithm algorithm) const Q_DECL_OVERRIDE;
 
 public Q_SLOTS:
     void cancel() Q_DECL_OVERRIDE;
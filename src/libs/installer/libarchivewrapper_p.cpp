@@ -28,9 +28,11 @@
 
 #include "libarchivewrapper_p.h"
 
+#include "checksumverifier.h"
 #include "globals.h"
 
 #include <QFileInfo>
+#include <QThread>
 
 namespace QInstaller {
 
@@ -119,6 +121,8 @@ void LibArchiveWrapperPrivate::setFilename(const QString &filename)
 */
 QString LibArchiveWrapperPrivate::errorString() const
 {
+    if (!m_clientError.isEmpty())
+        return m_clientError;
     if ((const_cast<LibArchiveWrapperPrivate *>(this))->connectToServer()) {
         m_lock.lockForWrite();
         const QString errorString
@@ -130,27 +134,63 @@ QString LibArchiveWrapperPrivate::errorString() const
 }
 
 /*!
-    Extracts the contents of this archive to \a dirPath with
-    an optional precalculated count of \a totalFiles. Returns \c true
-    on success; \c false otherwise.
+    Extracts the contents of this archive to \a dirPath. The progress is reported
+    in compressed bytes read. Returns \c true on success; \c false otherwise.
 
     If the remote connection is active, the method is called by the server instead,
     with the client starting a new event loop waiting for the extraction to finish.
+    The client sends the archive data, so it verifies the expected checksum itself.
 */
-bool LibArchiveWrapperPrivate::extract(const QString &dirPath, const quint64 totalFiles)
+bool LibArchiveWrapperPrivate::extract(const QString &dirPath)
 {
+    m_clientError.clear();
     if (connectToServer()) {
+        QScopedPointer<ChecksumVerifier> verifier;
+        if (!m_expectedChecksum.isEmpty())
+            verifier.reset(new ChecksumVerifier(m_expectedChecksum));
+        m_verifier = verifier.data();
+
+        // the server reads the archive in blocks from the client, tell it the total size
+        const quint64 totalBytes = quint64(qMax(Q_INT64_C(0), m_archive.m_data->file.size()));
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::AbstractArchiveExtract), dirPath, totalFiles);
+        callRemoteMethod(QLatin1String(Protocol::AbstractArchiveExtract), dirPath, totalBytes);
         m_lock.unlock();
         {
             QEventLoop loop;
             connect(this, &LibArchiveWrapperPrivate::remoteWorkerFinished, &loop, &QEventLoop::quit);
             loop.exec();
         }
-        return (workerStatus() == ExtractWorker::Success);
+        m_verifier = nullptr;
+        if (workerStatus() != ExtractWorker::Success)
+            return false;
+        if (verifier && !verifier->verify(&m_archive.m_data->file)) {
+            m_clientError = verifier->errorString();
+            m_archive.m_data->file.seek(0);
+            return false;
+        }
+        m_archive.m_data->file.seek(0);
+        return true;
+    }
+    return m_archive.extract(dirPath);
+}
+
+/*!
+    Extracts the \a entries of this archive to \a dirPath. Returns \c true on
+    success; \c false otherwise.
+
+    Selecting entries is not supported by the server process, so with an active
+    remote connection the method fails.
+*/
+bool LibArchiveWrapperPrivate::extract(const QString &dirPath, const QStringList &entries)
+{
+    m_clientError.clear();
+    if (entries.isEmpty())
+        return extract(dirPath);
+    if (connectToServer()) {
+        m_clientError = tr("Extracting single entries is not supported for elevated extraction.");
+        return false;
     }
-    return m_archive.extract(dirPath, totalFiles);
+    return m_archive.extract(dirPath, entries);
 }
 
 /*!
@@ -205,6 +245,86 @@ void LibArchiveWrapperPrivate::setCompressionLevel(const AbstractArchive::Compre
     m_archive.setCompressionLevel(level);
 }
 
+/*!
+    Sets the number of \a threads used to compress new archives.
+
+    If the remote connection is active, the method is called by the server instead.
+*/
+void LibArchiveWrapperPrivate::setCompressionThreads(const int threads)
+{
+    if (connectToServer()) {
+        m_lock.lockForWrite();
+        callRemoteMethod(QLatin1String(Protocol::AbstractArchiveSetCompressionThreads),
+            qint32(threads), dummy);
+        m_lock.unlock();
+        return;
+    }
+    m_archive.setCompressionThreads(threads);
+}
+
+/*!
+    Sets the maximum \a size of a solid block in new archives.
+
+    If the remote connection is active, the method is called by the server instead.
+*/
+void LibArchiveWrapperPrivate::setSolidBlockSize(const qint64 size)
+{
+    if (connectToServer()) {
+        m_lock.lockForWrite();
+        callRemoteMethod(QLatin1String(Protocol::AbstractArchiveSetSolidBlockSize), size, dummy);
+        m_lock.unlock();
+        return;
+    }
+    m_archive.setSolidBlockSize(size);
+}
+
+/*!
+    Sets whether existing files are backed up before being overwritten on extraction
+    to \a backup.
+
+    If the remote connection is active, the method is called by the server instead.
+*/
+void LibArchiveWrapperPrivate::setBackupExistingFiles(const bool backup)
+{
+    if (connectToServer()) {
+        m_lock.lockForWrite();
+        callRemoteMethod(QLatin1String(Protocol::AbstractArchiveSetBackupExistingFiles), backup, dummy);
+        m_lock.unlock();
+        return;
+    }
+    m_archive.setBackupExistingFiles(backup);
+}
+
+/*!
+    Sets the \a checksum the archive file must match on extraction. Verified by the
+    client also if the remote connection is active, as the client reads the archive.
+*/
+void LibArchiveWrapperPrivate::setExpectedChecksum(const QByteArray &checksum)
+{
+    m_expectedChecksum = checksum;
+    m_archive.setExpectedChecksum(checksum);
+}
+
+/*!
+    Sets the checksum \a algorithms calculated while creating the archive. The server
+    does not send checksums back, they are only calculated without a remote connection.
+*/
+void LibArchiveWrapperPrivate::setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms)
+{
+    m_archive.setCreatedChecksumAlgorithms(algorithms);
+}
+
+/*!
+    Returns the checksum calculated with \a algorithm while creating the archive, or an
+    empty byte array if the archive was created by the server.
+*/
+QByteArray LibArchiveWrapperPrivate::createdChecksum(QCryptographicHash::Algorithm algorithm) const
+{
+    if (isConnectedToServer())
+        return QByteArray();
+    return m_archive.createdChecksum(algorithm);
+}
+
 /*!
     Cancels the extract operation in progress.
 
@@ -212,6 +332,11 @@ void LibArchiveWrapperPrivate::setCompressionLevel(const AbstractArchive::Compre
 */
 void LibArchiveWrapperPrivate::cancel()
 {
+    if (isConnectedToServer() && QThread::currentThread() != thread()) {
+        // the connection belongs to the extracting thread, which waits in an event loop
+        QMetaObject::invokeMethod(this, "cancel", Qt::QueuedConnection);
+        return;
+    }
     if (connectToServer()) {
         m_lock.lockForWrite();
         callRemoteMethod(QLatin1String(Protocol::AbstractArchiveCancel));
@@ -239,12 +364,15 @@ void LibArchiveWrapperPrivate::processSignals()
     m_lock.unlock();
     while (!receivedSignals.isEmpty()) {
         const QString name = receivedSignals.takeFirst().toString();
-        if (name == QLatin1String(Protocol::AbstractArchiveSignalCurrentEntryChanged)) {
-            emit currentEntryChanged(receivedSignals.takeFirst().toString());
+        if (name == QLatin1String(Protocol::AbstractArchiveSignalEntriesExtracted)) {
+            emit entriesExtracted(receivedSignals.takeFirst().toStringList());
         } else if (name == QLatin1String(Protocol::AbstractArchiveSignalCompletedChanged)) {
             const quint64 completed = receivedSignals.takeFirst().value<quint64>();
             const quint64 total = receivedSignals.takeFirst().value<quint64>();
             emit completedChanged(completed, total);
+        } else if (name == QLatin1String(Protocol::AbstractArchiveSignalFileBackedUp)) {
+            const QString filename = receivedSignals.takeFirst().toString();
+            emit fileBackedUp(filename, receivedSignals.takeFirst().toString());
         } else if (name == QLatin1String(Protocol::AbstractArchiveSignalDataBlockRequested)) {
             emit dataBlockRequested();
         } else if (name == QLatin1String(Protocol::AbstractArchiveSignalWorkerFinished)) {
@@ -278,12 +406,15 @@ void LibArchiveWrapperPrivate::onDataBlockRequested()
     if (buff->size() != blockSize)
         buff->resize(blockSize);
 
+    const qint64 offset = file->pos();
     const qint64 bytesRead = file->read(buff->data(), blockSize);
     if (bytesRead == -1) {
         qCWarning(QInstaller::lcInstallerInstallLog) << file->errorString();
         setClientDataAtEnd();
         return;
     }
+    if (m_verifier && bytesRead > 0)
+        m_verifier->addData(offset, buff->constData(), bytesRead);
     // The read callback in ExtractWorker class expects the buffer size to
     // match the number of bytes read. Some formats will fail if the buffer
     // is larger than the actual data.
@@ -303,10 +434,12 @@ void LibArchiveWrapperPrivate::init()
     QObject::connect(&m_timer, &QTimer::timeout,
                      this, &LibArchiveWrapperPrivate::processSignals);
 
-    QObject::connect(&m_archive, &LibArchiveArchive::currentEntryChanged,
-                     this, &LibArchiveWrapperPrivate::currentEntryChanged);
+    QObject::connect(&m_archive, &LibArchiveArchive::entriesExtracted,
+                     this, &LibArchiveWrapperPrivate::entriesExtracted);
     QObject::connect(&m_archive, &LibArchiveArchive::completedChanged,
                      this, &LibArchiveWrapperPrivate::completedChanged);
+    QObject::connect(&m_archive, &LibArchiveArchive::fileBackedUp,
+                     this, &LibArchiveWrapperPrivate::fileBackedUp);
 
     QObject::connect(this, &LibArchiveWrapperPrivate::dataBlockRequested,
                      this, &LibArchiveWrapperPrivate::onDataBlockRequested);
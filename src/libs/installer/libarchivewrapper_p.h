@@ -55,16 +55,24 @@ public:
 
     QString errorString() const;
 
-    bool extract(const QString &dirPath, const quint64 totalFiles = 0);
+    bool extract(const QString &dirPath);
+    bool extract(const QString &dirPath, const QStringList &entries);
     bool create(const QStringList &data);
     QVector<ArchiveEntry> list();
     bool isSupported();
 
     void setCompressionLevel(const AbstractArchive::CompressionLevel level);
+    void setCompressionThreads(const int threads);
+    void setSolidBlockSize(const qint64 size);
+    void setBackupExistingFiles(const bool backup);
+    void setExpectedChecksum(const QByteArray &checksum);
+    void setCreatedChecksumAlgorithms(const QList<QCryptographicHash::Algorithm> &algorithms);
+    QByteArray createdChecksum(QCryptographicHash::Algorithm algorithm) const;
 
 Q_SIGNALS:
-    void currentEntryChanged(const QString &filename);
+    void entriesExtracted(const QStringList &filenames);
     void completedChanged(const quint64 completed, const quint64 total);
+    void fileBackedUp(const QString &filename, const QString &backupFilename);
     void dataBlockRequested();
     void remoteWorkerFinished();
 
@@ -87,6 +95,10 @@ private:
     mutable QReadWriteLock m_lock;
 
     LibArchiveArchive m_archive;
+
+    QByteArray m_expectedChecksum;
+    ChecksumVerifier *m_verifier = nullptr;
+    QString m_clientError;
 };
 
 } // namespace QInstaller
@@ -91,6 +91,70 @@ static QUrl resolveUrl(const FileTaskResult &result, const QString &url)
     return u;
 }
 
+/*
+    Returns the names of the packages in the Updates.xml element \a root an updater needs
+    meta data for: the \a installed packages, essential packages, packages replacing an
+    installed one, and their dependencies and automatic dependencies.
+*/
+static QSet<QString> packagesNeededForUpdate(const QDomElement &root, const QSet<QString> &installed)
+{
+    QHash<QString, QDomElement> packages;
+    for (QDomElement package = root.firstChildElement(QLatin1String("PackageUpdate")); !package.isNull();
+            package = package.nextSiblingElement(QLatin1String("PackageUpdate"))) {
+        packages.insert(package.firstChildElement(scName).text(), package);
+    }
+
+    QSet<QString> needed = installed;
+    QHash<QString, QDomElement>::const_iterator it;
+    for (it = packages.constBegin(); it != packages.constEnd(); ++it) {
+        if (it.value().firstChildElement(scEssential).text().toLower() == scTrue) {
+            needed.insert(it.key());
+            continue;
+        }
+        const QStringList replaces = it.value().firstChildElement(scReplaces).text()
+            .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+        foreach (const QString &replaced, replaces) {
+            if (installed.contains(replaced))
+                needed.insert(it.key());
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (it = packages.constBegin(); it != packages.constEnd(); ++it) {
+            if (needed.contains(it.key())) {
+                const QStringList dependencies = it.value().firstChildElement(scDependencies).text()
+                    .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+                foreach (const QString &dependency, dependencies) {
+                    QString name;
+                    PackageManagerCore::parseNameAndVersion(dependency, &name, nullptr);
+                    if (!needed.contains(name)) {
+                        needed.insert(name);
+                        changed = true;
+                    }
+                }
+                continue;
+            }
+            const QStringList autoDependencies = it.value().firstChildElement(scAutoDependOn).text()
+                .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+            if (autoDependencies.isEmpty())
+                continue;
+            bool allNeeded = true;
+            foreach (const QString &dependency, autoDependencies) {
+                QString name;
+                PackageManagerCore::parseNameAndVersion(dependency, &name, nullptr);
+                allNeeded &= needed.contains(name);
+            }
+            if (allNeeded) {
+                needed.insert(it.key());
+                changed = true;
+            }
+        }
+    }
+    return needed;
+}
+
 MetadataJob::MetadataJob(QObject *parent)
     : Job(parent)
     , m_core(nullptr)
@@ -479,6 +543,7 @@ void MetadataJob::metadataTaskFinished()
                     }
                     UnzipArchiveTask *task = new UnzipArchiveTask(result.target(),
                         item.value(TaskRole::UserRole).toString());
+                    task->setSkippedComponents(item.value(TaskRole::SkippedComponents).toStringList());
 
                     QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
                     m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
@@ -632,16 +697,82 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
 
         // If we have top level sha1 and MetadataName elements, we have compressed
         // all metadata inside one repository to a single 7z file. Fetch that
-        // instead of component specific meta 7z files.
-        const QDomNode sha1 = root.firstChildElement(scSHA1);
+        // instead of component specific meta 7z files. Repositories created with
+        // SHA-256 checksums have a sha256 element instead.
+        QDomNode sha1 = root.firstChildElement(scSHA1);
+        if (sha1.isNull())
+            sha1 = root.firstChildElement(scSHA256);
         QDomElement metadataNameElement = root.firstChildElement(QLatin1String("MetadataName"));
         QDomNodeList children = root.childNodes();
         if (!sha1.isNull() && !metadataNameElement.isNull()) {
-           const QString repoUrl = metadata.repository.url().toString();
-           const QString metadataName = metadataNameElement.toElement().text();
-           addFileTaskItem(QString::fromLatin1("%1/%2").arg(repoUrl, metadataName),
-               metadata.directory + QString::fromLatin1("/%1").arg(metadataName),
-               metadata, sha1.toElement().text(), QString());
+            // Chunks created by repogen --metadata-chunk-size contain the metadata of further
+            // components. Patches appended to the single 7z file by repogen --append-metadata
+            // contain newer metadata of some components, which is not taken from the files before.
+            QList<QPair<QString, QString> > archives;
+            QList<QStringList> archiveComponents;
+            QList<QStringList> skippedComponents;
+            archives.append(qMakePair(metadataNameElement.text(), sha1.toElement().text()));
+            archiveComponents.append(QStringList());
+            skippedComponents.append(QStringList());
+            for (QDomElement archive = root.firstChildElement(); !archive.isNull();
+                    archive = archive.nextSiblingElement()) {
+                if (archive.tagName() != QLatin1String("MetadataChunk")
+                        && archive.tagName() != QLatin1String("MetadataPatch")) {
+                    continue;
+                }
+                const QStringList components = archive.firstChildElement(QLatin1String("Components"))
+                    .text().split(QLatin1Char(','), QString::SkipEmptyParts);
+                for (int i = 0; i < skippedComponents.count(); ++i)
+                    skippedComponents[i].append(components);
+
+                QDomElement archiveChecksum = archive.firstChildElement(scSHA1);
+                if (archiveChecksum.isNull())
+                    archiveChecksum = archive.firstChildElement(scSHA256);
+                archives.append(qMakePair(archive.firstChildElement(scName).text(), archiveChecksum.text()));
+                archiveComponents.append(components);
+                skippedComponents.append(QStringList());
+            }
+
+            // An updater only needs the metadata of installed components and the components
+            // they may pull in, so further archives without any of them are not fetched. Their
+            // components are removed from the local Updates.xml, as there is no metadata for them.
+            QSet<QString> neededPackages;
+            if (m_core->isUpdater() && archives.count() > 1)
+                neededPackages = packagesNeededForUpdate(root, m_core->localInstalledPackages().keys().toSet());
+            QSet<QString> unfetchedComponents;
+
+            const QString repoUrl = metadata.repository.url().toString();
+            for (int i = 0; i < archives.count(); ++i) {
+                if (!neededPackages.isEmpty() && i > 0
+                        && !archiveComponents.at(i).toSet().intersects(neededPackages)) {
+                    unfetchedComponents.unite(archiveComponents.at(i).toSet());
+                    continue;
+                }
+                const QString metadataName = archives.at(i).first;
+                addFileTaskItem(QString::fromLatin1("%1/%2").arg(repoUrl, metadataName),
+                    metadata.directory + QString::fromLatin1("/%1").arg(metadataName),
+                    metadata, archives.at(i).second, QString(), skippedComponents.at(i));
+            }
+
+            if (!unfetchedComponents.isEmpty()) {
+                qCDebug(QInstaller::lcDeveloperBuild) << "Skipping the metadata of"
+                    << unfetchedComponents.count() << "components not needed for updates from"
+                    << metadata.repository.displayname();
+                QDomElement package = root.firstChildElement(QLatin1String("PackageUpdate"));
+                while (!package.isNull()) {
+                    const QDomElement next = package.nextSiblingElement(QLatin1String("PackageUpdate"));
+                    if (unfetchedComponents.contains(package.firstChildElement(scName).text()))
+                        doc.documentElement().removeChild(package);
+                    package = next;
+                }
+                if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot open Updates.xml for writing:"
+                        << file.errorString();
+                    return XmlDownloadFailure;
+                }
+                file.write(doc.toByteArray());
+                file.close();
+            }
         } else {
             bool metaFound = false;
             for (int i = 0; i < children.count(); ++i) {
@@ -747,7 +878,8 @@ QSet<Repository> MetadataJob::getRepositories()
 }
 
 void MetadataJob::addFileTaskItem(const QString &source, const QString &target, const Metadata &metadata,
-                                  const QString &sha1, const QString &packageName)
+                                  const QString &sha1, const QString &packageName,
+                                  const QStringList &skippedComponents)
 {
     FileTaskItem item(source, target);
     QAuthenticator authenticator;
@@ -758,6 +890,8 @@ void MetadataJob::addFileTaskItem(const QString &source, const QString &target,
     item.insert(TaskRole::Checksum, sha1.toLatin1());
     item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
     item.insert(TaskRole::Name, packageName);
+    if (!skippedComponents.isEmpty())
+        item.insert(TaskRole::SkippedComponents, skippedComponents);
     m_packages.append(item);
 }
 
@@ -772,7 +906,7 @@ bool MetadataJob::parsePackageUpdate(const QDomNodeList &c2, QString &packageNam
             packageName = element.text();
         else if (element.tagName() == scVersion)
             packageVersion = (online ? element.text() : QString());
-        else if ((element.tagName() == QLatin1String("SHA1")) && testCheckSum)
+        else if ((element.tagName() == scSHA1 || element.tagName() == scSHA256) && testCheckSum)
             packageHash = element.text();
         else {
             foreach (QString meta, metaElements) {
@@ -103,7 +103,8 @@ private:
     Status parseUpdatesXml(const QList<FileTaskResult> &results);
     QSet<Repository> getRepositories();
     void addFileTaskItem(const QString &source, const QString &target, const Metadata &metadata,
-                         const QString &sha1, const QString &packageName);
+                         const QString &sha1, const QString &packageName,
+                         const QStringList &skippedComponents = QStringList());
     bool parsePackageUpdate(const QDomNodeList &c2, QString &packageName, QString &packageVersion,
                             QString &packageHash, bool online, bool testCheckSum);
     QHash<QString, QPair<Repository, Repository> > searchAdditionalRepositories(const QDomNode &repositoryUpdate,
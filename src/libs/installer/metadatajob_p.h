@@ -34,9 +34,17 @@
 
 #include <QDir>
 #include <QFile>
+#include <QSet>
 
 namespace QInstaller{
 
+namespace TaskRole {
+enum
+{
+    SkippedComponents = TaskRole::UserRole + 1
+};
+}
+
 class UnzipArchiveException : public QException
 {
 public:
@@ -65,6 +73,7 @@ public:
     {}
     QString target() { return m_targetDir; }
     QString archive() { return m_archive; }
+    void setSkippedComponents(const QStringList &components) { m_skippedComponents = components; }
     void doTask(QFutureInterface<void> &fi)
     {
         fi.reportStarted();
@@ -80,7 +89,19 @@ public:
             fi.reportException(UnzipArchiveException(MetadataJob::tr("Cannot open file \"%1\" for "
                 "reading: %2").arg(QDir::toNativeSeparators(m_archive), archive.errorString())));
         }
-        if (!archive.extract(m_targetDir)) {
+        // the meta data of skipped components is superseded by a later patch archive
+        QStringList entries;
+        if (!m_skippedComponents.isEmpty()) {
+            QSet<QString> components;
+            foreach (const ArchiveEntry &entry, archive.list())
+                components.insert(QDir::fromNativeSeparators(entry.path).section(QLatin1Char('/'), 0, 0));
+            entries = components.subtract(m_skippedComponents.toSet()).values();
+            if (entries.isEmpty()) {
+                fi.reportFinished();
+                return;
+            }
+        }
+        if (!(entries.isEmpty() ? archive.extract(m_targetDir) : archive.extract(m_targetDir, entries))) {
             fi.reportException(UnzipArchiveException(MetadataJob::tr("Error while extracting "
                 "archive \"%1\": %2").arg(QDir::toNativeSeparators(m_archive), archive.errorString())));
         }
@@ -91,6 +112,7 @@ public:
 private:
     QString m_archive;
     QString m_targetDir;
+    QStringList m_skippedComponents;
 };
 
 }   // namespace QInstaller
@@ -34,6 +34,7 @@
 #include "componentmodel.h"
 #include "downloadarchivesjob.h"
 #include "errors.h"
+#include "fileutils.h"
 #include "globals.h"
 #include "messageboxhandler.h"
 #include "packagemanagerproxyfactory.h"
@@ -43,6 +44,7 @@
 #include "remoteclient.h"
 #include "remotefileengine.h"
 #include "settings.h"
+#include "utils.h"
 #include "installercalculator.h"
 #include "uninstallercalculator.h"
 #include "loggingutils.h"
@@ -53,6 +55,7 @@
 #include <QFutureWatcher>
 #include <QtConcurrentRun>
 
+#include <QtCore/QDataStream>
 #include <QtCore/QMutex>
 #include <QtCore/QRegExp>
 #include <QtCore/QSettings>
@@ -458,6 +461,35 @@ static bool componentMatches(const Component *component, const QString &name,
     return PackageManagerCore::versionMatches(component->value(scVersion), version);
 }
 
+/*
+    Returns the files extracted from the installed version of the \a archive of \a component,
+    as listed by the Extract operation in the installerResources directory of \a targetDir.
+*/
+static QStringList installedArchiveFiles(QString targetDir, const Component *component,
+    const QString &archive)
+{
+    const QString installedVersion = component->value(scInstalledVersion);
+    if (installedVersion.isEmpty())
+        return QStringList();
+
+    QString fileName = installedVersion + archive;
+    fileName.chop(QFileInfo(fileName).suffix().length() + 1);
+    QFile file(QString::fromLatin1("%1/installerResources/%2/%3.txt").arg(targetDir, component->name(),
+        fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return QStringList();
+
+    QStringList files;
+    QDataStream in(&file);
+    in >> files;
+    // Does not change target on non macOS platforms.
+    if (QInstaller::isInBundle(targetDir, &targetDir))
+        targetDir = QDir::cleanPath(targetDir + QLatin1String("/.."));
+    for (int i = 0; i < files.count(); ++i)
+        files[i] = replacePath(files.at(i), QLatin1String(scRelocatable), targetDir);
+    return files;
+}
+
 /*!
     Creates the maintenance tool in the installation directory.
 */
@@ -764,15 +796,38 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
     Q_ASSERT(partProgressSize >= 0 && partProgressSize <= 1);
 
     QList<QPair<QString, QString> > archivesToDownload;
+    QHash<QString, QStringList> installedFiles;
+    QHash<QString, QStringList> patchedFiles;
     quint64 archivesToDownloadTotalSize = 0;
     QList<Component*> neededComponents = orderedComponentsToInstall();
     foreach (Component *component, neededComponents) {
         // collect all archives to be downloaded
         const QStringList toDownload = component->downloadableArchives();
+        const QStringList chunkManifests = component->value(scChunkManifests)
+            .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+        // patches only apply to the files of the version they were created from
+        QStringList deltaPatches;
+        if (KDUpdater::compareVersion(component->value(scInstalledVersion),
+                component->value(scDeltaPatchFrom)) == 0) {
+            deltaPatches = component->value(scDeltaPatches)
+                .split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+        }
         foreach (const QString &versionFreeString, toDownload) {
-            archivesToDownload.push_back(qMakePair(QString::fromLatin1("installer://%1/%2")
-                .arg(component->name(), versionFreeString), QString::fromLatin1("%1/%2/%3")
+            const QString archive = QString::fromLatin1("installer://%1/%2")
+                .arg(component->name(), versionFreeString);
+            archivesToDownload.push_back(qMakePair(archive, QString::fromLatin1("%1/%2/%3")
                 .arg(component->repositoryUrl().toString(), component->name(), versionFreeString)));
+
+            // updated archives are rebuilt from the files of the installed version if possible
+            const QString unversionedArchive = versionFreeString.mid(component->value(scVersion).length());
+            if (chunkManifests.contains(unversionedArchive) || deltaPatches.contains(unversionedArchive)) {
+                const QStringList files = installedArchiveFiles(value(scTargetDir), component,
+                    unversionedArchive);
+                if (!files.isEmpty() && chunkManifests.contains(unversionedArchive))
+                    installedFiles.insert(archive, files);
+                if (!files.isEmpty() && deltaPatches.contains(unversionedArchive))
+                    patchedFiles.insert(archive, files);
+            }
         }
         archivesToDownloadTotalSize += component->value(scCompressedSize).toULongLong();
     }
@@ -786,6 +841,8 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
     archivesJob.setAutoDelete(false);
     archivesJob.setArchivesToDownload(archivesToDownload);
     archivesJob.setExpectedTotalSize(archivesToDownloadTotalSize);
+    archivesJob.setInstalledFiles(installedFiles);
+    archivesJob.setPatchedFiles(patchedFiles);
     connect(this, &PackageManagerCore::installationInterrupted, &archivesJob, &Job::cancel);
     connect(&archivesJob, &DownloadArchivesJob::outputTextChanged,
             ProgressCoordinator::instance(), &ProgressCoordinator::emitLabelAndDetailTextChanged);
@@ -3650,6 +3707,9 @@ bool PackageManagerCore::updateComponentData(struct Data &data, Component *compo
             component->setValue(QLatin1String("username"), repo.username());
             component->setValue(QLatin1String("password"), repo.password());
         }
+        // repositories might use different checksum algorithms for their archives
+        if (d->m_checksumAlgorithms.contains(localPath))
+            component->setValue(scChecksumType, checksumName(d->m_checksumAlgorithms.value(localPath)));
 
         // add downloadable archive from xml
         const QStringList downloadableArchives = data.package->data(scDownloadableArchives).toString()
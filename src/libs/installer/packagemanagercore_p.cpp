@@ -2623,6 +2623,16 @@ bool PackageManagerCorePrivate::addUpdateResourcesFromRepositories(bool parseChe
             const QDomNode checksum = doc.documentElement().firstChildElement(QLatin1String("Checksum"));
             if (!checksum.isNull())
                 m_core->setTestChecksum(checksum.toElement().text().toLower() == scTrue);
+
+            // repositories without the element use SHA-1
+            QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha1;
+            const QDomNode checksumType = doc.documentElement().firstChildElement(scChecksumType);
+            if (!checksumType.isNull()
+                    && !checksumAlgorithmFromName(checksumType.toElement().text(), &algorithm)) {
+                qCWarning(QInstaller::lcInstallerInstallLog) << "Unsupported checksum type"
+                    << checksumType.toElement().text() << "in" << updatesFile.fileName();
+            }
+            m_checksumAlgorithms.insert(data.directory, algorithm);
         }
         if (data.repository.isCompressed())
             m_compressedPackageSources.insert(PackageSource(QUrl::fromLocalFile(data.directory), 2));
@@ -187,6 +187,8 @@ public:
 
     bool m_needsHardRestart;
     bool m_testChecksum;
+    // checksum algorithm of each repository, by the directory of its meta data
+    QHash<QString, QCryptographicHash::Algorithm> m_checksumAlgorithms;
     bool m_launchedAsRoot;
     bool m_commandLineInstance;
     bool m_defaultInstall;
@@ -85,6 +85,8 @@ void sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &
     Reads a packet from \a device, and stores its content into \a command and \a data.
 
     Returns \c false if the packet in the device buffer is yet incomplete, \c true otherwise.
+    An incomplete packet is left untouched in the buffer of \a device, so that it can be
+    read as a whole once the remaining bytes have arrived.
 
     \note Both client and server need to have the same endianness.
  */
@@ -93,23 +95,23 @@ bool receivePacket(QIODevice *device, QByteArray *command, QByteArray *data)
     if (device->bytesAvailable() < static_cast<qint64>(sizeof(PackageSize)))
         return false;
 
-    // read payload size
-    char payloadBytes[sizeof(PackageSize)];
-    PackageSize *payloadSize = reinterpret_cast<PackageSize*>(&payloadBytes);
-    device->read(payloadBytes, sizeof(PackageSize));
+    // peek payload size, consume nothing until the whole packet is available
+    PackageSize payloadSize = 0;
+    if (device->peek(reinterpret_cast<char *>(&payloadSize), sizeof(PackageSize))
+            != static_cast<qint64>(sizeof(PackageSize))) {
+        return false;
+    }
 
     // not enough data yet? back off ...
-    if (device->bytesAvailable() < *payloadSize) {
-        for (int i = sizeof(PackageSize) - 1; i >= 0; --i)
-            device->ungetChar(payloadBytes[i]);
+    if (device->bytesAvailable() < static_cast<qint64>(sizeof(PackageSize)) + payloadSize)
         return false;
-    }
 
-    const QByteArray payload = device->read(*payloadSize);
-    int separator = payload.indexOf('\0');
+    device->read(reinterpret_cast<char *>(&payloadSize), sizeof(PackageSize));
+    const QByteArray payload = device->read(payloadSize);
+    const int separator = payload.indexOf('\0');
 
     *command = payload.left(separator);
-    *data = payload.right(payload.size() - separator - 1);
+    *data = payload.mid(separator + 1);
     return true;
 }
 
@@ -175,17 +175,30 @@ const char AbstractArchiveCreate[] = "AbstractArchive::create";
 const char AbstractArchiveList[] = "AbstractArchive::list";
 const char AbstractArchiveIsSupported[] = "AbstractArchive::isSupported";
 const char AbstractArchiveSetCompressionLevel[] = "AbstractArchive::setCompressionLevel";
+const char AbstractArchiveSetCompressionThreads[] = "AbstractArchive::setCompressionThreads";
+const char AbstractArchiveSetSolidBlockSize[] = "AbstractArchive::setSolidBlockSize";
+const char AbstractArchiveSetBackupExistingFiles[] = "AbstractArchive::setBackupExistingFiles";
 const char AbstractArchiveAddDataBlock[] = "AbstractArchive::addDataBlock";
 const char AbstractArchiveSetClientDataAtEnd[] = "AbstractArchive::setClientDataAtEnd";
 const char AbstractArchiveWorkerStatus[] = "AbstractArchive::workerStatus";
 const char AbstractArchiveCancel[] = "AbstractArchive::cancel";
 
 const char GetAbstractArchiveSignals[] = "GetAbstractArchiveSignals";
-const char AbstractArchiveSignalCurrentEntryChanged[] = "AbstractArchive::currentEntryChanged";
+const char AbstractArchiveSignalEntriesExtracted[] = "AbstractArchive::entriesExtracted";
 const char AbstractArchiveSignalCompletedChanged[] = "AbstractArchive::completedChanged";
+const char AbstractArchiveSignalFileBackedUp[] = "AbstractArchive::fileBackedUp";
 const char AbstractArchiveSignalDataBlockRequested[] = "AbstractArchive::dataBlockRequested";
 const char AbstractArchiveSignalWorkerFinished[] = "AbstractArchive::workerFinished";
 
+
+// RemoteFileOperations
+const char FileOperations[] = "FileOperations";
+const char FileOperationsStart[] = "FileOperations::start";
+const char FileOperationsStatus[] = "FileOperations::status";
+const char FileOperationsErrorString[] = "FileOperations::errorString";
+const char FileOperationsResult[] = "FileOperations::result";
+const char FileOperationsCancel[] = "FileOperations::cancel";
+
 } // namespace Protocol
 
 void INSTALLER_EXPORT sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &data);
@@ -0,0 +1,241 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "remotefileoperations.h"
+
+#include "protocol.h"
+
+#include <QEventLoop>
+#include <QTimer>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::RemoteFileOperations
+    \internal
+    \brief The RemoteFileOperations class runs bulk file operations, optionally
+    in the elevated server process.
+
+    If the remote connection is active, each operation is sent as a single command to
+    the server, which executes it with a FileOperationsWorker. The client only polls the
+    status and progress of the operation instead of forwarding every file system call.
+    While waiting for the server, a local event loop is running.
+
+    Without a remote connection the operations run directly in the calling thread.
+*/
+
+/*!
+    \fn QInstaller::RemoteFileOperations::progressChanged(quint64 completed, quint64 total)
+
+    Emitted periodically while an operation is running with the \a completed
+    and \a total amount of work. Without a remote connection, it is emitted only
+    once the operation has finished.
+*/
+
+/*!
+    Constructs the object with \a parent.
+*/
+RemoteFileOperations::RemoteFileOperations(QObject *parent)
+    : RemoteObject(QLatin1String(Protocol::FileOperations), parent)
+    , m_status(FileOperationsWorker::Idle)
+{
+}
+
+/*!
+    Destroys the instance.
+*/
+RemoteFileOperations::~RemoteFileOperations()
+{
+}
+
+/*!
+    Copies the file \a source to \a target. Returns \c true on success; \c false otherwise.
+*/
+bool RemoteFileOperations::copyFile(const QString &source, const QString &target)
+{
+    return run(FileOperationsWorker::CopyFile, source, target);
+}
+
+/*!
+    Copies the directory \a source recursively to \a target. Returns \c true
+    on success; \c false otherwise.
+*/
+bool RemoteFileOperations::copyDirectory(const QString &source, const QString &target)
+{
+    return run(FileOperationsWorker::CopyDirectory, source, target);
+}
+
+/*!
+    Moves the file or directory \a source to \a target. Returns \c true
+    on success; \c false otherwise.
+*/
+bool RemoteFileOperations::move(const QString &source, const QString &target)
+{
+    return run(FileOperationsWorker::Move, source, target);
+}
+
+/*!
+    Removes the directory \a path recursively. Returns \c true on success;
+    \c false otherwise.
+*/
+bool RemoteFileOperations::removeDirectory(const QString &path)
+{
+    return run(FileOperationsWorker::RemoveDirectory, path);
+}
+
+/*!
+    Sets \a permissions for \a path, recursively if \a path is a directory.
+    Returns \c true on success; \c false otherwise.
+*/
+bool RemoteFileOperations::setPermissions(const QString &path, QFileDevice::Permissions permissions)
+{
+    return run(FileOperationsWorker::SetPermissions, path, static_cast<uint>(permissions));
+}
+
+/*!
+    Returns the checksum of the file \a path calculated with \a algorithm, or an
+    empty byte array on failure.
+*/
+QByteArray RemoteFileOperations::hashFile(const QString &path,
+    QCryptographicHash::Algorithm algorithm)
+{
+    if (!run(FileOperationsWorker::HashFile, path, static_cast<int>(algorithm)))
+        return QByteArray();
+
+    if (isConnectedToServer())
+        return callRemoteMethod<QByteArray>(QLatin1String(Protocol::FileOperationsResult));
+    return m_worker.result();
+}
+
+/*!
+    Returns the status of the operation as last reported before progressChanged() was emitted.
+*/
+FileOperationsWorker::Status RemoteFileOperations::status() const
+{
+    return m_status;
+}
+
+/*!
+    Returns a human-readable description of the last error that occurred.
+*/
+QString RemoteFileOperations::errorString() const
+{
+    return m_errorString;
+}
+
+/*!
+    Cancels the operation in progress.
+*/
+void RemoteFileOperations::cancel()
+{
+    if (isConnectedToServer()) {
+        callRemoteMethod(QLatin1String(Protocol::FileOperationsCancel));
+        return;
+    }
+    m_worker.cancel();
+}
+
+/*!
+    Starts \a operation for \a path with the additional \a argument and waits
+    for it to finish. Returns \c true if the operation succeeded.
+*/
+bool RemoteFileOperations::run(FileOperationsWorker::Operation operation, const QString &path,
+    const QVariant &argument)
+{
+    m_errorString.clear();
+
+    if (!connectToServer()) {
+        // Running the operation in a thread pool and waiting for it could dead-lock
+        // when called from a pool thread, like the install operations are.
+        if (!m_worker.run(operation, path, argument)
+                && m_worker.status() == FileOperationsWorker::Running) {
+            m_errorString = tr("Another file operation is already running.");
+            return false;
+        }
+        processStatus();
+        if (m_status == FileOperationsWorker::Success)
+            return true;
+        m_errorString = m_worker.errorString();
+        return false;
+    }
+
+    if (!callRemoteMethod<bool>(QLatin1String(Protocol::FileOperationsStart),
+            static_cast<qint32>(operation), path, argument)) {
+        m_errorString = tr("Another file operation is already running.");
+        return false;
+    }
+
+    if (processStatus()) {
+        // Poll often at first, so that short operations like copying a small file
+        // do not wait for the full interval.
+        QEventLoop loop;
+        QTimer timer;
+        timer.setSingleShot(true);
+        connect(&timer, &QTimer::timeout, [&]() {
+            if (!processStatus()) {
+                loop.quit();
+                return;
+            }
+            timer.start(qMin(timer.interval() * 2, 100));
+        });
+        timer.start(1);
+        loop.exec();
+    }
+
+    if (m_status == FileOperationsWorker::Success)
+        return true;
+
+    m_errorString = callRemoteMethod<QString>(QLatin1String(Protocol::FileOperationsErrorString));
+    return false;
+}
+
+/*!
+    Fetches the status of the running operation and emits progressChanged().
+    Returns \c true while the operation is still running.
+*/
+bool RemoteFileOperations::processStatus()
+{
+    quint64 completed = 0;
+    quint64 total = 0;
+    if (isConnectedToServer()) {
+        const QVariantList status = callRemoteMethod<QVariantList>(
+            QLatin1String(Protocol::FileOperationsStatus));
+        m_status = static_cast<FileOperationsWorker::Status>(status.value(0).toInt());
+        completed = status.value(1).value<quint64>();
+        total = status.value(2).value<quint64>();
+    } else {
+        m_status = m_worker.status();
+        completed = m_worker.completed();
+        total = m_worker.total();
+    }
+    emit progressChanged(completed, total);
+    return m_status == FileOperationsWorker::Running;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,79 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef REMOTEFILEOPERATIONS_H
+#define REMOTEFILEOPERATIONS_H
+
+#include "fileoperationsworker.h"
+#include "remoteobject.h"
+
+#include <QCryptographicHash>
+#include <QFileDevice>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT RemoteFileOperations : public RemoteObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(RemoteFileOperations)
+
+public:
+    explicit RemoteFileOperations(QObject *parent = nullptr);
+    ~RemoteFileOperations();
+
+    bool copyFile(const QString &source, const QString &target);
+    bool copyDirectory(const QString &source, const QString &target);
+    bool move(const QString &source, const QString &target);
+    bool removeDirectory(const QString &path);
+    bool setPermissions(const QString &path, QFileDevice::Permissions permissions);
+    QByteArray hashFile(const QString &path,
+        QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha1);
+
+    FileOperationsWorker::Status status() const;
+    QString errorString() const;
+
+Q_SIGNALS:
+    void progressChanged(quint64 completed, quint64 total);
+
+public Q_SLOTS:
+    void cancel();
+
+private:
+    bool run(FileOperationsWorker::Operation operation, const QString &path,
+        const QVariant &argument = QVariant());
+    bool processStatus();
+
+private:
+    FileOperationsWorker m_worker;
+    FileOperationsWorker::Status m_status;
+    QString m_errorString;
+};
+
+} // namespace QInstaller
+
+#endif // REMOTEFILEOPERATIONS_H
@@ -36,6 +36,7 @@
 #include <QHostAddress>
 #include <QPointer>
 #include <QLocalServer>
+#include <QThreadPool>
 #include <QTimer>
 
 namespace QInstaller {
@@ -53,6 +54,11 @@ public:
     {
         setSocketOptions(QLocalServer::WorldAccessOption);
         listen(socketName);
+
+        // Shared by all connections to run long lasting requests, like the file copies
+        // of elevated Copy, Move and CopyDirectory operations, so that independent
+        // clients are served concurrently.
+        m_workerPool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
     }
 
     ~LocalServer() {
@@ -71,6 +77,7 @@ private slots:
             thread->quit();
             thread->wait();
         }
+        m_workerPool.waitForDone();
         emit shutdownRequested();
     }
 
@@ -79,7 +86,8 @@ private:
         if (m_shutdown)
             return;
 
-        RemoteServerConnection *thread = new RemoteServerConnection(socketDescriptor, m_key, this);
+        RemoteServerConnection *thread = new RemoteServerConnection(socketDescriptor, m_key,
+            &m_workerPool, this);
         connect(thread, &QThread::finished, thread, &QObject::deleteLater);
         connect(thread, &RemoteServerConnection::shutdownRequested, this, &LocalServer::shutdown);
         thread->start();
@@ -89,6 +97,7 @@ private:
 private:
     QString m_key;
     bool m_shutdown;
+    QThreadPool m_workerPool;
 };
 
 class RemoteServerPrivate
@@ -29,6 +29,7 @@
 #include "remoteserverconnection.h"
 
 #include "errors.h"
+#include "fileoperationsworker.h"
 #include "protocol.h"
 #include "remoteserverconnection_p.h"
 #include "utils.h"
@@ -57,12 +58,15 @@ namespace QInstaller {
 */
 
 RemoteServerConnection::RemoteServerConnection(qintptr socketDescriptor, const QString &key,
-                                               QObject *parent)
+                                               QThreadPool *workerPool, QObject *parent)
     : QThread(parent)
     , m_socketDescriptor(socketDescriptor)
+    , m_workerPool(workerPool)
     , m_process(nullptr)
     , m_engine(nullptr)
     , m_archive(nullptr)
+    , m_fileOperations(nullptr)
+    , m_authorized(false)
     , m_authorizationKey(key)
     , m_processSignalReceiver(nullptr)
     , m_archiveSignalReceiver(nullptr)
@@ -70,6 +74,14 @@ RemoteServerConnection::RemoteServerConnection(qintptr socketDescriptor, const Q
     setObjectName(QString::fromLatin1("RemoteServerConnection(%1)").arg(socketDescriptor));
 }
 
+RemoteServerConnection::~RemoteServerConnection()
+{
+    // The client might have disconnected without sending Destroy. Deleting the
+    // worker cancels a running file operation and waits for it to finish.
+    delete m_fileOperations;
+    delete m_engine;
+}
+
 // Helper RAII to ensure stream data was correctly (and completely) read
 struct StreamChecker {
     StreamChecker(QDataStream *stream) : stream(stream) {}
@@ -85,152 +97,189 @@ void RemoteServerConnection::run()
 {
     QLocalSocket socket;
     socket.setSocketDescriptor(m_socketDescriptor);
-    QScopedPointer<PermissionSettings> settings;
 
-    bool authorized = false;
-    while (socket.state() == QLocalSocket::ConnectedState) {
-        QByteArray cmd;
-        QByteArray data;
+    // Packets are processed as soon as the socket signals new data, a partially received
+    // packet stays in the socket buffer until the next readyRead() completes it.
+    connect(&socket, &QLocalSocket::readyRead, &socket, [this, &socket]() {
+        processPackets(&socket);
+    });
+    connect(&socket, &QLocalSocket::disconnected, &socket, [this]() {
+        quit();
+    });
+
+    // data might have arrived before the connections were made
+    if (processPackets(&socket) && socket.state() == QLocalSocket::ConnectedState)
+        exec();
+
+    m_settings.reset();
+    m_authorized = false;
+}
 
-        if (!receivePacket(&socket, &cmd, &data)) {
-            socket.waitForReadyRead(250);
-            qApp->processEvents();
-            continue;
+/*!
+    Handles all complete packets available on \a socket. Returns \c false if
+    the connection is done and the thread was asked to quit.
+*/
+bool RemoteServerConnection::processPackets(QLocalSocket *socket)
+{
+    QByteArray cmd;
+    QByteArray data;
+    while (receivePacket(socket, &cmd, &data)) {
+        if (!handlePacket(socket, cmd, data)) {
+            quit();
+            return false;
         }
+    }
+    return true;
+}
 
-        const QString command = QString::fromLatin1(cmd);
-        QBuffer buf;
-        buf.setBuffer(&data);
-        buf.open(QIODevice::ReadOnly);
-        QDataStream stream;
-        stream.setDevice(&buf);
-        StreamChecker streamChecker(&stream);
+/*!
+    Handles a single packet with \a cmd and \a data received on \a socket.
+    Returns \c false if the connection should be closed.
+*/
+bool RemoteServerConnection::handlePacket(QLocalSocket *socket, const QByteArray &cmd,
+                                          QByteArray &data)
+{
+    const QString command = QString::fromLatin1(cmd);
+    QBuffer buf;
+    buf.setBuffer(&data);
+    buf.open(QIODevice::ReadOnly);
+    QDataStream stream;
+    stream.setDevice(&buf);
+    StreamChecker streamChecker(&stream);
 
-        if (authorized && command == QLatin1String(Protocol::Shutdown)) {
-            authorized = false;
-            sendData(&socket, true);
-            socket.flush();
-            socket.close();
-            emit shutdownRequested();
-            return;
-        } else if (command == QLatin1String(Protocol::Authorize)) {
-            QString key;
-            stream >> key;
-            sendData(&socket, (authorized = (key == m_authorizationKey)));
-            socket.flush();
-            if (!authorized) {
-                socket.close();
-                return;
-            }
-        } else if (authorized) {
-            if (command.isEmpty())
-                continue;
+    if (m_authorized && command == QLatin1String(Protocol::Shutdown)) {
+        m_authorized = false;
+        sendData(socket, true);
+        socket->flush();
+        socket->close();
+        emit shutdownRequested();
+        return false;
+    } else if (command == QLatin1String(Protocol::Authorize)) {
+        QString key;
+        stream >> key;
+        sendData(socket, (m_authorized = (key == m_authorizationKey)));
+        socket->flush();
+        if (!m_authorized) {
+            socket->close();
+            return false;
+        }
+    } else if (m_authorized) {
+        if (command.isEmpty())
+            return true;
 
-            if (command == QLatin1String(Protocol::Create)) {
-                QString type;
-                stream >> type;
-                if (type == QLatin1String(Protocol::QSettings)) {
-                    QVariant application;
-                    QVariant organization;
-                    QVariant scope, format;
-                    QVariant fileName;
-                    stream >> application; stream >> organization; stream >> scope; stream >> format;
-                    stream >> fileName;
+        if (command == QLatin1String(Protocol::Create)) {
+            QString type;
+            stream >> type;
+            if (type == QLatin1String(Protocol::QSettings)) {
+                QVariant application;
+                QVariant organization;
+                QVariant scope, format;
+                QVariant fileName;
+                stream >> application; stream >> organization; stream >> scope; stream >> format;
+                stream >> fileName;
 
-                    if (fileName.toString().isEmpty()) {
-                        settings.reset(new PermissionSettings(QSettings::Format(format.toInt()),
-                            QSettings::Scope(scope.toInt()), organization.toString(), application
-                            .toString()));
-                    } else {
-                        settings.reset(new PermissionSettings(fileName.toString(), QSettings::Format(format.toInt())));
-                    }
-                } else if (type == QLatin1String(Protocol::QProcess)) {
-                    if (m_process)
-                        m_process->deleteLater();
-                    m_process = new QProcess;
-                    m_processSignalReceiver = new QProcessSignalReceiver(m_process);
-                } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
-                    if (m_engine)
-                        delete m_engine;
-                    m_engine = new QFSFileEngine;
-                } else if (type == QLatin1String(Protocol::AbstractArchive)) {
-#ifdef IFW_LIBARCHIVE
-                    if (m_archive)
-                        m_archive->deleteLater();
-                    m_archive = new LibArchiveArchive;
-                    m_archiveSignalReceiver = new AbstractArchiveSignalReceiver(static_cast<LibArchiveArchive *>(m_archive));
-#else
-                    Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
-#endif
+                if (fileName.toString().isEmpty()) {
+                    m_settings.reset(new PermissionSettings(QSettings::Format(format.toInt()),
+                        QSettings::Scope(scope.toInt()), organization.toString(), application
+                        .toString()));
+                } else {
+                    m_settings.reset(new PermissionSettings(fileName.toString(), QSettings::Format(format.toInt())));
                 }
-                continue;
-            }
-
-            if (command == QLatin1String(Protocol::Destroy)) {
-                QString type;
-                stream >> type;
-                if (type == QLatin1String(Protocol::QSettings)) {
-                    settings.reset();
-                } else if (type == QLatin1String(Protocol::QProcess)) {
-                    m_processSignalReceiver->m_receivedSignals.clear();
+            } else if (type == QLatin1String(Protocol::QProcess)) {
+                if (m_process)
                     m_process->deleteLater();
-                    m_process = nullptr;
-                } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
+                m_process = new QProcess;
+                m_processSignalReceiver = new QProcessSignalReceiver(m_process);
+            } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
+                if (m_engine)
                     delete m_engine;
-                    m_engine = nullptr;
-                } else if (type == QLatin1String(Protocol::AbstractArchive)) {
+                m_engine = new QFSFileEngine;
+            } else if (type == QLatin1String(Protocol::AbstractArchive)) {
 #ifdef IFW_LIBARCHIVE
-                    m_archiveSignalReceiver->m_receivedSignals.clear();
+                if (m_archive)
                     m_archive->deleteLater();
-                    m_archive = nullptr;
+                m_archive = new LibArchiveArchive;
+                m_archiveSignalReceiver = new AbstractArchiveSignalReceiver(static_cast<LibArchiveArchive *>(m_archive));
 #else
-                    Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
+                Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
 #endif
-                }
-                return;
+            } else if (type == QLatin1String(Protocol::FileOperations)) {
+                delete m_fileOperations;
+                m_fileOperations = new FileOperationsWorker(m_workerPool);
             }
+            return true;
+        }
 
-            if (command == QLatin1String(Protocol::GetQProcessSignals)) {
-                if (m_processSignalReceiver) {
-                    QMutexLocker _(&m_processSignalReceiver->m_lock);
-                    sendData(&socket, m_processSignalReceiver->m_receivedSignals);
-                    socket.flush();
-                    m_processSignalReceiver->m_receivedSignals.clear();
-                }
-                continue;
-            } else if (command == QLatin1String(Protocol::GetAbstractArchiveSignals)) {
+        if (command == QLatin1String(Protocol::Destroy)) {
+            QString type;
+            stream >> type;
+            if (type == QLatin1String(Protocol::QSettings)) {
+                m_settings.reset();
+            } else if (type == QLatin1String(Protocol::QProcess)) {
+                m_processSignalReceiver->m_receivedSignals.clear();
+                m_process->deleteLater();
+                m_process = nullptr;
+            } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
+                delete m_engine;
+                m_engine = nullptr;
+            } else if (type == QLatin1String(Protocol::AbstractArchive)) {
 #ifdef IFW_LIBARCHIVE
-                if (m_archiveSignalReceiver) {
-                    QMutexLocker _(&m_archiveSignalReceiver->m_lock);
-                    sendData(&socket, m_archiveSignalReceiver->m_receivedSignals);
-                    socket.flush();
-                    m_archiveSignalReceiver->m_receivedSignals.clear();
-                }
-                continue;
+                m_archiveSignalReceiver->m_receivedSignals.clear();
+                m_archive->deleteLater();
+                m_archive = nullptr;
 #else
                 Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
 #endif
+            } else if (type == QLatin1String(Protocol::FileOperations)) {
+                delete m_fileOperations;
+                m_fileOperations = nullptr;
             }
+            return false;
+        }
 
-            if (command.startsWith(QLatin1String(Protocol::QProcess))) {
-                handleQProcess(&socket, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::QSettings))) {
-                handleQSettings(&socket, command, stream, settings.data());
-            } else if (command.startsWith(QLatin1String(Protocol::QAbstractFileEngine))) {
-                handleQFSFileEngine(&socket, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::AbstractArchive))) {
-                handleArchive(&socket, command, stream);
-            } else {
-                qCDebug(QInstaller::lcServer) << "Unknown command:" << command;
+        if (command == QLatin1String(Protocol::GetQProcessSignals)) {
+            if (m_processSignalReceiver) {
+                QMutexLocker _(&m_processSignalReceiver->m_lock);
+                sendData(socket, m_processSignalReceiver->m_receivedSignals);
+                socket->flush();
+                m_processSignalReceiver->m_receivedSignals.clear();
             }
-            socket.flush();
+            return true;
+        } else if (command == QLatin1String(Protocol::GetAbstractArchiveSignals)) {
+#ifdef IFW_LIBARCHIVE
+            if (m_archiveSignalReceiver) {
+                QMutexLocker _(&m_archiveSignalReceiver->m_lock);
+                sendData(socket, m_archiveSignalReceiver->m_receivedSignals);
+                socket->flush();
+                m_archiveSignalReceiver->m_receivedSignals.clear();
+            }
+            return true;
+#else
+            Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
+#endif
+        }
+
+        if (command.startsWith(QLatin1String(Protocol::QProcess))) {
+            handleQProcess(socket, command, stream);
+        } else if (command.startsWith(QLatin1String(Protocol::QSettings))) {
+            handleQSettings(socket, command, stream, m_settings.data());
+        } else if (command.startsWith(QLatin1String(Protocol::QAbstractFileEngine))) {
+            handleQFSFileEngine(socket, command, stream);
+        } else if (command.startsWith(QLatin1String(Protocol::AbstractArchive))) {
+            handleArchive(socket, command, stream);
+        } else if (command.startsWith(QLatin1String(Protocol::FileOperations))) {
+            handleFileOperations(socket, command, stream);
         } else {
-            // authorization failed, connection not wanted
-            socket.close();
             qCDebug(QInstaller::lcServer) << "Unknown command:" << command;
-            return;
         }
+        socket->flush();
+    } else {
+        // authorization failed, connection not wanted
+        socket->close();
+        qCDebug(QInstaller::lcServer) << "Unknown command:" << command;
+        return false;
     }
+    return true;
 }
 
 template <typename T>
@@ -590,6 +639,18 @@ void RemoteServerConnection::handleArchive(QIODevice *socket, const QString &com
         qint32 level;
         data >> level;
         archive->setCompressionLevel(static_cast<AbstractArchive::CompressionLevel>(level));
+    } else if (command == QLatin1String(Protocol::AbstractArchiveSetCompressionThreads)) {
+        qint32 threads;
+        data >> threads;
+        archive->setCompressionThreads(threads);
+    } else if (command == QLatin1String(Protocol::AbstractArchiveSetSolidBlockSize)) {
+        qint64 size;
+        data >> size;
+        archive->setSolidBlockSize(size);
+    } else if (command == QLatin1String(Protocol::AbstractArchiveSetBackupExistingFiles)) {
+        bool backup;
+        data >> backup;
+        archive->setBackupExistingFiles(backup);
     } else if (command == QLatin1String(Protocol::AbstractArchiveAddDataBlock)) {
         QByteArray buff;
         data >> buff;
@@ -608,4 +669,32 @@ void RemoteServerConnection::handleArchive(QIODevice *socket, const QString &com
 #endif
 }
 
+void RemoteServerConnection::handleFileOperations(QIODevice *socket, const QString &command,
+                                                  QDataStream &data)
+{
+    if (command == QLatin1String(Protocol::FileOperationsStart)) {
+        qint32 operation;
+        QString path;
+        QVariant argument;
+        data >> operation;
+        data >> path;
+        data >> argument;
+        sendData(socket, m_fileOperations->start(
+            static_cast<FileOperationsWorker::Operation>(operation), path, argument));
+    } else if (command == QLatin1String(Protocol::FileOperationsStatus)) {
+        QVariantList status;
+        status << static_cast<qint32>(m_fileOperations->status())
+               << m_fileOperations->completed() << m_fileOperations->total();
+        sendData(socket, status);
+    } else if (command == QLatin1String(Protocol::FileOperationsErrorString)) {
+        sendData(socket, m_fileOperations->errorString());
+    } else if (command == QLatin1String(Protocol::FileOperationsResult)) {
+        sendData(socket, m_fileOperations->result());
+    } else if (command == QLatin1String(Protocol::FileOperationsCancel)) {
+        m_fileOperations->cancel();
+    } else if (!command.isEmpty()) {
+        qCDebug(QInstaller::lcServer) << "Unknown FileOperations command:" << command;
+    }
+}
+
 } // namespace QInstaller
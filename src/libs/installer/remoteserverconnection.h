@@ -32,6 +32,7 @@
 #include "abstractarchive.h"
 
 #include <QPointer>
+#include <QScopedPointer>
 #include <QThread>
 
 #include <QtCore/private/qfsfileengine_p.h>
@@ -39,11 +40,14 @@
 QT_BEGIN_NAMESPACE
 class QProcess;
 class QIODevice;
+class QLocalSocket;
+class QThreadPool;
 QT_END_NAMESPACE
 
 namespace QInstaller {
 
 class PermissionSettings;
+class FileOperationsWorker;
 
 class QProcessSignalReceiver;
 class AbstractArchiveSignalReceiver;
@@ -55,7 +59,8 @@ class RemoteServerConnection : public QThread
 
 public:
     RemoteServerConnection(qintptr socketDescriptor, const QString &authorizationKey,
-                           QObject *parent);
+                           QThreadPool *workerPool, QObject *parent);
+    ~RemoteServerConnection();
 
     void run() Q_DECL_OVERRIDE;
 
@@ -63,6 +68,9 @@ signals:
     void shutdownRequested();
 
 private:
+    bool processPackets(QLocalSocket *socket);
+    bool handlePacket(QLocalSocket *socket, const QByteArray &cmd, QByteArray &data);
+
     template <typename T>
     void sendData(QIODevice *device, const T &arg);
     void handleQProcess(QIODevice *device, const QString &command, QDataStream &data);
@@ -70,13 +78,18 @@ private:
                          PermissionSettings *settings);
     void handleQFSFileEngine(QIODevice *device, const QString &command, QDataStream &data);
     void handleArchive(QIODevice *device, const QString &command, QDataStream &data);
+    void handleFileOperations(QIODevice *device, const QString &command, QDataStream &data);
 
 private:
     qintptr m_socketDescriptor;
+    QThreadPool *m_workerPool;
 
     QProcess *m_process;
     QFSFileEngine *m_engine;
     AbstractArchive *m_archive;
+    FileOperationsWorker *m_fileOperations;
+    bool m_authorized;
+    QScopedPointer<PermissionSettings> m_settings;
     QString m_authorizationKey;
     QProcessSignalReceiver *m_processSignalReceiver;
     AbstractArchiveSignalReceiver *m_archiveSignalReceiver;
@@ -137,10 +137,12 @@ private:
     explicit AbstractArchiveSignalReceiver(LibArchiveArchive *archive)
         : QObject(archive)
     {
-        connect(archive, &LibArchiveArchive::currentEntryChanged,
-                this, &AbstractArchiveSignalReceiver::onCurrentEntryChanged);
+        connect(archive, &LibArchiveArchive::entriesExtracted,
+                this, &AbstractArchiveSignalReceiver::onEntriesExtracted);
         connect(archive, &LibArchiveArchive::completedChanged,
                 this, &AbstractArchiveSignalReceiver::onCompletedChanged);
+        connect(archive, &LibArchiveArchive::fileBackedUp,
+                this, &AbstractArchiveSignalReceiver::onFileBackedUp);
         connect(archive, &LibArchiveArchive::dataBlockRequested,
                 this, &AbstractArchiveSignalReceiver::onDataBlockRequested);
         connect(archive, &LibArchiveArchive::workerFinished,
@@ -148,11 +150,11 @@ private:
     }
 
 private Q_SLOTS:
-    void onCurrentEntryChanged(const QString &filename)
+    void onEntriesExtracted(const QStringList &filenames)
     {
         QMutexLocker _(&m_lock);
-        m_receivedSignals.append(QLatin1String(Protocol::AbstractArchiveSignalCurrentEntryChanged));
-        m_receivedSignals.append(filename);
+        m_receivedSignals.append(QLatin1String(Protocol::AbstractArchiveSignalEntriesExtracted));
+        m_receivedSignals.append(filenames);
     }
 
     void onCompletedChanged(quint64 completed, quint64 total)
@@ -163,6 +165,14 @@ private Q_SLOTS:
         m_receivedSignals.append(total);
     }
 
+    void onFileBackedUp(const QString &filename, const QString &backupFilename)
+    {
+        QMutexLocker _(&m_lock);
+        m_receivedSignals.append(QLatin1String(Protocol::AbstractArchiveSignalFileBackedUp));
+        m_receivedSignals.append(filename);
+        m_receivedSignals.append(backupFilename);
+    }
+
     void onDataBlockRequested()
     {
         QMutexLocker _(&m_lock);
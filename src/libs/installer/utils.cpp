@@ -160,12 +160,15 @@ std::ostream &QInstaller::operator<<(std::ostream &os, const QString &string)
 
 /*!
     \internal
+
+    Returns the hash of the remaining data of \a device, calculated with \a algo.
+    The function is thread-safe, every call reads into a buffer of its own.
 */
 QByteArray QInstaller::calculateHash(QIODevice *device, QCryptographicHash::Algorithm algo)
 {
     Q_ASSERT(device);
     QCryptographicHash hash(algo);
-    static QByteArray buffer(1024 * 1024, '\0');
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
     while (true) {
         const qint64 numRead = device->read(buffer.data(), buffer.size());
         if (numRead <= 0)
@@ -186,6 +189,52 @@ QByteArray QInstaller::calculateHash(const QString &path, QCryptographicHash::Al
     return calculateHash(&file, algo);
 }
 
+/*!
+    \internal
+
+    Returns the name of the repository checksum algorithm \a algo, as used for the
+    checksum elements in \c Updates.xml. The lower case name is the suffix of the
+    checksum files next to the archives.
+*/
+QString QInstaller::checksumName(QCryptographicHash::Algorithm algo)
+{
+    switch (algo) {
+    case QCryptographicHash::Sha256:
+        return QLatin1String("SHA256");
+    default:
+        Q_ASSERT(algo == QCryptographicHash::Sha1);
+        return QLatin1String("SHA1");
+    }
+}
+
+/*!
+    \internal
+
+    Sets \a algo to the repository checksum algorithm called \a name, case-insensitive.
+    Returns \c false if \a name is not a supported algorithm.
+*/
+bool QInstaller::checksumAlgorithmFromName(const QString &name, QCryptographicHash::Algorithm *algo)
+{
+    Q_ASSERT(algo);
+    if (name.compare(QLatin1String("sha1"), Qt::CaseInsensitive) == 0)
+        *algo = QCryptographicHash::Sha1;
+    else if (name.compare(QLatin1String("sha256"), Qt::CaseInsensitive) == 0)
+        *algo = QCryptographicHash::Sha256;
+    else
+        return false;
+    return true;
+}
+
+/*!
+    \internal
+
+    Returns the algorithm of the hex encoded \a checksum, detected by its length.
+*/
+QCryptographicHash::Algorithm QInstaller::checksumAlgorithmForHex(const QByteArray &checksum)
+{
+    return checksum.trimmed().size() == 64 ? QCryptographicHash::Sha256 : QCryptographicHash::Sha1;
+}
+
 /*!
     \internal
 */
@@ -53,6 +53,11 @@ namespace QInstaller {
     QByteArray INSTALLER_EXPORT calculateHash(QIODevice *device, QCryptographicHash::Algorithm algo);
     QByteArray INSTALLER_EXPORT calculateHash(const QString &path, QCryptographicHash::Algorithm algo);
 
+    QString INSTALLER_EXPORT checksumName(QCryptographicHash::Algorithm algo);
+    bool INSTALLER_EXPORT checksumAlgorithmFromName(const QString &name,
+        QCryptographicHash::Algorithm *algo);
+    QCryptographicHash::Algorithm INSTALLER_EXPORT checksumAlgorithmForHex(const QByteArray &checksum);
+
     QString INSTALLER_EXPORT replaceVariables(const QHash<QString,QString> &vars, const QString &str);
     QString INSTALLER_EXPORT replaceWindowsEnvironmentVariables(const QString &str);
     QStringList INSTALLER_EXPORT parseCommandLineArgs(int argc, char **argv);
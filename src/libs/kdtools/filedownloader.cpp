@@ -189,7 +189,8 @@ static double calcProgress(qint64 done, qint64 total)
 struct KDUpdater::FileDownloader::Private
 {
     Private()
-        : m_hash(QCryptographicHash::Sha1)
+        : m_hashAlgorithm(QCryptographicHash::Sha1)
+        , m_hash(new QCryptographicHash(QCryptographicHash::Sha1))
         , m_assumedSha1Sum("")
         , autoRemove(true)
         , followRedirect(false)
@@ -218,7 +219,8 @@ struct KDUpdater::FileDownloader::Private
     QUrl url;
     QString scheme;
 
-    QCryptographicHash m_hash;
+    QCryptographicHash::Algorithm m_hashAlgorithm;
+    QScopedPointer<QCryptographicHash> m_hash;
     QByteArray m_assumedSha1Sum;
 
     QString errorString;
@@ -277,11 +279,43 @@ QUrl KDUpdater::FileDownloader::url() const
 }
 
 /*!
-    Returns the SHA-1 checksum of the downloaded file.
+    Returns the SHA-1 checksum of the downloaded file. Returns an empty byte array if
+    another algorithm was set with setCheckSumAlgorithm(), use checkSum() then.
+
+    \sa checkSum()
 */
 QByteArray KDUpdater::FileDownloader::sha1Sum() const
 {
-    return d->m_hash.result();
+    if (d->m_hashAlgorithm != QCryptographicHash::Sha1)
+        return QByteArray();
+    return checkSum();
+}
+
+/*!
+    Returns the checksum of the downloaded file, calculated with checkSumAlgorithm().
+*/
+QByteArray KDUpdater::FileDownloader::checkSum() const
+{
+    return d->m_hash->result();
+}
+
+/*!
+    Returns the algorithm used to calculate the checksum of the downloaded file.
+    The default is QCryptographicHash::Sha1.
+*/
+QCryptographicHash::Algorithm KDUpdater::FileDownloader::checkSumAlgorithm() const
+{
+    return d->m_hashAlgorithm;
+}
+
+/*!
+    Sets the \a algorithm used to calculate the checksum of the downloaded file. Must be
+    called before the download starts.
+*/
+void KDUpdater::FileDownloader::setCheckSumAlgorithm(QCryptographicHash::Algorithm algorithm)
+{
+    d->m_hashAlgorithm = algorithm;
+    d->m_hash.reset(new QCryptographicHash(algorithm));
 }
 
 /*!
@@ -653,7 +687,7 @@ void KDUpdater::FileDownloader::emitEstimatedDownloadTime()
 */
 void KDUpdater::FileDownloader::addCheckSumData(const QByteArray &data)
 {
-    d->m_hash.addData(data);
+    d->m_hash->addData(data);
 }
 
 /*!
@@ -661,15 +695,15 @@ void KDUpdater::FileDownloader::addCheckSumData(const QByteArray &data)
 */
 void KDUpdater::FileDownloader::addCheckSumData(const char *data, int length)
 {
-    d->m_hash.addData(data, length);
+    d->m_hash->addData(data, length);
 }
 
 /*!
-    Resets SHA-1 checksum data of the downloaded file.
+    Resets checksum data of the downloaded file.
 */
 void KDUpdater::FileDownloader::resetCheckSumData()
 {
-    d->m_hash.reset();
+    d->m_hash->reset();
 }
 
 /*!
@@ -1413,7 +1447,7 @@ void KDUpdater::HttpDownloader::httpReqFinished()
         if (url.isValid() && QInstaller::lcServer().isDebugEnabled()
                 && LoggingHandler::instance().verboseLevel() == LoggingHandler::Detailed) {
             const QFileInfo fi(d->http->url().toString());
-            if (fi.suffix() != QLatin1String("sha1")){
+            if (fi.suffix() != QLatin1String("sha1") && fi.suffix() != QLatin1String("sha256")) {
                 const QString hostName = url.host();
                 QHostInfo info = QHostInfo::fromName(hostName);
                 QStringList hostAddresses;
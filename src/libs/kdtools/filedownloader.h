@@ -31,6 +31,7 @@
 
 #include "kdtoolsglobal.h"
 
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
 
@@ -55,6 +56,10 @@ public:
     void setUrl(const QUrl &url);
 
     QByteArray sha1Sum() const;
+    QByteArray checkSum() const;
+
+    QCryptographicHash::Algorithm checkSumAlgorithm() const;
+    void setCheckSumAlgorithm(QCryptographicHash::Algorithm algorithm);
 
     QByteArray assumedSha1Sum() const;
     void setAssumedSha1Sum(const QByteArray &sha1);
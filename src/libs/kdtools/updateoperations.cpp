@@ -31,6 +31,7 @@
 #include "fileutils.h"
 #include "constants.h"
 #include "packagemanagercore.h"
+#include "remotefileoperations.h"
 
 #include <QDir>
 #include <QFile>
@@ -163,8 +164,7 @@ bool CopyOperation::performOperation()
     QString source = sourcePath();
     QString destination = destinationPath();
 
-    QFile sourceFile(source);
-    if (!sourceFile.exists()) {
+    if (!QFile::exists(source)) {
         setError(UserDefinedError);
         setErrorString(tr("Cannot copy a non-existent file: %1").arg(QDir::toNativeSeparators(source)));
         return false;
@@ -181,12 +181,13 @@ bool CopyOperation::performOperation()
         }
     }
 
-    const bool copied = sourceFile.copy(destination);
+    QInstaller::RemoteFileOperations operations;
+    const bool copied = operations.copyFile(source, destination);
     if (!copied) {
         setError(UserDefinedError);
         setErrorString(tr("Cannot copy file \"%1\" to \"%2\": %3").arg(
                            QDir::toNativeSeparators(source), QDir::toNativeSeparators(destination),
-                           sourceFile.errorString()));
+                           operations.errorString()));
     }
     return copied;
 }
@@ -292,28 +293,33 @@ bool MoveOperation::performOperation()
         return false;
 
     const QStringList args = arguments();
+    const QString source = args.at(0);
     const QString dest = args.at(1);
-    // If destination file exists, then we cannot use QFile::copy() because it does not overwrite an existing
-    // file. So we remove the destination file.
-    if (QFile::exists(dest)) {
-        QFile file(dest);
-        if (!file.remove(dest)) {
+    // Renames the file if possible and replaces an existing destination file only
+    // once the source was moved.
+    QInstaller::RemoteFileOperations operations;
+    if (operations.move(source, dest))
+        return true;
+
+    // The source might not be removable right now, for example because it is locked by a
+    // running process on Windows. Copy it and remove it once possible.
+    if (QFile::exists(source)) {
+        QFile destinationFile(dest);
+        if (destinationFile.exists() && !destinationFile.remove()) {
             setError(UserDefinedError);
             setErrorString(tr("Cannot remove file \"%1\": %2").arg(
-                               QDir::toNativeSeparators(dest), file.errorString()));
+                               QDir::toNativeSeparators(dest), destinationFile.errorString()));
             return false;
         }
+        if (operations.copyFile(source, dest))
+            return deleteFileNowOrLater(source);
     }
 
-    // Copy source to destination.
-    QFile file(args.at(0));
-    if (!file.copy(dest)) {
-        setError(UserDefinedError);
-        setErrorString(tr("Cannot copy file \"%1\" to \"%2\": %3").arg(QDir::toNativeSeparators(file.fileName()),
-                                                                 QDir::toNativeSeparators(dest), file.errorString()));
-        return false;
-    }
-    return deleteFileNowOrLater(file.fileName());
+    setError(UserDefinedError);
+    setErrorString(tr("Cannot move file \"%1\" to \"%2\": %3").arg(
+                       QDir::toNativeSeparators(source), QDir::toNativeSeparators(dest),
+                       operations.errorString()));
+    return false;
 }
 
 bool MoveOperation::undoOperation()
@@ -59,12 +59,6 @@ public:
         Q_UNUSED(dirPath)
         return true;
     };
-    bool extract(const QString &dirPath, const quint64 totalFiles)
-    {
-        Q_UNUSED(dirPath)
-        Q_UNUSED(totalFiles)
-        return true;
-    };
     bool create(const QStringList &data)
     {
         Q_UNUSED(data)
@@ -91,7 +85,7 @@ private slots:
             << "Lib7z" << "myfile.7z" << (QStringList() << "7z");
 #ifdef IFW_LIBARCHIVE
         QTest::newRow("LibArchive")
-            << "LibArchive" << "myfile.zip" << (QStringList() << "tar.gz" << "tar.bz2" << "tar.xz" << "zip");
+            << "LibArchive" << "myfile.zip" << (QStringList() << "tar.gz" << "tar.bz2" << "tar.xz" << "tar.zst" << "zip");
 #endif
     }
 
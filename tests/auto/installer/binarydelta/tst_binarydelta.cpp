@@ -0,0 +1,203 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <binarydelta.h>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <limits>
+
+using namespace QInstaller;
+
+class tst_binarydelta : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray randomData(int size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = char(generator.bounded(256));
+        return data;
+    }
+
+private slots:
+    void testDeltaRoundTrip_data()
+    {
+        const QByteArray source = randomData(256 * 1024, 1);
+        QByteArray changed = source;
+        for (int i = 0; i < 16; ++i)
+            changed[1000 + i * 9973] = char(changed.at(1000 + i * 9973) ^ 0x5a);
+
+        QTest::addColumn<QByteArray>("source");
+        QTest::addColumn<QByteArray>("target");
+        QTest::addColumn<bool>("small");
+        QTest::newRow("identical") << source << source << true;
+        QTest::newRow("changed bytes") << source << changed << true;
+        QTest::newRow("inserted") << source << (source.left(5000) + randomData(100, 2)
+            + source.mid(5000)) << true;
+        QTest::newRow("moved") << source << (source.mid(128 * 1024) + source.left(128 * 1024)) << true;
+        QTest::newRow("unrelated") << source << randomData(1000, 3) << false;
+        QTest::newRow("empty source") << QByteArray() << source << false;
+        QTest::newRow("empty target") << source << QByteArray() << true;
+    }
+
+    void testDeltaRoundTrip()
+    {
+        QFETCH(QByteArray, source);
+        QFETCH(QByteArray, target);
+        QFETCH(bool, small);
+
+        const QByteArray delta = BinaryDelta::create(source, target);
+        if (small)
+            QVERIFY(delta.size() < 1024);
+
+        QByteArray result;
+        QVERIFY(BinaryDelta::apply(source, delta, &result));
+        QCOMPARE(result, target);
+    }
+
+    void testInvalidDelta()
+    {
+        const QByteArray source = randomData(4096, 4);
+        const QByteArray delta = BinaryDelta::create(source, source.mid(100));
+
+        QByteArray result;
+        QVERIFY(!BinaryDelta::apply(QByteArray(), delta, &result));
+        QVERIFY(!BinaryDelta::apply(source, delta.left(delta.size() - 1), &result));
+        QVERIFY(!BinaryDelta::apply(source, QByteArray("invalid"), &result));
+        QVERIFY(result.isEmpty());
+    }
+
+    void testCopyOutOfRange_data()
+    {
+        QTest::addColumn<qint64>("offset");
+        QTest::addColumn<qint64>("length");
+        QTest::newRow("offset") << qint64(4097) << qint64(0);
+        QTest::newRow("length") << qint64(4000) << qint64(97);
+        QTest::newRow("overflow") << std::numeric_limits<qint64>::max() << qint64(4);
+        QTest::newRow("overflow length") << qint64(4) << std::numeric_limits<qint64>::max();
+    }
+
+    void testCopyOutOfRange()
+    {
+        QFETCH(qint64, offset);
+        QFETCH(qint64, length);
+
+        QByteArray delta;
+        QDataStream out(&delta, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << QByteArray("IFWDELTA") << qint64(4) << quint8(1) << offset << length;
+
+        QByteArray result;
+        QVERIFY(!BinaryDelta::apply(randomData(4096, 6), delta, &result));
+        QVERIFY(result.isEmpty());
+    }
+
+    void testPatchRoundTrip()
+    {
+        DeltaPatch patch;
+        DeltaPatch::Entry directory;
+        directory.path = QLatin1String("data");
+        directory.isDirectory = true;
+        directory.permissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner;
+        patch.addEntry(directory);
+
+        DeltaPatch::Entry file;
+        file.path = QLatin1String("data/file.bin");
+        file.permissions = QFile::ReadOwner | QFile::WriteOwner;
+        file.hash = "0123456789abcdef0123456789abcdef01234567";
+        file.sourceHash = "89abcdef0123456789abcdef0123456789abcdef";
+        file.data = qCompress(randomData(100, 5));
+        patch.addEntry(file);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        patch.write(&buffer);
+        buffer.seek(0);
+
+        DeltaPatch read;
+        QVERIFY(read.read(&buffer));
+        QCOMPARE(read.entries().count(), 2);
+        QCOMPARE(read.entries().at(0).path, directory.path);
+        QVERIFY(read.entries().at(0).isDirectory);
+        QCOMPARE(read.entries().at(0).permissions, directory.permissions);
+        QCOMPARE(read.entries().at(1).path, file.path);
+        QVERIFY(!read.entries().at(1).isDirectory);
+        QCOMPARE(read.entries().at(1).hash, file.hash);
+        QCOMPARE(read.entries().at(1).sourceHash, file.sourceHash);
+        QCOMPARE(read.entries().at(1).data, file.data);
+
+        buffer.setData(buffer.data().left(buffer.data().size() - 10));
+        buffer.seek(0);
+        QVERIFY(!read.read(&buffer));
+        QCOMPARE(read.errorString(), QString("Unexpected end of patch."));
+        QVERIFY(read.entries().isEmpty());
+    }
+
+    void testInvalidPatchPath_data()
+    {
+        QTest::addColumn<QString>("path");
+        QTest::newRow("absolute") << "/etc/file.bin";
+        QTest::newRow("backslash absolute") << "\\server\\file.bin";
+        QTest::newRow("drive") << "C:/file.bin";
+        QTest::newRow("parent directory") << "data/../../file.bin";
+        QTest::newRow("backslash parent directory") << "data\\..\\..\\file.bin";
+    }
+
+    void testInvalidPatchPath()
+    {
+        QFETCH(QString, path);
+
+        DeltaPatch patch;
+        DeltaPatch::Entry file;
+        file.path = path;
+        file.hash = "0123456789abcdef0123456789abcdef01234567";
+        file.data = qCompress(randomData(100, 7));
+        patch.addEntry(file);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        patch.write(&buffer);
+        buffer.seek(0);
+
+        DeltaPatch read;
+        QVERIFY(!read.read(&buffer));
+        QCOMPARE(read.errorString(), QString("Invalid path \"%1\".").arg(path));
+        QVERIFY(read.entries().isEmpty());
+    }
+};
+
+QTEST_MAIN(tst_binarydelta)
+
+#include "tst_binarydelta.moc"
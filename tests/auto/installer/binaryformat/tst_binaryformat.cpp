@@ -28,12 +28,14 @@
 
 #include <binarycontent.h>
 #include <binaryformat.h>
+#include <binaryformatenginehandler.h>
 #include <errors.h>
 #include <fileio.h>
 #include <updateoperation.h>
 
 #include <QTest>
 #include <QTemporaryFile>
+#include <QtConcurrentRun>
 
 static const qint64 scTinySize = 72704LL;
 static const qint64 scSmallSize = 524288LL;
@@ -134,6 +136,77 @@ private slots:
         }
     }
 
+    void readAndCopyResourceSegment()
+    {
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::blockingWrite(&file, QByteArray(scTinySize, '1'));
+        QInstaller::blockingWrite(&file, QByteArray(scSmallSize, '2'));
+        QInstaller::blockingWrite(&file, QByteArray(scTinySize, '3'));
+        file.close();
+
+        Resource resource(file.fileName(), Range<qint64>::fromStartAndLength(scTinySize, scSmallSize));
+        QVERIFY(resource.open());
+        QVERIFY(resource.isMapped());
+        QCOMPARE(QByteArray::fromRawData(reinterpret_cast<const char *>(resource.mappedData()),
+            scSmallSize), QByteArray(scSmallSize, '2'));
+
+        QVERIFY(resource.seek(scSmallSize - 4));
+        QCOMPARE(resource.readAll(), QByteArray(4, '2'));
+
+        QTemporaryFile target;
+        QInstaller::openForWrite(&target);
+        QInstaller::blockingWrite(&target, QByteArray("header"));
+        QVERIFY(resource.seek(0));
+        resource.copyData(&target);
+        QInstaller::blockingWrite(&target, QByteArray("footer"));
+        target.close();
+        resource.close();
+        QVERIFY(!resource.isMapped());
+
+        QInstaller::openForRead(&target);
+        QCOMPARE(target.readAll(), QByteArray("header") + QByteArray(scSmallSize, '2')
+            + QByteArray("footer"));
+    }
+
+    void readEngineResourcesConcurrently()
+    {
+        QTemporaryFile data;
+        QInstaller::openForWrite(&data);
+        for (int i = 0; i < 64; ++i)
+            QInstaller::blockingWrite(&data, QByteArray(1024, char('a' + i % 26)));
+        data.close();
+
+        BinaryFormatEngineHandler::instance()->registerResource(
+            QLatin1String("installer://concurrent/data.7z"), data.fileName());
+
+        // two files on the same resource do not share the read position
+        QFile first(QLatin1String("installer://concurrent/data.7z"));
+        QFile second(QLatin1String("installer://concurrent/data.7z"));
+        QVERIFY(first.open(QIODevice::ReadOnly));
+        QVERIFY(second.open(QIODevice::ReadOnly));
+        QCOMPARE(first.read(1024), QByteArray(1024, 'a'));
+        QCOMPARE(second.read(2048), QByteArray(1024, 'a') + QByteArray(1024, 'b'));
+        QCOMPARE(first.read(1024), QByteArray(1024, 'b'));
+        first.close();
+        QCOMPARE(second.read(1024), QByteArray(1024, 'c'));
+        second.close();
+
+        QList<QFuture<QByteArray> > futures;
+        for (int i = 0; i < 4; ++i) {
+            futures.append(QtConcurrent::run([]() {
+                QFile file(QLatin1String("installer://concurrent/data.7z"));
+                return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+            }));
+        }
+        foreach (const QFuture<QByteArray> &future, futures) {
+            const QByteArray content = future.result();
+            QCOMPARE(content.size(), 64 * 1024);
+            QCOMPARE(content.mid(63 * 1024), QByteArray(1024, char('a' + 63 % 26)));
+        }
+        BinaryFormatEngineHandler::instance()->clear();
+    }
+
     void writeBinaryContent()
     {
         QTemporaryFile binary;
@@ -33,6 +33,7 @@
 #include <qsettingswrapper.h>
 #include <remoteclient.h>
 #include <remotefileengine.h>
+#include <remotefileoperations.h>
 #include <remoteserver.h>
 #include <fileutils.h>
 
@@ -44,11 +45,18 @@
 #include <QSettings>
 #include <QLocalSocket>
 #include <QTest>
+#include <QSemaphore>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QThread>
 #include <QUuid>
 #include <QLocalServer>
 
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
 using namespace QInstaller;
 
 class tst_ClientServer : public QObject
@@ -144,6 +152,26 @@ private slots:
             QCOMPARE(cmd, QByteArray("say"));
             QCOMPARE(data, QByteArray("hello"));
         }
+
+        // now try reading a packet that arrives in pieces, including a split size prefix ...
+        {
+            QByteArray partialPackage;
+            QBuffer device(&partialPackage);
+            device.open(QBuffer::ReadOnly);
+
+            QByteArray cmd;
+            QByteArray data;
+            for (int i = 0; i < validPackage.size(); ++i) {
+                QCOMPARE(QInstaller::receivePacket(&device, &cmd, &data), false);
+                QCOMPARE(device.pos(), 0);
+                device.buffer().append(validPackage.at(i));
+            }
+
+            QCOMPARE(QInstaller::receivePacket(&device, &cmd, &data), true);
+            QCOMPARE(device.pos(), device.size());
+            QCOMPARE(cmd, QByteArray("say"));
+            QCOMPARE(data, QByteArray("hello"));
+        }
     }
 
     void localSocket()
@@ -520,6 +548,138 @@ private slots:
         QCOMPARE(file.atEnd(), true);
     }
 
+    void testRemoteFileOperations()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        const QString sourceDir = QDir::tempPath() + "/tst_remotefileoperations/source";
+        const QString targetDir = QDir::tempPath() + "/tst_remotefileoperations/target";
+        const QString movedDir = QDir::tempPath() + "/tst_remotefileoperations/moved";
+        const QByteArray content(3 * 1024 * 1024 + 17, 'x');
+        QVERIFY(QDir().mkpath(sourceDir + "/subdir"));
+        {
+            QFile file(sourceDir + "/subdir/file.bin");
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(content), qint64(content.size()));
+        }
+
+        RemoteFileOperations operations;
+        QSignalSpy progressSpy(&operations, &RemoteFileOperations::progressChanged);
+        QCOMPARE(operations.isConnectedToServer(), false);
+
+        QVERIFY2(operations.copyDirectory(sourceDir, targetDir), qPrintable(operations.errorString()));
+        QCOMPARE(operations.isConnectedToServer(), true);
+        VerifyInstaller::verifyFileContent(targetDir + "/subdir/file.bin", content);
+        QVERIFY(progressSpy.count() > 0);
+        QCOMPARE(progressSpy.last().at(0).value<quint64>(), quint64(content.size()));
+        QCOMPARE(progressSpy.last().at(1).value<quint64>(), quint64(content.size()));
+
+        QCOMPARE(operations.hashFile(targetDir + "/subdir/file.bin", QCryptographicHash::Sha1),
+            QCryptographicHash::hash(content, QCryptographicHash::Sha1));
+
+        QVERIFY(operations.setPermissions(targetDir, QFileDevice::ReadOwner | QFileDevice::WriteOwner
+            | QFileDevice::ExeOwner));
+        QVERIFY(QFileInfo(targetDir + "/subdir/file.bin").permission(QFileDevice::ExeOwner));
+
+        QVERIFY(operations.move(targetDir, movedDir));
+        QVERIFY(!QFileInfo::exists(targetDir));
+        VerifyInstaller::verifyFileContent(movedDir + "/subdir/file.bin", content);
+
+        QVERIFY(operations.copyFile(movedDir + "/subdir/file.bin", movedDir + "/copy.bin"));
+        VerifyInstaller::verifyFileContent(movedDir + "/copy.bin", content);
+
+        QVERIFY(!operations.copyFile(sourceDir + "/missing.bin", movedDir + "/missing.bin"));
+        QVERIFY(!operations.errorString().isEmpty());
+
+        // a failed move keeps the existing target
+        QVERIFY(!operations.move(sourceDir + "/missing.bin", movedDir + "/copy.bin"));
+        VerifyInstaller::verifyFileContent(movedDir + "/copy.bin", content);
+
+        // the directory itself loses the permission to list its entries last
+        QVERIFY2(operations.setPermissions(movedDir, QFileDevice::ReadOwner
+            | QFileDevice::WriteOwner), qPrintable(operations.errorString()));
+        QVERIFY(QFile::setPermissions(movedDir, QFileDevice::ReadOwner | QFileDevice::WriteOwner
+            | QFileDevice::ExeOwner));
+        QVERIFY(!QFileInfo(movedDir + "/copy.bin").permission(QFileDevice::ExeOwner));
+        QVERIFY(QFile::setPermissions(movedDir + "/subdir", QFileDevice::ReadOwner
+            | QFileDevice::WriteOwner | QFileDevice::ExeOwner));
+
+        QVERIFY(operations.removeDirectory(movedDir));
+        QVERIFY(!QFileInfo::exists(movedDir));
+
+        removeDirectory(QDir::tempPath() + "/tst_remotefileoperations");
+    }
+
+    void testConcurrentFileOperations()
+    {
+#ifndef Q_OS_UNIX
+        QSKIP("Test requires named pipes");
+#else
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString pipe = dir.path() + "/pipe";
+        QCOMPARE(::mkfifo(QFile::encodeName(pipe).constData(), 0600), 0);
+        const QByteArray content("written once the second client was served");
+        {
+            QFile file(dir.path() + "/file.txt");
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(content), qint64(content.size()));
+        }
+
+        // the first copy blocks a thread of the server's worker pool until the pipe is written
+        bool copied = false;
+        QString errorString;
+        QSemaphore running;
+        QAtomicInt status(FileOperationsWorker::Idle);
+        QScopedPointer<QThread> thread(QThread::create([&]() {
+            RemoteFileOperations operations;
+            bool reported = false;
+            connect(&operations, &RemoteFileOperations::progressChanged, [&]() {
+                status.storeRelease(operations.status());
+                if (!reported && operations.status() == FileOperationsWorker::Running) {
+                    reported = true;
+                    running.release();
+                }
+            });
+            copied = operations.copyFile(pipe, dir.path() + "/copy.txt");
+            errorString = operations.errorString();
+        }));
+        thread->start();
+        QVERIFY(running.tryAcquire(1, 30000));
+
+        // another client is served while the server still reports the first copy as running
+        RemoteFileOperations operations;
+        QCOMPARE(operations.hashFile(dir.path() + "/file.txt", QCryptographicHash::Sha1),
+            QCryptographicHash::hash(content, QCryptographicHash::Sha1));
+        QVERIFY(operations.isConnectedToServer());
+        QCOMPARE(status.loadAcquire(), int(FileOperationsWorker::Running));
+        QVERIFY(!thread->isFinished());
+
+        {
+            QFile file(pipe);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(content), qint64(content.size()));
+        }
+        QVERIFY(thread->wait(30000));
+        QVERIFY2(copied, qPrintable(errorString));
+        VerifyInstaller::verifyFileContent(dir.path() + "/copy.txt", content);
+#endif
+    }
+
     void testArchiveWrapper_data()
     {
         QTest::addColumn<QString>("suffix");
@@ -527,6 +687,7 @@ private slots:
         QTest::newRow("gzip compressed tar archive") << ".tar.gz";
         QTest::newRow("bzip2 compressed tar archive") << ".tar.bz2";
         QTest::newRow("xz compressed tar archive") << ".tar.xz";
+        QTest::newRow("zstd compressed tar archive") << ".tar.zst";
     }
 
     void testArchiveWrapper()
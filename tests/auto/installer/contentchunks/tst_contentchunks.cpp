@@ -0,0 +1,195 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <contentchunks.h>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_contentchunks : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray randomData(int size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = char(generator.bounded(256));
+        return data;
+    }
+
+    QVector<ContentChunk> chunk(const QByteArray &data, QByteArray *contentHash = nullptr)
+    {
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        return ContentChunker::chunk(&buffer, contentHash);
+    }
+
+private slots:
+    void testChunkSizes()
+    {
+        const QByteArray data = randomData(12 * 1024 * 1024, 1);
+        QByteArray contentHash;
+        const QVector<ContentChunk> chunks = chunk(data, &contentHash);
+        QVERIFY(chunks.count() > 1);
+        QCOMPARE(contentHash, QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+
+        qint64 offset = 0;
+        for (int i = 0; i < chunks.count(); ++i) {
+            const ContentChunk &chunk = chunks.at(i);
+            QCOMPARE(chunk.offset, offset);
+            QVERIFY(chunk.size <= ContentChunker::MaximumChunkSize);
+            if (i < chunks.count() - 1)
+                QVERIFY(chunk.size > ContentChunker::MinimumChunkSize);
+            QCOMPARE(chunk.hash, QCryptographicHash::hash(data.mid(chunk.offset, chunk.size),
+                QCryptographicHash::Sha1).toHex());
+            offset += chunk.size;
+        }
+        QCOMPARE(offset, qint64(data.size()));
+
+        QVERIFY(chunk(QByteArray()).isEmpty());
+        QCOMPARE(chunk(QByteArray("small")).count(), 1);
+    }
+
+    void testInsertionKeepsChunks()
+    {
+        const QByteArray data = randomData(12 * 1024 * 1024, 2);
+        QByteArray changed = data;
+        changed.insert(6 * 1024 * 1024, QByteArray("inserted in the middle"));
+
+        QSet<QByteArray> hashes;
+        foreach (const ContentChunk &chunk, chunk(data))
+            hashes.insert(chunk.hash);
+
+        // only the chunks around the insertion change
+        const QVector<ContentChunk> changedChunks = chunk(changed);
+        int newChunks = 0;
+        foreach (const ContentChunk &chunk, changedChunks)
+            newChunks += hashes.contains(chunk.hash) ? 0 : 1;
+        QVERIFY(newChunks >= 1);
+        QVERIFY(newChunks <= 3);
+    }
+
+    void testManifestRoundTrip()
+    {
+        ChunkManifest manifest;
+        ChunkManifest::Entry directory;
+        directory.path = QLatin1String("bin");
+        directory.isDirectory = true;
+        directory.permissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner;
+        manifest.addEntry(directory);
+
+        const QByteArray data = randomData(1024 * 1024, 3);
+        ChunkManifest::Entry file;
+        file.path = QLatin1String("bin/tool");
+        file.permissions = QFile::ReadOwner | QFile::ExeOwner;
+        file.size = data.size();
+        file.chunks = chunk(data, &file.hash);
+        manifest.addEntry(file);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        manifest.write(&buffer);
+        buffer.seek(0);
+
+        ChunkManifest read;
+        QVERIFY(read.read(&buffer));
+        const QVector<ChunkManifest::Entry> entries = read.entries();
+        QCOMPARE(entries.count(), 2);
+        QVERIFY(entries.at(0).isDirectory);
+        QCOMPARE(entries.at(0).path, directory.path);
+        QCOMPARE(entries.at(0).permissions, directory.permissions);
+        QVERIFY(!entries.at(1).isDirectory);
+        QCOMPARE(entries.at(1).path, file.path);
+        QCOMPARE(entries.at(1).size, file.size);
+        QCOMPARE(entries.at(1).hash, file.hash);
+        QCOMPARE(entries.at(1).chunks.count(), file.chunks.count());
+        for (int i = 0; i < file.chunks.count(); ++i) {
+            QCOMPARE(entries.at(1).chunks.at(i).hash, file.chunks.at(i).hash);
+            QCOMPARE(entries.at(1).chunks.at(i).offset, file.chunks.at(i).offset);
+        }
+    }
+
+    void testInvalidManifest_data()
+    {
+        const QByteArray hash = QCryptographicHash::hash("content", QCryptographicHash::Sha1).toHex();
+        const QByteArray file = "<ChunkManifest><File path=\"%1\" size=\"%2\" sha1=\"%3\">"
+            "<Chunk size=\"5\">%4</Chunk></File></ChunkManifest>";
+
+        QTest::addColumn<QByteArray>("manifest");
+        QTest::addColumn<QString>("error");
+
+        QTest::newRow("size") << QByteArray(file).replace("%1", "a").replace("%2", "10")
+            .replace("%3", hash).replace("%4", hash)
+            << QString("The chunks of \"a\" do not match its size.");
+        QTest::newRow("chunk hash") << QByteArray(file).replace("%1", "a").replace("%2", "5")
+            .replace("%3", hash).replace("%4", "../../a")
+            << QString("Invalid chunk hash in \"a\".");
+        QTest::newRow("file hash") << QByteArray(file).replace("%1", "a").replace("%2", "5")
+            .replace("%3", hash.toUpper()).replace("%4", hash)
+            << QString("Invalid hash of \"a\".");
+        QTest::newRow("absolute path") << QByteArray(file).replace("%1", "/etc/a").replace("%2", "5")
+            .replace("%3", hash).replace("%4", hash)
+            << QString("Invalid path \"/etc/a\".");
+        QTest::newRow("drive path") << QByteArray("<ChunkManifest><Directory path=\"C:\\a\"/>"
+            "</ChunkManifest>") << QString("Invalid path \"C:\\a\".");
+        QTest::newRow("parent directory") << QByteArray("<ChunkManifest><Directory path=\"a\"/>"
+            "<Directory path=\"a/../../b\"/></ChunkManifest>")
+            << QString("Invalid path \"a/../../b\".");
+        QTest::newRow("parent directory backslash") << QByteArray(file).replace("%1", "a\\..\\..\\b")
+            .replace("%2", "5").replace("%3", hash).replace("%4", hash)
+            << QString("Invalid path \"a\\..\\..\\b\".");
+    }
+
+    void testInvalidManifest()
+    {
+        QFETCH(QByteArray, manifest);
+        QFETCH(QString, error);
+
+        QBuffer buffer;
+        buffer.setData(manifest);
+        buffer.open(QIODevice::ReadOnly);
+
+        ChunkManifest chunkManifest;
+        QVERIFY(!chunkManifest.read(&buffer));
+        QVERIFY(chunkManifest.entries().isEmpty());
+        QCOMPARE(chunkManifest.errorString(), error);
+    }
+};
+
+QTEST_MAIN(tst_contentchunks)
+
+#include "tst_contentchunks.moc"
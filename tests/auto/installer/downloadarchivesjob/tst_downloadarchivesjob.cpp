@@ -0,0 +1,503 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "../shared/packagemanager.h"
+
+#include <archivefactory.h>
+#include <binarydelta.h>
+#include <binaryformatenginehandler.h>
+#include <component.h>
+#include <constants.h>
+#include <contentchunks.h>
+#include <downloadarchivesjob.h>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_DownloadArchivesJob : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray randomData(int size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = char(generator.bounded(256));
+        return data;
+    }
+
+    void writeFile(const QString &path, const QByteArray &data)
+    {
+        QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), qint64(data.size()));
+    }
+
+    QByteArray readFile(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+    void createArchive(const QString &archivePath, const QString &contentDir)
+    {
+        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(archivePath));
+        QVERIFY(archive);
+        QVERIFY(archive->open(QIODevice::WriteOnly));
+        QVERIFY(archive->create(QStringList() << contentDir + "/data"));
+        archive->close();
+    }
+
+    /*
+        Creates a repository with component A 2.0.0 in \a root, and the files of the
+        installed version 1.0.0 of A. The chunk manifest of the archive lists
+        \a extraEntries in addition to the files of the new version, and only the chunks that
+        cannot be found in the installed files are published. The archive itself is only
+        published if \a withArchive is \c true.
+    */
+    void createRepository(const QString &root, const QVector<ChunkManifest::Entry> &extraEntries,
+        bool withArchive)
+    {
+        m_repository = root + "/repository";
+        m_installedDir = root + "/installed";
+        m_contentDir = root + "/content";
+
+        const QByteArray installedData = randomData(3 * 1024 * 1024, 1);
+        QByteArray data = installedData;
+        data.insert(data.size() / 2, QByteArray("inserted in the middle"));
+
+        m_installedFiles = QStringList() << m_installedDir + "/data/big.bin"
+            << m_installedDir + "/data/same.txt";
+        writeFile(m_installedFiles.at(0), installedData);
+        writeFile(m_installedFiles.at(1), "unchanged");
+
+        m_content.clear();
+        m_content.insert("data/big.bin", data);
+        m_content.insert("data/same.txt", "unchanged");
+        m_content.insert("data/new.txt", "added in 2.0.0");
+
+        QSet<QByteArray> installedChunks;
+        foreach (const QString &path, m_installedFiles) {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            foreach (const ContentChunk &chunk, ContentChunker::chunk(&file))
+                installedChunks.insert(chunk.hash);
+        }
+
+        ChunkManifest manifest;
+        ChunkManifest::Entry directory;
+        directory.path = "data";
+        directory.isDirectory = true;
+        directory.permissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner;
+        manifest.addEntry(directory);
+
+        int publishedChunks = 0;
+        for (auto it = m_content.constBegin(); it != m_content.constEnd(); ++it) {
+            writeFile(m_contentDir + '/' + it.key(), it.value());
+
+            ChunkManifest::Entry entry;
+            entry.path = it.key();
+            entry.permissions = QFile::ReadOwner | QFile::WriteOwner;
+            entry.size = it.value().size();
+            QBuffer buffer;
+            buffer.setData(it.value());
+            buffer.open(QIODevice::ReadOnly);
+            entry.chunks = ContentChunker::chunk(&buffer, &entry.hash);
+            foreach (const ContentChunk &chunk, entry.chunks) {
+                if (installedChunks.contains(chunk.hash))
+                    continue;
+                writeFile(m_repository + '/' + ContentChunker::chunkPath(chunk.hash),
+                    qCompress(it.value().mid(chunk.offset, chunk.size)));
+                ++publishedChunks;
+            }
+            manifest.addEntry(entry);
+        }
+        foreach (const ChunkManifest::Entry &entry, extraEntries)
+            manifest.addEntry(entry);
+        // only the changed part of big.bin and new.txt are downloaded
+        QVERIFY(publishedChunks >= 2);
+        QVERIFY(publishedChunks <= 4);
+
+        QFile manifestFile(m_repository + "/A/2.0.0content.7z.chunks");
+        QVERIFY(manifestFile.open(QIODevice::WriteOnly));
+        manifest.write(&manifestFile);
+        manifestFile.close();
+
+        if (withArchive) {
+            const QString archivePath = m_repository + "/A/2.0.0content.7z";
+            createArchive(archivePath, m_contentDir);
+            writeFile(archivePath + ".sha1", QCryptographicHash::hash(readFile(archivePath),
+                QCryptographicHash::Sha1).toHex());
+        }
+
+        writeFile(m_repository + "/Updates.xml",
+            "<Updates>\n"
+            " <ApplicationName>{AnyApplication}</ApplicationName>\n"
+            " <ApplicationVersion>1.0.0</ApplicationVersion>\n"
+            " <Checksum>true</Checksum>\n"
+            " <PackageUpdate>\n"
+            "  <Name>A</Name>\n"
+            "  <DisplayName>A</DisplayName>\n"
+            "  <Version>2.0.0</Version>\n"
+            "  <ReleaseDate>2021-01-01</ReleaseDate>\n"
+            "  <Default>true</Default>\n"
+            "  <DownloadableArchives>content.7z</DownloadableArchives>\n"
+            "  <ChunkManifests>content.7z</ChunkManifests>\n"
+            " </PackageUpdate>\n"
+            "</Updates>\n");
+    }
+
+    /*
+        Publishes a delta patch in the repository that turns the installed files of A into
+        the content of version 2.0.0, followed by \a extraEntries. Has to be called after
+        createRepository().
+    */
+    void createDeltaPatch(const QVector<DeltaPatch::Entry> &extraEntries)
+    {
+        DeltaPatch patch;
+        DeltaPatch::Entry directory;
+        directory.path = "data";
+        directory.isDirectory = true;
+        directory.permissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner;
+        patch.addEntry(directory);
+
+        for (auto it = m_content.constBegin(); it != m_content.constEnd(); ++it) {
+            DeltaPatch::Entry entry;
+            entry.path = it.key();
+            entry.permissions = QFile::ReadOwner | QFile::WriteOwner;
+            entry.hash = QCryptographicHash::hash(it.value(), QCryptographicHash::Sha1).toHex();
+            const QString installedFile = m_installedDir + '/' + it.key();
+            if (QFileInfo::exists(installedFile)) {
+                const QByteArray source = readFile(installedFile);
+                entry.sourceHash = QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex();
+                entry.data = qCompress(BinaryDelta::create(source, it.value()));
+            } else {
+                entry.data = qCompress(it.value());
+            }
+            patch.addEntry(entry);
+        }
+        foreach (const DeltaPatch::Entry &entry, extraEntries)
+            patch.addEntry(entry);
+
+        QFile patchFile(m_repository + "/A/2.0.0content.7z.patch");
+        QVERIFY(patchFile.open(QIODevice::WriteOnly));
+        patch.write(&patchFile);
+    }
+
+    /*
+        Runs a DownloadArchivesJob for the archive of component A, rebuilding it from the
+        installed files if \a fromInstalledFiles is \c true, or patching them first if
+        \a fromDeltaPatch is \c true. Returns the path the archive was stored at.
+    */
+    QString downloadArchive(PackageManagerCore *core, bool fromInstalledFiles = true,
+        bool fromDeltaPatch = false)
+    {
+        const QString archive = "installer://A/2.0.0content.7z";
+        const Component *component = core->componentByName("A");
+        if (!component)
+            return QString();
+        BinaryFormatEngineHandler::instance()->clear();
+
+        DownloadArchivesJob job(core);
+        job.setAutoDelete(false);
+        job.setArchivesToDownload(QList<QPair<QString, QString> >() << qMakePair(archive,
+            component->repositoryUrl().toString() + "/A/2.0.0content.7z"));
+        if (fromInstalledFiles) {
+            QHash<QString, QStringList> installedFiles;
+            installedFiles.insert(archive, m_installedFiles);
+            job.setInstalledFiles(installedFiles);
+        }
+        if (fromDeltaPatch) {
+            QHash<QString, QStringList> patchedFiles;
+            patchedFiles.insert(archive, m_installedFiles);
+            job.setPatchedFiles(patchedFiles);
+        }
+        job.start();
+        job.waitForFinished();
+
+        if (job.error() != Job::NoError) {
+            qWarning() << job.errorString();
+            return QString();
+        }
+        if (job.numberOfDownloads() != 1 || !QFileInfo::exists(archive))
+            return QString();
+        return component->localTempPath() + "/A/2.0.0content.7z";
+    }
+
+    /*
+        Returns the path of the archive of component A in the archive cache \a cacheDir.
+    */
+    QString cachedArchivePath(const QString &cacheDir)
+    {
+        const QByteArray hash = readFile(m_repository + "/A/2.0.0content.7z.sha1");
+        return QString::fromLatin1("%1/sha1/%2/%3").arg(cacheDir, QString::fromLatin1(hash.left(2)),
+            QString::fromLatin1(hash));
+    }
+
+    PackageManagerCore *packageManagerWithCache(const QString &root, const QString &cacheDir)
+    {
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(root + "/target",
+            m_repository);
+        core->setTestChecksum(true);
+        core->setValue(scArchiveCacheDirectory, cacheDir);
+        return core;
+    }
+
+private slots:
+    void testRebuildFromChunks()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), false);
+
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(
+            tempDir.path() + "/target", m_repository);
+        core->setTestChecksum(true);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        const QString archivePath = downloadArchive(core);
+        QVERIFY(!archivePath.isEmpty());
+        QVERIFY(!QFileInfo::exists(archivePath + ".chunks.d"));
+
+        const QString extractDir = tempDir.path() + "/extracted";
+        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(archivePath));
+        QVERIFY(archive);
+        QVERIFY(archive->open(QIODevice::ReadOnly));
+        QVERIFY(archive->extract(extractDir));
+        archive->close();
+        for (auto it = m_content.constBegin(); it != m_content.constEnd(); ++it)
+            QCOMPARE(readFile(extractDir + '/' + it.key()), it.value());
+
+        delete core;
+    }
+
+    void testChunkManifestWithParentDirectory()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+
+        // resolves to the directory the archive is stored in
+        ChunkManifest::Entry escaping;
+        escaping.path = "data/../../../escape.txt";
+        escaping.size = 6;
+        escaping.hash = QCryptographicHash::hash("escape", QCryptographicHash::Sha1).toHex();
+        ContentChunk chunk;
+        chunk.size = escaping.size;
+        chunk.hash = escaping.hash;
+        escaping.chunks.append(chunk);
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>() << escaping, true);
+        writeFile(m_repository + '/' + ContentChunker::chunkPath(chunk.hash), qCompress("escape"));
+
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(
+            tempDir.path() + "/target", m_repository);
+        core->setTestChecksum(true);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // the manifest is rejected and the whole archive is downloaded instead
+        const QString archivePath = downloadArchive(core);
+        QVERIFY(!archivePath.isEmpty());
+        QCOMPARE(readFile(archivePath), readFile(m_repository + "/A/2.0.0content.7z"));
+        QVERIFY(!QFileInfo::exists(archivePath + ".chunks.d"));
+        QVERIFY(!QFileInfo::exists(QFileInfo(archivePath).absolutePath() + "/escape.txt"));
+
+        delete core;
+    }
+
+    void testApplyDeltaPatch()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), false);
+        createDeltaPatch(QVector<DeltaPatch::Entry>());
+
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(
+            tempDir.path() + "/target", m_repository);
+        core->setTestChecksum(true);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // only the patch is published, the archive can only come from the installed files
+        const QString archivePath = downloadArchive(core, false, true);
+        QVERIFY(!archivePath.isEmpty());
+        QVERIFY(!QFileInfo::exists(archivePath + ".patch.d"));
+
+        const QString extractDir = tempDir.path() + "/extracted";
+        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(archivePath));
+        QVERIFY(archive);
+        QVERIFY(archive->open(QIODevice::ReadOnly));
+        QVERIFY(archive->extract(extractDir));
+        archive->close();
+        for (auto it = m_content.constBegin(); it != m_content.constEnd(); ++it)
+            QCOMPARE(readFile(extractDir + '/' + it.key()), it.value());
+
+        delete core;
+    }
+
+    void testDeltaPatchOfModifiedFile()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), true);
+        createDeltaPatch(QVector<DeltaPatch::Entry>());
+        // the installed file no longer matches the source hash of the patch
+        writeFile(m_installedDir + "/data/big.bin", "modified after the installation");
+
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(
+            tempDir.path() + "/target", m_repository);
+        core->setTestChecksum(true);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // the whole archive is downloaded instead
+        const QString archivePath = downloadArchive(core, false, true);
+        QVERIFY(!archivePath.isEmpty());
+        QCOMPARE(readFile(archivePath), readFile(m_repository + "/A/2.0.0content.7z"));
+        QVERIFY(!QFileInfo::exists(archivePath + ".patch.d"));
+
+        delete core;
+    }
+
+    void testDeltaPatchWithParentDirectory()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), true);
+
+        // resolves to the directory the archive is stored in
+        DeltaPatch::Entry escaping;
+        escaping.path = "data/../../../escape.txt";
+        escaping.permissions = QFile::ReadOwner | QFile::WriteOwner;
+        escaping.hash = QCryptographicHash::hash("escape", QCryptographicHash::Sha1).toHex();
+        escaping.data = qCompress("escape");
+        createDeltaPatch(QVector<DeltaPatch::Entry>() << escaping);
+
+        PackageManagerCore *core = PackageManager::getPackageManagerWithInit(
+            tempDir.path() + "/target", m_repository);
+        core->setTestChecksum(true);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // the patch is rejected and the whole archive is downloaded instead
+        const QString archivePath = downloadArchive(core, false, true);
+        QVERIFY(!archivePath.isEmpty());
+        QCOMPARE(readFile(archivePath), readFile(m_repository + "/A/2.0.0content.7z"));
+        QVERIFY(!QFileInfo::exists(archivePath + ".patch.d"));
+        QVERIFY(!QFileInfo::exists(QFileInfo(archivePath).absolutePath() + "/escape.txt"));
+
+        delete core;
+    }
+
+    void testArchiveCacheMiss()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), true);
+        const QString cacheDir = tempDir.path() + "/cache";
+        const QString cachedArchive = cachedArchivePath(cacheDir);
+
+        PackageManagerCore *core = packageManagerWithCache(tempDir.path(), cacheDir);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // downloaded from the repository and stored in the cache
+        const QString archivePath = downloadArchive(core, false);
+        QVERIFY(!archivePath.isEmpty());
+        const QByteArray archive = readFile(m_repository + "/A/2.0.0content.7z");
+        QCOMPARE(readFile(archivePath), archive);
+        QCOMPARE(readFile(cachedArchive), archive);
+        // no temporary files are left behind
+        QCOMPARE(QDir(QFileInfo(cachedArchive).absolutePath()).entryList(QDir::Files | QDir::Hidden),
+            QStringList() << QFileInfo(cachedArchive).fileName());
+
+        delete core;
+    }
+
+    void testArchiveCacheHit()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), true);
+        const QString cacheDir = tempDir.path() + "/cache";
+        const QString cachedArchive = cachedArchivePath(cacheDir);
+
+        // only the checksum is left in the repository, the archive can only come from the cache
+        const QByteArray archive = readFile(m_repository + "/A/2.0.0content.7z");
+        writeFile(cachedArchive, archive);
+        QVERIFY(QFile::remove(m_repository + "/A/2.0.0content.7z"));
+
+        PackageManagerCore *core = packageManagerWithCache(tempDir.path(), cacheDir);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        const QString archivePath = downloadArchive(core, false);
+        QVERIFY(!archivePath.isEmpty());
+        QCOMPARE(readFile(archivePath), archive);
+        QCOMPARE(readFile(cachedArchive), archive);
+
+        delete core;
+    }
+
+    void testArchiveCacheChecksumMismatch()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        createRepository(tempDir.path(), QVector<ChunkManifest::Entry>(), true);
+        const QString cacheDir = tempDir.path() + "/cache";
+        const QString cachedArchive = cachedArchivePath(cacheDir);
+        writeFile(cachedArchive, "corrupted archive");
+
+        PackageManagerCore *core = packageManagerWithCache(tempDir.path(), cacheDir);
+        QVERIFY(core->fetchRemotePackagesTree());
+
+        // the corrupted entry is removed, the archive downloaded and stored in the cache again
+        const QString archivePath = downloadArchive(core, false);
+        QVERIFY(!archivePath.isEmpty());
+        const QByteArray archive = readFile(m_repository + "/A/2.0.0content.7z");
+        QCOMPARE(readFile(archivePath), archive);
+        QCOMPARE(readFile(cachedArchive), archive);
+
+        delete core;
+    }
+
+private:
+    QString m_repository;
+    QString m_installedDir;
+    QString m_contentDir;
+    QStringList m_installedFiles;
+    QMap<QString, QByteArray> m_content;
+};
+
+QTEST_MAIN(tst_DownloadArchivesJob)
+
+#include "tst_downloadarchivesjob.moc"
@@ -30,9 +30,12 @@
 
 #include "init.h"
 #include "extractarchiveoperation.h"
+#include "fileutils.h"
+#include "lib7zarchive.h"
 
 #include <QDir>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTest>
 
 using namespace KDUpdater;
@@ -60,7 +63,7 @@ private slots:
 
         QCOMPARE(UpdateOperation::Error(op.error()), UpdateOperation::InvalidArguments);
         QCOMPARE(op.errorString(), QString("Invalid arguments in Extract: "
-                                           "0 arguments given, exactly 2 arguments expected."));
+                                           "0 arguments given, 2 or 3 arguments expected."));
 
     }
 
@@ -74,6 +77,103 @@ private slots:
         QVERIFY(op.undoOperation());
     }
 
+    void testExtractOperationOverwritesExistingFile()
+    {
+        const QString targetDir = QInstaller::generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(targetDir));
+
+        QFile existing(targetDir + "/valid");
+        QVERIFY(existing.open(QIODevice::WriteOnly));
+        existing.write("existing content");
+        existing.close();
+
+        ExtractArchiveOperation op(nullptr);
+        op.setArguments(QStringList() << ":///data/valid.7z" << targetDir);
+        QVERIFY(op.performOperation());
+
+        // the existing file was backed up during extraction and the backup removed afterwards
+        QCOMPARE(QFileInfo(targetDir + "/valid").size(), 5242880);
+        QVERIFY(!QFile::exists(targetDir + "/valid.tmpUpdate"));
+
+        QVERIFY(op.undoOperation());
+        QVERIFY(QDir(targetDir).removeRecursively());
+    }
+
+    void testExtractOperationBacksUpFilesOfAllBlocks()
+    {
+        QTemporaryDir source;
+        for (int i = 0; i < 8; ++i) {
+            QFile file(source.path() + QString("/file%1.bin").arg(i));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(QByteArray(64 * 1024, 'a' + i)), qint64(64 * 1024));
+        }
+
+        // one solid block per file, so that several threads extract and back up files
+        const QString archivePath = source.path() + "/archive.7z";
+        Lib7zArchive archive(archivePath);
+        archive.setSolidBlockSize(64 * 1024);
+        QVERIFY(archive.open(QIODevice::ReadWrite));
+        QStringList sources;
+        for (int i = 0; i < 8; ++i)
+            sources.append(source.path() + QString("/file%1.bin").arg(i));
+        QVERIFY(archive.create(sources));
+        archive.close();
+
+        const QString targetDir = QInstaller::generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(targetDir));
+        for (int i = 0; i < 8; ++i) {
+            QFile existing(targetDir + QString("/file%1.bin").arg(i));
+            QVERIFY(existing.open(QIODevice::WriteOnly));
+            existing.write("existing content");
+        }
+
+        ExtractArchiveOperation op(nullptr);
+        op.setArguments(QStringList() << archivePath << targetDir);
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+
+        // every backup was recorded, and therefore removed after the extraction
+        QCOMPARE(QDir(targetDir).entryList(QStringList() << "*.tmpUpdate*", QDir::Files),
+            QStringList());
+        for (int i = 0; i < 8; ++i) {
+            QFile file(targetDir + QString("/file%1.bin").arg(i));
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QCOMPARE(file.readAll(), QByteArray(64 * 1024, 'a' + i));
+        }
+
+        QVERIFY(op.undoOperation());
+        QVERIFY(QDir(targetDir).removeRecursively());
+    }
+
+    void testExtractOperationVerifiesChecksum_data()
+    {
+        QTest::addColumn<QString>("checksum");
+        QTest::addColumn<bool>("valid");
+        QTest::newRow("sha1") << "b20819acde222bfe9fc0d9f09ed6cee47342dbaa" << true;
+        QTest::newRow("sha256")
+            << "54c217ff4bbb4e37147ea35e5ba79a56833d26fb6aa186a72886fdcce2f170aa" << true;
+        QTest::newRow("mismatch") << "0000000000000000000000000000000000000000" << false;
+    }
+
+    void testExtractOperationVerifiesChecksum()
+    {
+        QFETCH(QString, checksum);
+        QFETCH(bool, valid);
+
+        const QString targetDir = QInstaller::generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(targetDir));
+
+        ExtractArchiveOperation op(nullptr);
+        op.setArguments(QStringList() << ":///data/valid.7z" << targetDir << checksum);
+        QCOMPARE(op.performOperation(), valid);
+        if (!valid) {
+            QCOMPARE(UpdateOperation::Error(op.error()), UpdateOperation::UserDefinedError);
+            QVERIFY(op.errorString().contains("Checksum mismatch"));
+        }
+        QVERIFY(op.undoOperation());
+        QVERIFY(!QFile::exists(targetDir + "/valid"));
+        QVERIFY(QDir(targetDir).removeRecursively());
+    }
+
     void testExtractOperationInvalidFile()
     {
         ExtractArchiveOperation op(nullptr);
@@ -4,3 +4,5 @@ QT -= gui
 QT += testlib
 
 SOURCES += tst_fileutils.cpp
+
+RESOURCES += data.qrc
@@ -27,12 +27,16 @@
 **************************************************************************/
 
 #include <qinstallerglobal.h>
+#include <errors.h>
 #include <fileutils.h>
+#include <utils.h>
 
 #include <QObject>
 #include <QTest>
 #include <QFile>
 #include <QDir>
+#include <QTemporaryDir>
+#include <QThread>
 
 using namespace QInstaller;
 
@@ -128,6 +132,140 @@ private slots:
         QVERIFY(testFile.remove());
 #endif
     }
+
+    void testCopyFile()
+    {
+        const QByteArray content = QByteArray(3 * 1024 * 1024, 'a') + QByteArray("tail");
+        const QString source = QInstaller::generateTemporaryFileName();
+        QFile sourceFile(source);
+        QVERIFY(sourceFile.open(QIODevice::WriteOnly));
+        QCOMPARE(sourceFile.write(content), qint64(content.size()));
+        sourceFile.close();
+
+        // an existing target is kept, unless overwriting is requested
+        const QString target = QInstaller::generateTemporaryFileName();
+        QFile targetFile(target);
+        QVERIFY(targetFile.open(QIODevice::WriteOnly));
+        targetFile.write("existing content that is longer than nothing");
+        targetFile.close();
+
+        QVERIFY_EXCEPTION_THROWN(copyFile(source, target), Error);
+        QVERIFY(targetFile.open(QIODevice::ReadOnly));
+        QCOMPARE(targetFile.readAll(), QByteArray("existing content that is longer than nothing"));
+        targetFile.close();
+
+        // progress reaches the file size
+        qint64 lastProgress = 0;
+        QCOMPARE(copyFile(source, target, [&lastProgress](qint64 copied) {
+            lastProgress = copied;
+            return true;
+        }, OverwriteFile), qint64(content.size()));
+        QCOMPARE(lastProgress, qint64(content.size()));
+        QVERIFY(targetFile.open(QIODevice::ReadOnly));
+        QCOMPARE(targetFile.readAll(), content);
+        targetFile.close();
+        QCOMPARE(targetFile.permissions(), sourceFile.permissions());
+
+        // canceling removes the partial target
+        QVERIFY(targetFile.remove());
+        QVERIFY_EXCEPTION_THROWN(copyFile(source, target, [](qint64) { return false; }), Error);
+        QVERIFY(!QFile::exists(target));
+
+        // files without a native handle are copied in user space
+        QFile resource(QLatin1String(":/data/resource.txt"));
+        QVERIFY(resource.open(QIODevice::ReadOnly));
+        QCOMPARE(copyFile(resource.fileName(), target), resource.size());
+        QVERIFY(targetFile.open(QIODevice::ReadOnly));
+        QCOMPARE(targetFile.readAll(), resource.readAll());
+        targetFile.close();
+
+        QVERIFY(targetFile.remove());
+        QVERIFY(sourceFile.remove());
+    }
+
+    void testCopyDirectoryContents()
+    {
+        QTemporaryDir source;
+        QTemporaryDir target;
+        QVERIFY(source.isValid() && target.isValid());
+        QVERIFY(QDir(source.path()).mkdir("subdir"));
+        foreach (const QString &name, QStringList() << "file.txt" << "subdir/file.txt") {
+            QFile file(source.path() + '/' + name);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(name.toUtf8());
+        }
+
+        copyDirectoryContents(source.path(), target.path());
+        QFile copied(target.path() + "/subdir/file.txt");
+        QVERIFY(copied.open(QIODevice::ReadOnly));
+        QCOMPARE(copied.readAll(), QByteArray("subdir/file.txt"));
+        copied.close();
+
+        // files existing in the target directory are not overwritten silently
+        QVERIFY(copied.open(QIODevice::WriteOnly));
+        copied.write("modified");
+        copied.close();
+        QVERIFY_EXCEPTION_THROWN(copyDirectoryContents(source.path(), target.path()), Error);
+        QVERIFY(copied.open(QIODevice::ReadOnly));
+        QCOMPARE(copied.readAll(), QByteArray("modified"));
+    }
+
+    void testChecksumHelpers()
+    {
+        QCryptographicHash::Algorithm algorithm = QCryptographicHash::Md5;
+        QVERIFY(checksumAlgorithmFromName(QLatin1String("SHA256"), &algorithm));
+        QCOMPARE(algorithm, QCryptographicHash::Sha256);
+        QVERIFY(checksumAlgorithmFromName(QLatin1String("sha1"), &algorithm));
+        QCOMPARE(algorithm, QCryptographicHash::Sha1);
+        QVERIFY(!checksumAlgorithmFromName(QLatin1String("md5"), &algorithm));
+        QCOMPARE(algorithm, QCryptographicHash::Sha1);
+
+        QCOMPARE(checksumName(QCryptographicHash::Sha1), QString("SHA1"));
+        QCOMPARE(checksumName(QCryptographicHash::Sha256), QString("SHA256"));
+
+        const QByteArray data("checksum");
+        QCOMPARE(checksumAlgorithmForHex(QCryptographicHash::hash(data, QCryptographicHash::Sha1)
+            .toHex()), QCryptographicHash::Sha1);
+        QCOMPARE(checksumAlgorithmForHex(QCryptographicHash::hash(data, QCryptographicHash::Sha256)
+            .toHex() + '\n'), QCryptographicHash::Sha256);
+    }
+
+    void testCalculateHashFromThreads()
+    {
+        // larger than the read buffer, so the data is hashed in several blocks
+        const QByteArray content = QByteArray(3 * 1024 * 1024, 'a') + QByteArray("tail");
+        const QString fileName = QInstaller::generateTemporaryFileName();
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(content), qint64(content.size()));
+        file.close();
+
+        const QByteArray sha1 = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+        const QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+        QCOMPARE(calculateHash(fileName, QCryptographicHash::Sha1), sha1);
+        QCOMPARE(calculateHash(fileName, QCryptographicHash::Sha256), sha256);
+        QVERIFY(calculateHash(fileName + QLatin1String(".missing"), QCryptographicHash::Sha1).isEmpty());
+
+        // no state is shared between concurrent calls
+        QVector<QByteArray> results(8);
+        QVector<QThread *> threads;
+        for (int i = 0; i < results.size(); ++i) {
+            const QCryptographicHash::Algorithm algorithm = (i % 2) ? QCryptographicHash::Sha256
+                : QCryptographicHash::Sha1;
+            threads.append(QThread::create([&results, i, fileName, algorithm] {
+                results[i] = calculateHash(fileName, algorithm);
+            }));
+            threads.last()->start();
+        }
+        for (QThread *thread : qAsConst(threads)) {
+            QVERIFY(thread->wait());
+            delete thread;
+        }
+        for (int i = 0; i < results.size(); ++i)
+            QCOMPARE(results.at(i), (i % 2) ? sha256 : sha1);
+
+        QVERIFY(file.remove());
+    }
 };
 
 QTEST_MAIN(tst_fileutils)
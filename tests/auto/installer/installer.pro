@@ -41,7 +41,10 @@ SUBDIRS += \
     elevatedexecuteoperation \
     treename \
     createoffline \
-    contentshaupdate
+    contentshaupdate \
+    contentchunks \
+    downloadarchivesjob \
+    binarydelta
 
 CONFIG(libarchive) {
     SUBDIRS += libarchivearchive
@@ -29,14 +29,48 @@
 #include <lib7z_facade.h>
 #include <lib7zarchive.h>
 #include <fileutils.h>
+#include <utils.h>
 
 #include <QDir>
 #include <QObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 
 using namespace QInstaller;
 
+class ParallelTestCallback : public Lib7z::ExtractCallback
+{
+public:
+    QStringList files;
+    quint64 completed = 0;
+    quint64 total = 0;
+    bool progressExceededTotal = false;
+    QString failingFile;
+    bool abortOnProgress = false;
+
+protected:
+    bool prepareForFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        return failingFile.isEmpty() || !filename.endsWith(failingFile);
+    }
+
+    void setCurrentFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        files.append(filename);
+    }
+
+    HRESULT setCompleted(quint64 completedBytes, quint64 totalBytes) Q_DECL_OVERRIDE
+    {
+        if (completedBytes > totalBytes)
+            progressExceededTotal = true;
+        completed = completedBytes;
+        total = totalBytes;
+        return abortOnProgress ? E_ABORT : S_OK;
+    }
+};
+
 class tst_lib7zarchive : public QObject
 {
     Q_OBJECT
@@ -118,6 +152,23 @@ private slots:
         QVERIFY(QFile::remove(filename));
     }
 
+    void testCreateArchiveChecksums()
+    {
+        const QString filename = generateTemporaryFileName();
+        Lib7zArchive target(filename);
+        target.setCreatedChecksumAlgorithms(QList<QCryptographicHash::Algorithm>()
+            << QCryptographicHash::Sha1 << QCryptographicHash::Sha256);
+        QVERIFY(target.open(QIODevice::WriteOnly));
+        QVERIFY(target.create(QStringList() << tempSourceFile("Source File 1.")));
+        target.close();
+
+        QCOMPARE(target.createdChecksum(QCryptographicHash::Sha1),
+            calculateHash(filename, QCryptographicHash::Sha1));
+        QCOMPARE(target.createdChecksum(QCryptographicHash::Sha256),
+            calculateHash(filename, QCryptographicHash::Sha256));
+        QVERIFY(QFile::remove(filename));
+    }
+
     void testExtractArchive()
     {
         Lib7zArchive source(":///data/valid.7z");
@@ -128,7 +179,223 @@ private slots:
         QVERIFY(QFile::remove(QDir::tempPath() + QString("/valid")));
     }
 
+    void testCreateAndExtractNonSolidArchive()
+    {
+        QTemporaryDir source;
+        QVERIFY(QDir(source.path()).mkpath("data/subdir"));
+        for (int i = 0; i < 4; ++i) {
+            QFile file(source.path() + QString("/data/subdir/file%1.txt").arg(i));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray(1024, 'a' + i));
+        }
+
+        const QString filename = generateTemporaryFileName();
+        Lib7zArchive target(filename);
+        target.setCompressionThreads(2);
+        target.setSolidBlockSize(-1);
+        QVERIFY(target.open(QIODevice::ReadWrite));
+        QVERIFY(target.create(QStringList() << source.path() + "/data"));
+        target.close();
+
+        // each file in its own block, extracted by several threads
+        QTemporaryDir extracted;
+        QSignalSpy spy(&target, &AbstractArchive::entriesExtracted);
+        QSignalSpy currentEntrySpy(&target, &AbstractArchive::currentEntryChanged);
+        QVERIFY(target.open(QIODevice::ReadOnly));
+        QVERIFY(target.extract(extracted.path()));
+        target.close();
+
+        // entries are reported in batches, but none may be lost
+        QStringList entries;
+        for (const QList<QVariant> &arguments : qAsConst(spy)) {
+            foreach (const QString &entry, arguments.first().toStringList())
+                entries.append(QDir::fromNativeSeparators(entry));
+        }
+        QVERIFY(spy.count() < entries.count());
+        // the current entry is reported once per batch
+        QCOMPARE(currentEntrySpy.count(), spy.count());
+        QCOMPARE(currentEntrySpy.last().first().toString(),
+            spy.last().first().toStringList().last());
+        for (int i = 0; i < 4; ++i) {
+            const QString path = QString("/data/subdir/file%1.txt").arg(i);
+            QCOMPARE(entries.filter(path).count(), 1);
+
+            QFile file(extracted.path() + path);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QCOMPARE(file.readAll(), QByteArray(1024, 'a' + i));
+        }
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testExtractSelectedEntries()
+    {
+        QTemporaryDir source;
+        QVERIFY(QDir(source.path()).mkpath("data/subdir"));
+        for (int i = 0; i < 4; ++i) {
+            QFile file(source.path() + QString("/data/subdir/file%1.txt").arg(i));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray(1024, 'a' + i));
+        }
+
+        const QString filename = generateTemporaryFileName();
+        Lib7zArchive target(filename);
+        target.setSolidBlockSize(-1);
+        QVERIFY(target.open(QIODevice::ReadWrite));
+        QVERIFY(target.create(QStringList() << source.path() + "/data"));
+        target.close();
+
+        QTemporaryDir extracted;
+        QVERIFY(target.open(QIODevice::ReadOnly));
+        QVERIFY(target.extract(extracted.path(), QStringList() << "data/subdir/file1.txt"));
+        QCOMPARE(QDir(extracted.path() + "/data/subdir").entryList(QDir::Files),
+            QStringList() << "file1.txt");
+
+        QVERIFY(!target.extract(extracted.path(), QStringList() << "data/missing.txt"));
+        QCOMPARE(target.errorString(), QString("Cannot find \"data/missing.txt\" in archive."));
+        target.close();
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testExtractChecksDirectoriesOnce()
+    {
+        QTemporaryDir source;
+        for (int i = 0; i < 4; ++i) {
+            const QString dir = source.path() + QString("/data/dir%1").arg(i);
+            QVERIFY(QDir().mkpath(dir));
+            for (int j = 0; j < 50; ++j) {
+                QFile file(dir + QString("/file%1.txt").arg(j));
+                QVERIFY(file.open(QIODevice::WriteOnly));
+                file.write(QByteArray::number(j));
+            }
+        }
+
+        const QString filename = generateTemporaryFileName();
+        Lib7zArchive target(filename);
+        QVERIFY(target.open(QIODevice::ReadWrite));
+        QVERIFY(target.create(QStringList() << source.path() + "/data"));
+        target.close();
+
+        QTemporaryDir extracted;
+        QFile archive(filename);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        CMyComPtr<Lib7z::ExtractCallback> callback = new Lib7z::ExtractCallback;
+        Lib7z::extractArchive(&archive, extracted.path(), callback, 1);
+        archive.close();
+
+        QCOMPARE(QDir(extracted.path() + "/data/dir3").entryList(QDir::Files).count(), 50);
+        // target directory, data and four subdirectories: a few checks each, not one per file
+        QVERIFY(callback->directories().fileSystemAccessCount() > 0);
+        QVERIFY(callback->directories().fileSystemAccessCount() <= 3 * 6);
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testParallelExtract()
+    {
+        QTemporaryDir source;
+        const QString filename = createMultiBlockArchive(source.path());
+
+        QTemporaryDir extracted;
+        QFile archive(filename);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        CMyComPtr<ParallelTestCallback> callback = new ParallelTestCallback;
+        Lib7z::extractArchive(&archive, extracted.path(), callback, 4);
+        archive.close();
+
+        for (int i = 0; i < 8; ++i) {
+            const QString path = extracted.path() + QString("/data/dir%1/file.bin").arg(i);
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QCOMPARE(file.readAll(), QByteArray(64 * 1024, 'a' + i));
+            QCOMPARE(callback->files.count(path), 1);
+
+            // directories created by the extracting threads are known to the callback
+            QVERIFY(callback->directories().contains(extracted.path()
+                + QString("/data/dir%1").arg(i)));
+        }
+        // progress is summed up over all threads
+        QVERIFY(!callback->progressExceededTotal);
+        QCOMPARE(callback->total, quint64(8 * 64 * 1024));
+        QVERIFY(callback->completed > 0);
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testParallelExtractSelectedEntries()
+    {
+        QTemporaryDir source;
+        const QString filename = createMultiBlockArchive(source.path());
+
+        QTemporaryDir extracted;
+        QFile archive(filename);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        CMyComPtr<ParallelTestCallback> callback = new ParallelTestCallback;
+        Lib7z::extractArchive(&archive, extracted.path(), callback, 4, nullptr, QStringList()
+            << "data/dir1/file.bin" << "data/dir6/file.bin");
+        archive.close();
+
+        QCOMPARE(QDir(extracted.path() + "/data").entryList(QDir::Dirs | QDir::NoDotAndDotDot),
+            QStringList() << "dir1" << "dir6");
+        QFile file(extracted.path() + "/data/dir6/file.bin");
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), QByteArray(64 * 1024, 'a' + 6));
+        QCOMPARE(callback->total, quint64(2 * 64 * 1024));
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testParallelExtractErrors()
+    {
+        QTemporaryDir source;
+        const QString filename = createMultiBlockArchive(source.path());
+        QFile archive(filename);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+
+        // a failing file in one thread fails the whole extraction
+        {
+            QTemporaryDir extracted;
+            CMyComPtr<ParallelTestCallback> callback = new ParallelTestCallback;
+            callback->failingFile = "dir3/file.bin";
+            QVERIFY_EXCEPTION_THROWN(Lib7z::extractArchive(&archive, extracted.path(), callback,
+                4), Lib7z::SevenZipException);
+            QVERIFY(!QFile::exists(extracted.path() + "/data/dir3/file.bin"));
+        }
+
+        // aborting in the progress callback stops all threads
+        {
+            QTemporaryDir extracted;
+            CMyComPtr<ParallelTestCallback> callback = new ParallelTestCallback;
+            callback->abortOnProgress = true;
+            QVERIFY_EXCEPTION_THROWN(Lib7z::extractArchive(&archive, extracted.path(), callback,
+                4), Lib7z::SevenZipException);
+            // each thread finishes at most the block it is extracting
+            QVERIFY(callback->files.filter("file.bin").count() < 8);
+        }
+        archive.close();
+        QVERIFY(QFile::remove(filename));
+    }
+
 private:
+    /*
+        Creates an archive of eight directories with one 64 KiB file each in \a sourceDir,
+        using solid blocks small enough to store every file in its own block.
+    */
+    QString createMultiBlockArchive(const QString &sourceDir)
+    {
+        for (int i = 0; i < 8; ++i) {
+            const QString dir = sourceDir + QString("/data/dir%1").arg(i);
+            QDir().mkpath(dir);
+            QFile file(dir + "/file.bin");
+            file.open(QIODevice::WriteOnly);
+            file.write(QByteArray(64 * 1024, 'a' + i));
+        }
+
+        const QString filename = generateTemporaryFileName();
+        Lib7zArchive target(filename);
+        target.setSolidBlockSize(64 * 1024);
+        target.open(QIODevice::ReadWrite);
+        target.create(QStringList() << sourceDir + "/data");
+        target.close();
+        return filename;
+    }
+
     QString tempSourceFile(const QByteArray &data, const QString &templateName = QString())
     {
         QTemporaryFile source;
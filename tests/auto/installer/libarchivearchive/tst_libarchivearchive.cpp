@@ -28,9 +28,11 @@
 
 #include <libarchivearchive.h>
 #include <fileutils.h>
+#include <utils.h>
 
 #include <QDir>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 
@@ -103,6 +105,31 @@ private slots:
         QVERIFY(QFile(filename).remove());
     }
 
+    void testCreateArchiveChecksums_data()
+    {
+        archiveSuffixesTestData();
+    }
+
+    void testCreateArchiveChecksums()
+    {
+        QFETCH(QString, suffix);
+
+        const QString filename = generateTemporaryFileName() + suffix;
+        LibArchiveArchive target(filename);
+        target.setCreatedChecksumAlgorithms(QList<QCryptographicHash::Algorithm>()
+            << QCryptographicHash::Sha1 << QCryptographicHash::Sha256);
+        QVERIFY(target.open(QIODevice::WriteOnly));
+        QVERIFY(target.create(QStringList() << tempSourceFile("Source File 1.")));
+        target.close();
+
+        QCOMPARE(target.createdChecksum(QCryptographicHash::Sha1),
+            calculateHash(filename, QCryptographicHash::Sha1));
+        QCOMPARE(target.createdChecksum(QCryptographicHash::Sha256),
+            calculateHash(filename, QCryptographicHash::Sha256));
+        QVERIFY(target.createdChecksum(QCryptographicHash::Md5).isEmpty());
+        QVERIFY(QFile(filename).remove());
+    }
+
     void testCreateArchiveWithSpaces_data()
     {
         archiveSuffixesTestData();
@@ -148,6 +175,53 @@ private slots:
         QVERIFY(QFile(QDir::tempPath() + QString("/valid")).remove());
     }
 
+    void testExtractManySmallFiles_data()
+    {
+        archiveSuffixesTestData();
+    }
+
+    void testExtractManySmallFiles()
+    {
+        QFETCH(QString, suffix);
+
+        // small files are written concurrently, directories in order
+        QTemporaryDir source;
+        for (int dir = 0; dir < 4; ++dir) {
+            QVERIFY(QDir(source.path()).mkpath(QString("data/dir%1").arg(dir)));
+            for (int i = 0; i < 50; ++i) {
+                QFile file(source.path() + QString("/data/dir%1/file%2.txt").arg(dir).arg(i));
+                QVERIFY(file.open(QIODevice::WriteOnly));
+                file.write(QByteArray::number(dir * 100 + i));
+            }
+        }
+        const QString script = source.path() + "/data/dir0/file0.txt";
+        QVERIFY(QFile::setPermissions(script, QFile::permissions(script) | QFile::ExeOwner));
+
+        const QString filename = generateTemporaryFileName() + suffix;
+        LibArchiveArchive target(filename);
+        QVERIFY(target.open(QIODevice::ReadWrite));
+        QVERIFY(target.create(QStringList() << source.path() + "/data"));
+        target.close();
+
+        QTemporaryDir extracted;
+        QVERIFY(target.open(QIODevice::ReadOnly));
+        QVERIFY(target.extract(extracted.path()));
+        target.close();
+
+        for (int dir = 0; dir < 4; ++dir) {
+            for (int i = 0; i < 50; ++i) {
+                const QString path = QString("/data/dir%1/file%2.txt").arg(dir).arg(i);
+                QFile file(extracted.path() + path);
+                QVERIFY(file.open(QIODevice::ReadOnly));
+                QCOMPARE(file.readAll(), QByteArray::number(dir * 100 + i));
+                QCOMPARE(QFileInfo(file).lastModified().toSecsSinceEpoch(),
+                    QFileInfo(source.path() + path).lastModified().toSecsSinceEpoch());
+            }
+        }
+        QVERIFY(QFile::permissions(extracted.path() + "/data/dir0/file0.txt") & QFile::ExeOwner);
+        QVERIFY(QFile::remove(filename));
+    }
+
 private:
     void archiveFilenamesTestData()
     {
@@ -165,6 +239,7 @@ private:
         QTest::newRow("gzip compressed tar archive") << ".tar.gz";
         QTest::newRow("bzip2 compressed tar archive") << ".tar.bz2";
         QTest::newRow("xz compressed tar archive") << ".tar.xz";
+        QTest::newRow("zstd compressed tar archive") << ".tar.zst";
     }
 
     bool entriesMatch(const ArchiveEntry &lhs, const ArchiveEntry &rhs)
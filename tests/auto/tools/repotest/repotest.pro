@@ -5,5 +5,6 @@ QT -= gui
 SOURCES += tst_repotest.cpp
 
 RESOURCES += \
-    settings.qrc
+    settings.qrc \
+    ..\..\installer\shared\config.qrc
 
@@ -26,6 +26,7 @@
 **
 **************************************************************************/
 #include "../../installer/shared/verifyinstaller.h"
+#include "../../installer/shared/packagemanager.h"
 
 #include <repositorygen.h>
 #include <repositorygen.cpp>
@@ -34,6 +35,8 @@
 #include <lib7zarchive.h>
 
 #include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
 #include <QTest>
 #include <QRegularExpression>
 
@@ -42,12 +45,17 @@ class tst_repotest : public QObject
     Q_OBJECT
 private:
     void generateRepo(bool createSplitMetadata, bool createUnifiedMetadata, bool updateNewComponents,
-                      QStringList packagesUpdatedWithSha = QStringList())
+                      QStringList packagesUpdatedWithSha = QStringList(), int jobs = 1,
+                      const QString &cacheDirectory = QString(), bool appendUnifiedMetadata = false,
+                      qint64 metadataChunkSize = 0,
+                      QCryptographicHash::Algorithm checksumAlgorithm = QCryptographicHash::Sha1,
+                      const QString &previousPackagesDir = QString())
     {
         QStringList filteredPackages;
 
         m_packages = QInstallerTools::collectPackages(m_repoInfo,
-            &filteredPackages, QInstallerTools::Exclude, updateNewComponents, packagesUpdatedWithSha);
+            &filteredPackages, QInstallerTools::Exclude, updateNewComponents, packagesUpdatedWithSha,
+            previousPackagesDir);
 
         if (updateNewComponents) { //Verify that component B exists as that is not updated
             if (createSplitMetadata) {
@@ -61,11 +69,46 @@ private:
         QTemporaryDir tmp;
         tmp.setAutoRemove(false);
         const QString tmpMetaDir = tmp.path();
-        QInstallerTools::createRepository(m_repoInfo, &m_packages, tmpMetaDir, createSplitMetadata,
-                                          createUnifiedMetadata, QLatin1String("7z"));
+        QInstallerTools::RepositoryOptions options;
+        options.createComponentMetadata = createSplitMetadata;
+        options.createUnifiedMetadata = createUnifiedMetadata;
+        options.checksumAlgorithm = checksumAlgorithm;
+        options.jobs = jobs;
+        options.cacheDirectory = cacheDirectory;
+        options.appendUnifiedMetadata = appendUnifiedMetadata;
+        options.metadataChunkSize = metadataChunkSize;
+        options.previousPackagesDir = previousPackagesDir;
+        QInstallerTools::createRepository(m_repoInfo, &m_packages, tmpMetaDir, options);
         QInstaller::removeDirectory(tmpMetaDir, true);
     }
 
+    QByteArray randomData(int size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = char(generator.bounded(256));
+        return data;
+    }
+
+    void createPackage(const QString &packagesDir, const QString &version,
+                       const QHash<QString, QByteArray> &files)
+    {
+        QVERIFY(QDir().mkpath(packagesDir + "/A/meta"));
+        QVERIFY(QDir().mkpath(packagesDir + "/A/data"));
+        QFile packageXml(packagesDir + "/A/meta/package.xml");
+        QVERIFY(packageXml.open(QIODevice::WriteOnly));
+        packageXml.write(QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Package>\n"
+            "    <DisplayName>A</DisplayName>\n    <Description>Example component A</Description>\n"
+            "    <Version>%1</Version>\n    <ReleaseDate>2020-01-01</ReleaseDate>\n"
+            "    <Default>true</Default>\n</Package>\n").arg(version).toUtf8());
+        for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+            QFile file(packagesDir + "/A/data/" + it.key());
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(it.value()), qint64(it.value().size()));
+        }
+    }
+
     void clearData()
     {
         m_repoInfo.packages.clear();
@@ -153,7 +196,8 @@ private:
             QTest::ignoreMessage(QtDebugMsg, qPrintable(message.arg(packageDir, component)));
             QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Hash is stored in *"));
             QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Creating hash of archive *"));
-            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Generated sha1 hash: *"));
+            // the algorithm depends on the repository, see testWithSha256Checksums()
+            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Generated sha(1|256) hash: *"));
         }
     }
 
@@ -195,14 +239,15 @@ private:
         }
     }
 
-    void ignoreMessagesForComponentSha(const QStringList &components, bool clearOldChecksum)
+    void ignoreMessagesForComponentSha(const QStringList &components, bool clearOldChecksum,
+                                       const QString &sumName = "sha1sum")
     {
         foreach (const QString component, components) {
-            const QString message = "Searching sha1sum node for \"%1\"";
-            QTest::ignoreMessage(QtDebugMsg, qPrintable(message.arg(component)));
+            const QString message = "Searching %1 node for \"%2\"";
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(message.arg(sumName, component)));
             if (clearOldChecksum)
-                QTest::ignoreMessage(QtDebugMsg, QRegularExpression("- clearing the old sha1sum *"));
-            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("- writing the sha1sum *"));
+                QTest::ignoreMessage(QtDebugMsg, QRegularExpression("- clearing the old " + sumName + " *"));
+            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("- writing the " + sumName + " *"));
         }
     }
 
@@ -326,6 +371,68 @@ private slots:
         verifyUniteMetadata("1.0.0");
     }
 
+    void testWithChunkedUniteMeta()
+    {
+        ignoreMessagesForUniteMeta(false);
+        QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Creating meta data chunk *"));
+        generateRepo(false, true, false, QStringList(), 1, QString(), false, 1);
+
+        verifyComponentRepository("1.0.0", "1.0.0", false);
+        verifyUniteMetadata("1.0.0");
+
+        // component A fills the first archive, B goes to a chunk of its own
+        QFile updatesXml(m_repoInfo.repositoryDir + "/Updates.xml");
+        QDomDocument doc;
+        QVERIFY(updatesXml.open(QIODevice::ReadOnly));
+        QVERIFY(doc.setContent(&updatesXml));
+        const QDomNodeList chunks = doc.documentElement().elementsByTagName("MetadataChunk");
+        QCOMPARE(chunks.count(), 1);
+        const QDomElement chunk = chunks.at(0).toElement();
+        QCOMPARE(chunk.firstChildElement("Components").text(), QString("B"));
+        QVERIFY(!chunk.firstChildElement("SHA1").text().isEmpty());
+        const QString chunkMeta7z = chunk.firstChildElement("Name").text();
+        QVERIFY(chunkMeta7z.endsWith("_chunk1_meta.7z"));
+        VerifyInstaller::verifyFileExistence(m_repoInfo.repositoryDir, QStringList() << chunkMeta7z);
+    }
+
+    void testWithParallelJobs()
+    {
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
+        generateRepo(true, false, false, QStringList(), 2);
+
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+        verifyComponentMetaUpdatesXml();
+
+        // the components keep their order, independent of which job finished first
+        const QString fileContent = VerifyInstaller::fileContent(m_repoInfo.repositoryDir
+            + QDir::separator() + "Updates.xml");
+        QVERIFY(fileContent.indexOf("<Name>A</Name>") != -1);
+        QVERIFY(fileContent.indexOf("<Name>A</Name>") < fileContent.indexOf("<Name>B</Name>"));
+    }
+
+    void testWithBuildCache()
+    {
+        QTemporaryDir cacheDir;
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
+        generateRepo(true, false, false, QStringList(), 1, cacheDir.path());
+        const QString contentSha1 = VerifyInstaller::fileContent(m_repoInfo.repositoryDir
+            + "/A/1.0.0content.7z.sha1");
+
+        // nothing changed, the second run copies the archives from the cache
+        foreach (const QString component, QStringList() << "A" << "B") {
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(QString("Reusing cached component data "
+                "for \"%1\"").arg(component)));
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(QString("Reusing cached meta data archive "
+                "for \"%1\"").arg(component)));
+        }
+        generateRepo(true, false, false, QStringList(), 1, cacheDir.path());
+
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+        verifyComponentMetaUpdatesXml();
+        QCOMPARE(VerifyInstaller::fileContent(m_repoInfo.repositoryDir + "/A/1.0.0content.7z.sha1"),
+            contentSha1);
+    }
+
     void testWithComponentShaUpdate()
     {
         ignoreMessagesForComponentSha(QStringList () << "A" << "B", false);
@@ -346,6 +453,101 @@ private slots:
         verifyComponentShaUpdate(2);
     }
 
+    void testWithSha256Checksums()
+    {
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false, "sha256sum");
+        generateRepo(true, false, false, QStringList(), 1, QString(), false, 0,
+                     QCryptographicHash::Sha256);
+
+        foreach (const QString component, QStringList() << "A" << "B") {
+            const QString componentDir = m_repoInfo.repositoryDir + "/" + component;
+            VerifyInstaller::verifyFileExistence(componentDir, QStringList() << "1.0.0content.7z"
+                << "1.0.0content.7z.sha256" << "1.0.0meta.7z");
+            QVERIFY(!QFile::exists(componentDir + "/1.0.0content.7z.sha1"));
+            QCOMPARE(VerifyInstaller::fileContent(componentDir + "/1.0.0content.7z.sha256").toLatin1(),
+                QInstaller::calculateHash(componentDir + "/1.0.0content.7z",
+                QCryptographicHash::Sha256).toHex());
+        }
+
+        const QString updatesXml = m_repoInfo.repositoryDir + "/Updates.xml";
+        VerifyInstaller::verifyFileContent(updatesXml, "<ChecksumType>SHA256</ChecksumType>");
+        VerifyInstaller::verifyFileContent(updatesXml, "<SHA256>");
+        VerifyInstaller::verifyFileHasNoContent(updatesXml, "<SHA1>");
+
+        // the installer verifies the archives with the algorithm of the repository
+        QTemporaryDir installDir;
+        QVERIFY(installDir.isValid());
+        QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit(
+            installDir.path(), m_repoInfo.repositoryDir));
+        QCOMPARE(PackageManagerCore::Success, core->installSelectedComponentsSilently(QStringList()
+            << "A"));
+        VerifyInstaller::verifyFileExistence(installDir.path(), QStringList() << "A.txt");
+        QVERIFY(!QFile::exists(installDir.path() + "/B.txt"));
+    }
+
+    void testWithDeltaPatches()
+    {
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
+        generateRepo(true, false, false);
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+
+        QTemporaryDir packagesDir;
+        QVERIFY(packagesDir.isValid());
+        const QByteArray data = randomData(64 * 1024, 1);
+        QByteArray updatedData = data;
+        updatedData.insert(32 * 1024, QByteArray("inserted in the middle"));
+        const QByteArray addedData = "added in 2.0.0";
+        QHash<QString, QByteArray> files;
+        files.insert("A.bin", data);
+        createPackage(packagesDir.path() + "/packages_1.5.0", "1.5.0", files);
+        files.insert("A.bin", updatedData);
+        files.insert("added.txt", addedData);
+        createPackage(packagesDir.path() + "/packages_2.0.0", "2.0.0", files);
+
+        clearData();
+        m_repoInfo.packages << packagesDir.path() + "/packages_1.5.0";
+        generateRepo(true, false, false);
+        QVERIFY(!QFileInfo::exists(m_repoInfo.repositoryDir + "/A/1.5.0content.7z.patch"));
+
+        // the replaced version is kept there to create the patches from, like repogen does
+        QTemporaryDir previousPackagesDir;
+        QVERIFY(previousPackagesDir.isValid());
+        clearData();
+        m_repoInfo.packages << packagesDir.path() + "/packages_2.0.0";
+        generateRepo(true, false, false, QStringList(), 1, QString(), false, 0,
+            QCryptographicHash::Sha1, previousPackagesDir.path());
+
+        const QString archive = m_repoInfo.repositoryDir + "/A/2.0.0content.7z";
+        VerifyInstaller::verifyFileExistence(m_repoInfo.repositoryDir + "/A", QStringList()
+            << "2.0.0content.7z" << "2.0.0content.7z.patch");
+        QVERIFY(QFileInfo(archive + ".patch").size() < QFileInfo(archive).size());
+        const QString updatesXml = m_repoInfo.repositoryDir + "/Updates.xml";
+        VerifyInstaller::verifyFileContent(updatesXml, "<DeltaPatches>content.7z</DeltaPatches>");
+        VerifyInstaller::verifyFileContent(updatesXml, "<DeltaPatchFrom>1.5.0</DeltaPatchFrom>");
+
+        QFile patchFile(archive + ".patch");
+        QVERIFY(patchFile.open(QIODevice::ReadOnly));
+        DeltaPatch patch;
+        QVERIFY(patch.read(&patchFile));
+        QHash<QString, DeltaPatch::Entry> entries;
+        foreach (const DeltaPatch::Entry &entry, patch.entries())
+            entries.insert(entry.path, entry);
+        QCOMPARE(entries.count(), 2);
+
+        // changed files are patched, added files are stored completely
+        const DeltaPatch::Entry changed = entries.value("A.bin");
+        QCOMPARE(changed.sourceHash, QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+        QCOMPARE(changed.hash, QCryptographicHash::hash(updatedData, QCryptographicHash::Sha1).toHex());
+        QByteArray patched;
+        QVERIFY(BinaryDelta::apply(data, qUncompress(changed.data), &patched));
+        QCOMPARE(patched, updatedData);
+
+        const DeltaPatch::Entry added = entries.value("added.txt");
+        QVERIFY(added.sourceHash.isEmpty());
+        QCOMPARE(added.hash, QCryptographicHash::hash(addedData, QCryptographicHash::Sha1).toHex());
+        QCOMPARE(qUncompress(added.data), addedData);
+    }
+
     void testUpdateNewComponents()
     {
         // Create 'base' repository which will be updated
@@ -434,6 +636,46 @@ private slots:
         verifyUniteMetadata("2.0.0");
     }
 
+    void testAppendUniteMetadataFromPartialPackageDir()
+    {
+        ignoreMessagesForUniteMeta(false);
+        generateRepo(false, true, false);
+        verifyComponentRepository("1.0.0", "1.0.0", false);
+        const QString baseMeta7z = QInstallerTools::existingUniteMeta7z(m_repoInfo.repositoryDir);
+
+        clearData();
+        m_repoInfo.packages << ":///packages_new";
+        { // ignore messages
+            ignoreMessageForCollectingPackages(QString(), QString(), "1.0.0");
+            ignoreMessagesForCopyMetadata("C", false, false);
+            ignoreMessagesForComponentHash(QStringList() << "C", false);
+            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Keeping the unified meta data archive *"));
+            QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Appending the meta data of *"));
+        }
+        generateRepo(false, true, false, QStringList(), 1, QString(), true);
+
+        // the unified archive is kept, only the new component is in the patch
+        QCOMPARE(QInstallerTools::existingUniteMeta7z(m_repoInfo.repositoryDir), baseMeta7z);
+        QFile updatesXml(m_repoInfo.repositoryDir + "/Updates.xml");
+        QDomDocument doc;
+        QVERIFY(updatesXml.open(QIODevice::ReadOnly));
+        QVERIFY(doc.setContent(&updatesXml));
+        const QDomNodeList patches = doc.documentElement().elementsByTagName("MetadataPatch");
+        QCOMPARE(patches.count(), 1);
+        const QDomElement patch = patches.at(0).toElement();
+        QCOMPARE(patch.firstChildElement("Components").text(), QString("C"));
+        QVERIFY(!patch.firstChildElement("SHA1").text().isEmpty());
+        const QString patchMeta7z = patch.firstChildElement("Name").text();
+        QVERIFY(patchMeta7z.endsWith("_patch1_meta.7z"));
+        VerifyInstaller::verifyFileExistence(m_repoInfo.repositoryDir, QStringList() << baseMeta7z
+            << patchMeta7z);
+
+        Lib7zArchive file(m_repoInfo.repositoryDir + QDir::separator() + patchMeta7z);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        foreach (const ArchiveEntry &entry, file.list())
+            QVERIFY(entry.path.startsWith("C"));
+    }
+
     void testUpdateComponentsFromRepository()
     {
         ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
@@ -482,6 +724,69 @@ private slots:
         verifyComponentMetaUpdatesXml();
     }
 
+    void testListsOfPackages()
+    {
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
+        generateRepo(true, false, false);
+
+        // the descriptions are read in parallel, the list keeps the order of the directories
+        QStringList filteredPackages;
+        QTest::ignoreMessage(QtDebugMsg, "Collecting information about available packages...");
+        foreach (const QString &component, QStringList() << "C" << "A" << "B") {
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(QString("Found subdirectory \"%1\"")
+                .arg(component)));
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(QString("- it provides the package \"%1\"  -  "
+                "\"1.0.0\"").arg(component)));
+        }
+        QInstallerTools::PackageInfoVector packages = QInstallerTools::createListOfPackages(QStringList()
+            << ":///packages_new" << ":///packages", &filteredPackages, QInstallerTools::Exclude,
+            QStringList() << "B");
+        QCOMPARE(packages.count(), 3);
+        QCOMPARE(packages.at(0).name, QString("C"));
+        QCOMPARE(packages.at(1).name, QString("A"));
+        QCOMPARE(packages.at(2).name, QString("B"));
+        foreach (const QInstallerTools::PackageInfo &package, packages) {
+            QCOMPARE(package.version, QString("1.0.0"));
+            QVERIFY(package.directory.endsWith("/" + package.name));
+            QVERIFY(package.dependencies.isEmpty());
+            QCOMPARE(package.createContentSha1Node, package.name == "B");
+        }
+        QVERIFY(packages.at(0).directory.contains("packages_new"));
+
+        // a package found in several repositories is listed once, in its newest version
+        filteredPackages.clear();
+        QTest::ignoreMessage(QtDebugMsg, "Collecting information about available repository packages...");
+        foreach (const QString &repository, QStringList() << "repository_1" << "repository_2" << "repository_3")
+            QTest::ignoreMessage(QtDebugMsg, qPrintable(QString("Process repository \"%1\"").arg(repository)));
+        QTest::ignoreMessage(QtDebugMsg, "- it provides the package \"A\"  -  \"2.0.0\"");
+        QTest::ignoreMessage(QtDebugMsg, "- it provides the package \"B\"  -  \"1.0.0\"");
+        QTest::ignoreMessage(QtDebugMsg, "- it provides an old version of the package \"A\"  -  \"1.0.0\" - ignored");
+        QTest::ignoreMessage(QtDebugMsg, "- it provides an old version of the package \"B\"  -  \"1.0.0\" - ignored");
+        QTest::ignoreMessage(QtDebugMsg, "- it provides an old version of the package \"A\"  -  \"1.0.0\" - ignored");
+        QTest::ignoreMessage(QtDebugMsg, "- it provides a new version of the package \"B\"  -  \"3.0.0\" - replaced");
+        packages = QInstallerTools::createListOfRepositoryPackages(QStringList()
+            << ":///test_package_versions/repository_1" << ":///test_package_versions/repository_2"
+            << ":///test_package_versions/repository_3", &filteredPackages, QInstallerTools::Exclude);
+
+        QCOMPARE(packages.count(), 2);
+        const QInstallerTools::PackageInfo &packageA = packages.at(0);
+        QCOMPARE(packageA.name, QString("A"));
+        QCOMPARE(packageA.version, QString("2.0.0"));
+        QVERIFY(packageA.directory.endsWith("repository_1/A"));
+        QVERIFY(packageA.metaFile.endsWith("repository_1/A/2.0.0meta.7z"));
+        QVERIFY(packageA.metaNode.contains("<Version>2.0.0</Version>"));
+
+        const QInstallerTools::PackageInfo &packageB = packages.at(1);
+        QCOMPARE(packageB.name, QString("B"));
+        QCOMPARE(packageB.version, QString("3.0.0"));
+        QVERIFY(packageB.directory.endsWith("repository_3/B"));
+        QVERIFY(packageB.metaFile.endsWith("repository_3/B/3.0.0meta.7z"));
+        QVERIFY(packageB.metaNode.contains("<Version>3.0.0</Version>"));
+        QCOMPARE(packageB.copiedFiles.count(), 2);
+        QVERIFY(packageB.copiedFiles.at(0).endsWith("repository_3/B/3.0.0content.7z"));
+        QVERIFY(packageB.copiedFiles.at(1).endsWith("repository_3/B/3.0.0content.7z.sha1"));
+    }
+
     void testUpdateComponentsFromRepositoryWithUniteMetadata()
     {
         ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
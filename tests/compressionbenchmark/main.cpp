@@ -0,0 +1,155 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <archivefactory.h>
+#include <errors.h>
+#include <fileutils.h>
+#include <lib7z_facade.h>
+#include <utils.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <iostream>
+
+using namespace QInstaller;
+
+// Compresses the given sources with each combination of thread count and solid block size,
+// then extracts the result again, and prints wall time and compression ratio of each run.
+
+static qint64 directorySize(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!info.isDir())
+        return info.size();
+
+    qint64 size = 0;
+    foreach (const QFileInfo &entry, QDir(path).entryInfoList(QDir::AllEntries | QDir::Hidden
+            | QDir::System | QDir::NoDotAndDotDot)) {
+        size += entry.isDir() && !entry.isSymLink() ? directorySize(entry.absoluteFilePath())
+            : entry.size();
+    }
+    return size;
+}
+
+static QList<qint64> parseList(const QString &value)
+{
+    QList<qint64> result;
+    foreach (const QString &item, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        bool ok = false;
+        result.append(item.toLongLong(&ok));
+        if (!ok || result.last() < 0)
+            throw Error(QString::fromLatin1("Invalid value \"%1\".").arg(item));
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption format(QLatin1String("format"),
+        QLatin1String("Archive format to benchmark. Defaults to 7z."), QLatin1String("format"),
+        QLatin1String("7z"));
+    const QCommandLineOption level(QLatin1String("compression"),
+        QLatin1String("Compression level. Defaults to 5."), QLatin1String("level"),
+        QLatin1String("5"));
+    const QCommandLineOption threads(QLatin1String("threads"),
+        QLatin1String("Comma-separated thread counts to compare, 0 for all cores. Defaults to 1,0."),
+        QLatin1String("n,..."), QLatin1String("1,0"));
+    const QCommandLineOption blocks(QLatin1String("solid-block-size"),
+        QLatin1String("Comma-separated solid block sizes in megabytes to compare, 0 for the "
+        "compressor default. Defaults to 0."), QLatin1String("MB,..."), QLatin1String("0"));
+    parser.addOption(format);
+    parser.addOption(level);
+    parser.addOption(threads);
+    parser.addOption(blocks);
+    parser.addPositionalArgument(QLatin1String("sources"),
+        QLatin1String("Files and directories to compress."));
+    parser.process(app);
+
+    const QStringList sources = parser.positionalArguments();
+    if (sources.isEmpty())
+        parser.showHelp(EXIT_FAILURE);
+
+    try {
+        Lib7z::initSevenZ();
+
+        qint64 inputSize = 0;
+        foreach (const QString &source, sources)
+            inputSize += directorySize(source);
+        std::cout << "Input: " << humanReadableSize(inputSize) << std::endl;
+        std::cout << "threads\tblock\tcompress ms\textract ms\tsize\tratio" << std::endl;
+
+        const QList<qint64> threadCounts = parseList(parser.value(threads));
+        const QList<qint64> blockSizes = parseList(parser.value(blocks));
+        foreach (const qint64 threadCount, threadCounts) {
+            foreach (const qint64 blockSize, blockSizes) {
+                QTemporaryDir workDir;
+                const QString archiveName = workDir.path() + QLatin1String("/benchmark.")
+                    + parser.value(format);
+
+                QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(archiveName));
+                if (!archive)
+                    throw Error(QString::fromLatin1("Unsupported format \"%1\".").arg(parser.value(format)));
+                archive->setCompressionLevel(AbstractArchive::CompressionLevel(parser.value(level).toInt()));
+                archive->setCompressionThreads(int(threadCount));
+                archive->setSolidBlockSize(blockSize * 1024 * 1024);
+
+                QElapsedTimer timer;
+                timer.start();
+                if (!(archive->open(QIODevice::WriteOnly) && archive->create(sources)))
+                    throw Error(archive->errorString());
+                archive->close();
+                const qint64 compressTime = timer.elapsed();
+
+                const qint64 archiveSize = QFileInfo(archiveName).size();
+                timer.restart();
+                if (!(archive->open(QIODevice::ReadOnly)
+                        && archive->extract(workDir.path() + QLatin1String("/extracted")))) {
+                    throw Error(archive->errorString());
+                }
+                const qint64 extractTime = timer.elapsed();
+
+                std::cout << threadCount << '\t' << blockSize << '\t' << compressTime << '\t'
+                    << extractTime << '\t' << humanReadableSize(archiveSize) << '\t'
+                    << (inputSize > 0 ? double(archiveSize) / inputSize : 0.0) << std::endl;
+            }
+        }
+    } catch (const Error &e) {
+        std::cerr << e.message() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <errors.h>
+#include <fileutils.h>
+#include <utils.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <iostream>
+
+using namespace QInstaller;
+
+// Copies all files of a repository, once with QFile::copy() and once with
+// QInstaller::copyFile(), and prints the throughput of each run. Pass a target
+// directory on the same file system as the repository to measure reflinks.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument(QLatin1String("repository"),
+        QLatin1String("Repository directory to copy."));
+    parser.addPositionalArgument(QLatin1String("target"),
+        QLatin1String("Directory to create the copies in, defaults to the temporary directory."));
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty() || !QFileInfo(arguments.first()).isDir())
+        parser.showHelp(EXIT_FAILURE);
+    const QDir source(arguments.first());
+
+    try {
+        QStringList files;
+        qint64 inputSize = 0;
+        QDirIterator it(source.path(), QDir::Files | QDir::Hidden | QDir::NoSymLinks,
+            QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            files.append(source.relativeFilePath(it.next()));
+            inputSize += it.fileInfo().size();
+        }
+        std::cout << "Input: " << files.count() << " files, " << humanReadableSize(inputSize)
+            << std::endl;
+        std::cout << "method\tms\tMB/s" << std::endl;
+
+        for (int fast = 0; fast < 2; ++fast) {
+            QTemporaryDir target(arguments.value(1, QDir::tempPath())
+                + QLatin1String("/copybenchmark-XXXXXX"));
+            if (!target.isValid())
+                throw Error(QLatin1String("Cannot create target directory."));
+            const QDir targetDir(target.path());
+
+            QElapsedTimer timer;
+            timer.start();
+            foreach (const QString &file, files) {
+                const QString to = targetDir.absoluteFilePath(file);
+                mkpath(QFileInfo(to).absolutePath());
+                if (fast) {
+                    copyFile(source.absoluteFilePath(file), to);
+                } else if (!QFile::copy(source.absoluteFilePath(file), to)) {
+                    throw Error(QString::fromLatin1("Cannot copy file \"%1\".").arg(file));
+                }
+            }
+            const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+
+            std::cout << (fast ? "copyFile" : "QFile::copy") << '\t' << elapsed << '\t'
+                << (double(inputSize) / (1024 * 1024)) / (double(elapsed) / 1000) << std::endl;
+        }
+    } catch (const Error &e) {
+        std::cerr << e.message() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+#include <errors.h>
+#include <utils.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <iostream>
+
+using namespace QInstaller;
+
+// Hashes the given files with each checksum algorithm, once file by file on a single thread
+// and once with the files spread over all cores, and prints the throughput of each run.
+
+struct Algorithm
+{
+    const char *name;
+    QCryptographicHash::Algorithm algorithm;
+};
+
+static const Algorithm algorithms[] = {
+    { "MD5", QCryptographicHash::Md5 },
+    { "SHA1", QCryptographicHash::Sha1 },
+    { "SHA256", QCryptographicHash::Sha256 },
+    { "SHA512", QCryptographicHash::Sha512 },
+    { "SHA3-256", QCryptographicHash::Sha3_256 }
+};
+
+static void collectFiles(const QString &path, QStringList *files)
+{
+    if (QFileInfo(path).isFile()) {
+        files->append(path);
+        return;
+    }
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        files->append(it.next());
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument(QLatin1String("sources"),
+        QLatin1String("Files and directories to hash."));
+    parser.process(app);
+
+    const QStringList sources = parser.positionalArguments();
+    if (sources.isEmpty())
+        parser.showHelp(EXIT_FAILURE);
+
+    try {
+        QStringList files;
+        qint64 inputSize = 0;
+        foreach (const QString &source, sources)
+            collectFiles(source, &files);
+        foreach (const QString &file, files)
+            inputSize += QFileInfo(file).size();
+        std::cout << "Input: " << files.count() << " files, " << humanReadableSize(inputSize)
+            << std::endl;
+        std::cout << "algorithm\tthreads\tms\tMB/s" << std::endl;
+
+        for (const Algorithm &algorithm : algorithms) {
+            for (int parallel = 0; parallel < 2; ++parallel) {
+                const QCryptographicHash::Algorithm algo = algorithm.algorithm;
+                QElapsedTimer timer;
+                timer.start();
+                if (parallel) {
+                    QtConcurrent::blockingMap(files, [algo](const QString &file) {
+                        calculateHash(file, algo);
+                    });
+                } else {
+                    foreach (const QString &file, files)
+                        calculateHash(file, algo);
+                }
+                const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+
+                std::cout << algorithm.name << '\t'
+                    << (parallel ? QThread::idealThreadCount() : 1) << '\t' << elapsed << '\t'
+                    << (double(inputSize) / (1024 * 1024)) / (double(elapsed) / 1000) << std::endl;
+            }
+        }
+    } catch (const Error &e) {
+        std::cerr << e.message() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/**************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <errors.h>
+#include <lib7z_facade.h>
+#include <repositorygen.h>
+#include <utils.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <iostream>
+
+using namespace QInstaller;
+using namespace QInstallerTools;
+
+// Packages the components of the given package directories into a new repository once for
+// each number of jobs, and prints the wall time of each run.
+
+static QList<int> parseList(const QString &value)
+{
+    QList<int> result;
+    foreach (const QString &item, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        bool ok = false;
+        result.append(item.toInt(&ok));
+        if (!ok || result.last() < 0)
+            throw Error(QString::fromLatin1("Invalid value \"%1\".").arg(item));
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption jobs(QLatin1String("jobs"),
+        QLatin1String("Comma-separated numbers of jobs to compare, 0 for all cores. Defaults to 1,0."),
+        QLatin1String("n,..."), QLatin1String("1,0"));
+    const QCommandLineOption level(QLatin1String("compression"),
+        QLatin1String("Compression level. Defaults to 5."), QLatin1String("level"),
+        QLatin1String("5"));
+    parser.addOption(jobs);
+    parser.addOption(level);
+    parser.addPositionalArgument(QLatin1String("packages"),
+        QLatin1String("Package directories as passed to repogen."));
+    parser.process(app);
+
+    const QStringList packageDirs = parser.positionalArguments();
+    if (packageDirs.isEmpty())
+        parser.showHelp(EXIT_FAILURE);
+
+    try {
+        Lib7z::initSevenZ();
+
+        QStringList filteredPackages;
+        const PackageInfoVector packages = createListOfPackages(packageDirs, &filteredPackages,
+            Exclude);
+        std::cout << "Input: " << packages.count() << " components" << std::endl;
+        std::cout << "jobs\tms" << std::endl;
+
+        foreach (const int jobCount, parseList(parser.value(jobs))) {
+            QTemporaryDir repositoryDir;
+            PackageInfoVector infos = packages;
+
+            QElapsedTimer timer;
+            timer.start();
+            RepositoryOptions options;
+            options.compression = Compression(parser.value(level).toInt());
+            options.jobs = jobCount;
+            copyComponentData(packageDirs, repositoryDir.path(), &infos, options);
+            const qint64 elapsed = timer.elapsed();
+
+            std::cout << (jobCount > 0 ? jobCount : QThread::idealThreadCount()) << '\t' << elapsed
+                << std::endl;
+        }
+    } catch (const Error &e) {
+        std::cerr << e.message() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -2,4 +2,8 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
         auto \
+        compressionbenchmark \
+        copybenchmark \
+        hashbenchmark \
+        packagingbenchmark \
         downloadspeed
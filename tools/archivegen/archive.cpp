@@ -72,9 +72,24 @@ int main(int argc, char *argv[])
                 "Note: some formats do not support all the possible values, "
                 "for example bzip2 compression only supports values from 1 to 9."
             ), QLatin1String("5"), QLatin1String("5"));
+        const QCommandLineOption threads = QCommandLineOption(QStringList()
+            << QLatin1String("t") << QLatin1String("threads"),
+            QCoreApplication::translate("archivegen",
+                "Number of threads used for compressing. Defaults to the number of processor "
+                "cores. Note: not all formats support parallel compression."
+            ), QLatin1String("threads"));
+        const QCommandLineOption solidBlockSize = QCommandLineOption(QStringList()
+            << QLatin1String("s") << QLatin1String("solid-block-size"),
+            QCoreApplication::translate("archivegen",
+                "Maximum size of a solid block in megabytes, 0 creates a non-solid archive. "
+                "Smaller blocks can be extracted in parallel, at the cost of a worse "
+                "compression ratio. Only supported by the 7z format."
+            ), QLatin1String("MB"));
 
         parser.addOption(format);
         parser.addOption(compression);
+        parser.addOption(threads);
+        parser.addOption(solidBlockSize);
         parser.addPositionalArgument(QLatin1String("archive"),
             QCoreApplication::translate("archivegen", "Compressed archive to create."));
         parser.addPositionalArgument(QLatin1String("sources"),
@@ -106,6 +121,27 @@ int main(int argc, char *argv[])
                 "Unknown compression level \"%1\". See 'archivgen --help'.").arg(value));
         }
 
+        int threadCount = 0;
+        if (parser.isSet(threads)) {
+            threadCount = parser.value(threads).toInt(&ok);
+            if (!ok || threadCount < 1) {
+                throw QInstaller::Error(QCoreApplication::translate("archivegen",
+                    "Invalid number of threads \"%1\". See 'archivgen --help'.")
+                    .arg(parser.value(threads)));
+            }
+        }
+
+        qint64 blockSize = 0;
+        if (parser.isSet(solidBlockSize)) {
+            const qint64 megabytes = parser.value(solidBlockSize).toLongLong(&ok);
+            if (!ok || megabytes < 0) {
+                throw QInstaller::Error(QCoreApplication::translate("archivegen",
+                    "Invalid solid block size \"%1\". See 'archivgen --help'.")
+                    .arg(parser.value(solidBlockSize)));
+            }
+            blockSize = megabytes > 0 ? megabytes * 1024 * 1024 : -1;
+        }
+
         Lib7z::initSevenZ();
         QString archiveFilename = args[0];
         // Check if filename already has a supported suffix
@@ -118,6 +154,8 @@ int main(int argc, char *argv[])
                 "object for archive \"%1\": \"%2\".").arg(archiveFilename, QLatin1String(Q_FUNC_INFO)));
         }
         archive->setCompressionLevel(AbstractArchive::CompressionLevel(value));
+        archive->setCompressionThreads(threadCount);
+        archive->setSolidBlockSize(blockSize);
         if (archive->open(QIODevice::WriteOnly) && archive->create(args.mid(1)))
             return EXIT_SUCCESS;
 
@@ -75,11 +75,36 @@ static void printUsage()
     std::cout << "                            download phase." << std::endl;
 
     std::cout << "  --component-metadata      Creates one metadata 7z per component. " << std::endl;
+    std::cout << "  --append-metadata         When updating a repository with united metadata, stores the" << std::endl;
+    std::cout << "                            metadata of the updated components in an additional 7z instead" << std::endl;
+    std::cout << "                            of recreating the united metadata 7z." << std::endl;
+    std::cout << "  --metadata-chunk-size KB  Splits the united metadata into 7z chunks of about the given size in" << std::endl;
+    std::cout << "                            kilobytes, so installers download and extract them in parallel and" << std::endl;
+    std::cout << "                            updaters skip the chunks without installed components." << std::endl;
     std::cout << "  --af|--archive-format " << archiveFormats << std::endl;
     std::cout << "                            Set the format used when packaging new component data archives. If" << std::endl;
     std::cout << "                            you omit this option the 7z format will be used as a default." << std::endl;
     std::cout << "  --ac|--compression 0,1,3,5,7,9" << std::endl;
     std::cout << "                            Sets the compression level used when packaging new data archives." << std::endl;
+    std::cout << "  --compression-threads n   Sets the number of threads used when packaging new data archives." << std::endl;
+    std::cout << "                            Defaults to the number of processor cores." << std::endl;
+    std::cout << "  --solid-block-size MB     Limits the solid blocks of new 7z data archives to the given size in" << std::endl;
+    std::cout << "                            megabytes, 0 creates non-solid archives. Smaller blocks can be" << std::endl;
+    std::cout << "                            extracted in parallel, at the cost of a worse compression ratio." << std::endl;
+    std::cout << "  -j|--jobs n               Sets the number of components packaged at the same time. Defaults" << std::endl;
+    std::cout << "                            to 1, 0 uses one job per processor core." << std::endl;
+    std::cout << "  --cache-dir dir           Keeps the archives created for each component in the given directory" << std::endl;
+    std::cout << "                            and reuses them in later runs if the component did not change." << std::endl;
+    std::cout << "  --chunk-manifests         Creates a chunk manifest for each component archive and stores the" << std::endl;
+    std::cout << "                            chunks of their content in the repository, so maintenance tools only" << std::endl;
+    std::cout << "                            download the changed parts of updated components." << std::endl;
+    std::cout << "  --delta-patches           When updating a repository, creates a patch from the replaced version" << std::endl;
+    std::cout << "                            of each updated component archive, so maintenance tools with that" << std::endl;
+    std::cout << "                            version installed only download the binary changes." << std::endl;
+    std::cout << "  --checksum-type sha1|sha256" << std::endl;
+    std::cout << "                            Sets the hash algorithm used for the checksums of archives and" << std::endl;
+    std::cout << "                            metadata. Defaults to sha1. An existing repository can only be" << std::endl;
+    std::cout << "                            updated with the checksum type it was created with." << std::endl;
 
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
@@ -112,10 +137,8 @@ int main(int argc, char** argv)
         QInstallerTools::FilterType filterType = QInstallerTools::Exclude;
         bool remove = false;
         bool updateExistingRepositoryWithNewComponents = false;
-        bool createUnifiedMetadata = true;
-        bool createComponentMetadata = true;
-        QString archiveSuffix = QLatin1String("7z");
-        AbstractArchive::CompressionLevel compression = AbstractArchive::Normal;
+        QInstallerTools::RepositoryOptions options;
+        bool createDeltaPatches = false;
 
         //TODO: use a for loop without removing values from args like it is in binarycreator.cpp
         //for (QStringList::const_iterator it = args.begin(); it != args.end(); ++it) {
@@ -160,7 +183,7 @@ int main(int argc, char** argv)
             } else if (args.first() == QLatin1String("--update-new-components")) {
                 args.removeFirst();
                 updateExistingRepositoryWithNewComponents = true;
-                createUnifiedMetadata = false;
+                options.createUnifiedMetadata = false;
             } else if (args.first() == QLatin1String("-p") || args.first() == QLatin1String("--packages")) {
                 args.removeFirst();
                 if (args.isEmpty()) {
@@ -199,10 +222,27 @@ int main(int argc, char** argv)
                 remove = true;
                 args.removeFirst();
             } else if (args.first() == QLatin1String("--unite-metadata")) {
-                createComponentMetadata = false;
+                options.createComponentMetadata = false;
                 args.removeFirst();
             } else if (args.first() == QLatin1String("--component-metadata")) {
-                createUnifiedMetadata = false;
+                options.createUnifiedMetadata = false;
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--append-metadata")) {
+                options.appendUnifiedMetadata = true;
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--metadata-chunk-size")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Metadata chunk size parameter missing argument"));
+                }
+                bool ok = false;
+                const qint64 kilobytes = args.first().toLongLong(&ok);
+                if (!ok || kilobytes < 1) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid metadata chunk size \"%1\".").arg(args.first()));
+                }
+                options.metadataChunkSize = kilobytes * 1024;
                 args.removeFirst();
             } else if (args.first() == QLatin1String("--sha-update") || args.first() == QLatin1String("-s")) {
                 args.removeFirst();
@@ -215,7 +255,7 @@ int main(int argc, char** argv)
                         "Error: Archive format parameter missing argument"));
                 }
                 // TODO: do we need early check for supported formats?
-                archiveSuffix = args.first();
+                options.archiveSuffix = args.first();
                 args.removeFirst();
             } else if (args.first() == QLatin1String("--ac") || args.first() == QLatin1String("--compression")) {
                 args.removeFirst();
@@ -230,7 +270,72 @@ int main(int argc, char** argv)
                     return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
                         "Error: Unknown compression level \"%1\".").arg(value));
                 }
-                compression = static_cast<AbstractArchive::CompressionLevel>(value);
+                options.compression = static_cast<AbstractArchive::CompressionLevel>(value);
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--compression-threads")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Compression threads parameter missing argument"));
+                }
+                bool ok = false;
+                options.compressionThreads = args.first().toInt(&ok);
+                if (!ok || options.compressionThreads < 1) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid number of compression threads \"%1\".").arg(args.first()));
+                }
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--solid-block-size")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Solid block size parameter missing argument"));
+                }
+                bool ok = false;
+                const qint64 megabytes = args.first().toLongLong(&ok);
+                if (!ok || megabytes < 0) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid solid block size \"%1\".").arg(args.first()));
+                }
+                options.solidBlockSize = megabytes > 0 ? megabytes * 1024 * 1024 : -1;
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--jobs") || args.first() == QLatin1String("-j")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Jobs parameter missing argument"));
+                }
+                bool ok = false;
+                options.jobs = args.first().toInt(&ok);
+                if (!ok || options.jobs < 0) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid number of jobs \"%1\".").arg(args.first()));
+                }
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--cache-dir")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Cache directory parameter missing argument"));
+                }
+                options.cacheDirectory = QInstallerTools::makePathAbsolute(args.first());
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--chunk-manifests")) {
+                options.createChunkManifests = true;
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--delta-patches")) {
+                createDeltaPatches = true;
+                args.removeFirst();
+            } else if (args.first() == QLatin1String("--checksum-type")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Checksum type parameter missing argument"));
+                }
+                if (!QInstaller::checksumAlgorithmFromName(args.first(), &options.checksumAlgorithm)) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Unknown checksum type \"%1\".").arg(args.first()));
+                }
                 args.removeFirst();
             } else {
                 printUsage();
@@ -253,6 +358,11 @@ int main(int argc, char** argv)
         if (remove)
             QInstaller::removeDirectory(repoInfo.repositoryDir);
 
+        if (createDeltaPatches && !update) {
+            throw QInstaller::Error(QCoreApplication::translate("QInstaller",
+                "Argument --delta-patches requires --update or --update-new-components!"));
+        }
+
         if (updateExistingRepositoryWithNewComponents) {
             QStringList meta7z = QDir(repoInfo.repositoryDir).entryList(QStringList()
                 << QLatin1String("*_meta.7z"), QDir::Files);
@@ -271,8 +381,16 @@ int main(int argc, char** argv)
                 "Repository target directory \"%1\" already exists.").arg(QDir::toNativeSeparators(repoInfo.repositoryDir)));
         }
 
+        // the replaced versions of updated components are moved there, so it is kept next to them
+        QScopedPointer<QTemporaryDir> previousPackages;
+        if (createDeltaPatches)
+            previousPackages.reset(new QTemporaryDir(repoInfo.repositoryDir + QLatin1String("/.previous-XXXXXX")));
+        const QString previousPackagesDir = (previousPackages && previousPackages->isValid())
+            ? previousPackages->path() : QString();
+
         QInstallerTools::PackageInfoVector packages = QInstallerTools::collectPackages(repoInfo,
-            &filteredPackages, filterType, updateExistingRepositoryWithNewComponents, packagesUpdatedWithSha);
+            &filteredPackages, filterType, updateExistingRepositoryWithNewComponents, packagesUpdatedWithSha,
+            previousPackagesDir);
         if (packages.isEmpty()) {
             std::cout << QString::fromLatin1("Cannot find components to update \"%1\".")
                 .arg(repoInfo.repositoryDir) << std::endl;
@@ -282,8 +400,8 @@ int main(int argc, char** argv)
         QTemporaryDir tmp;
         tmp.setAutoRemove(false);
         tmpMetaDir = tmp.path();
-        QInstallerTools::createRepository(repoInfo, &packages, tmpMetaDir,
-            createComponentMetadata, createUnifiedMetadata, archiveSuffix, compression);
+        options.previousPackagesDir = previousPackagesDir;
+        QInstallerTools::createRepository(repoInfo, &packages, tmpMetaDir, options);
 
         exitCode = EXIT_SUCCESS;
     } catch (const QInstaller::Error &e) {